@@ -0,0 +1,31 @@
+#version 330 core
+#define MATERIAL_COUNT 4
+
+out vec4 FragColor;
+
+in vec3 Normal;
+in vec3 FragPos;
+in vec4 Color;
+flat in uint Material;
+
+uniform vec3 viewPos;
+uniform vec3 lightDirection;
+
+// Specular intensity in rgb, shininess in w
+uniform vec4 materials[MATERIAL_COUNT];
+
+void main()
+{
+    vec4 material = materials[Material];
+
+    vec3 norm = normalize(Normal);
+    vec3 lightDir = normalize(-lightDirection);
+    float diff = max(dot(norm, lightDir), 0.0);
+
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 halfway = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(norm, halfway), 0.0), material.w);
+
+    vec3 result = Color.rgb * (0.15 + 0.85 * diff) + material.rgb * spec;
+    FragColor = vec4(result, Color.a);
+}
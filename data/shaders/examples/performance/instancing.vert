@@ -0,0 +1,27 @@
+#version 330 core
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec3 aNormal;
+
+// Per instance, see glf::instance_m4fc4fu1
+layout (location = 8) in mat4 aTransform;
+layout (location = 12) in vec4 aColor;
+layout (location = 13) in uint aMaterial;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 Normal;
+out vec3 FragPos;
+out vec4 Color;
+flat out uint Material;
+
+void main()
+{
+    vec4 worldPosition = aTransform * vec4(aPosition, 1.0);
+    gl_Position = projection * view * worldPosition;
+    // Rotations and translations only, the normal matrix is the rotation itself
+    Normal = mat3(aTransform) * aNormal;
+    FragPos = worldPosition.xyz;
+    Color = aColor;
+    Material = aMaterial;
+}
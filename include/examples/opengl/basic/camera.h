@@ -10,6 +10,7 @@
 
 #include <glm/glm.hpp>
 #include <iostream>
+#include <set>
 #include <vector>
 
 #include "framework/opengl/buffermanager.h"
@@ -31,6 +32,7 @@ namespace OpenGLExamples {
         TextureManager textureManager;
         ShaderManager shaderManager;
         ProgramManager programManager;
+        Compiler compiler;
         VAOManager<glf::vertex_v3fv2f> vaoManager;
 
         std::vector<glm::vec3> cubePositions;
@@ -44,12 +46,24 @@ namespace OpenGLExamples {
             glm::vec3(cos(glm::radians(pitch)) * cos(glm::radians(yaw)), sin(glm::radians(pitch)), cos(glm::radians(pitch)) * sin(glm::radians(yaw)));
         glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 3.0f);
 
+        // Handles resolved once in initHandles()
+        HandleRef<float> mix;
+        HandleRef<float> fov;
+        HandleRef<float> nearPlane;
+        HandleRef<float> farPlane;
+        HandleRef<float> cameraSpeed;
+        HandleRef<float> cameraSensitivity;
+
         void createCube();
 
       protected:
+        virtual void createPrograms();
+
+        virtual bool checkPrograms();
+
         void initHandles();
 
-        void initProgram();
+        void resolveHandles();
 
         void initBuffer();
 
@@ -72,6 +86,12 @@ namespace OpenGLExamples {
 
         /* Returns a texture as a ImTextureID pointer for ImGui to render to a renderview */
         virtual void render(int actualRenderWidth, int actualRenderHeight);
+
+        /* Relinks the programs built from one of the modified shader files */
+        virtual bool reloadShaders(const std::set<std::string> &files);
+
+        /* True if one of the shaders of the view was preprocessed from one of the files */
+        virtual bool usesShaderFiles(const std::set<std::string> &files);
     };
 } // namespace OpenGLExamples
 
@@ -10,6 +10,7 @@
 
 #include <glm/glm.hpp>
 #include <iostream>
+#include <set>
 #include <vector>
 
 #include "framework/opengl/buffermanager.h"
@@ -31,15 +32,31 @@ namespace OpenGLExamples {
         TextureManager textureManager;
         ShaderManager shaderManager;
         ProgramManager programManager;
+        Compiler compiler;
         VAOManager<glf::vertex_v3fv2f> vaoManager;
         std::vector<glm::vec3> cubePositions;
 
+        // Handles resolved once in initHandles()
+        HandleRef<float> mix;
+        HandleRef<bool> perspective;
+        HandleRef<float> fov;
+        HandleRef<float> left;
+        HandleRef<float> right;
+        HandleRef<float> bottom;
+        HandleRef<float> top;
+        HandleRef<float> nearPlane;
+        HandleRef<float> farPlane;
+
         void createCube();
 
       protected:
+        virtual void createPrograms();
+
+        virtual bool checkPrograms();
+
         void initHandles();
 
-        void initProgram();
+        void resolveHandles();
 
         void initBuffer();
 
@@ -62,6 +79,12 @@ namespace OpenGLExamples {
 
         /* Returns a texture as a ImTextureID pointer for ImGui to render to a renderview */
         virtual void render(int actualRenderWidth, int actualRenderHeight);
+
+        /* Relinks the programs built from one of the modified shader files */
+        virtual bool reloadShaders(const std::set<std::string> &files);
+
+        /* True if one of the shaders of the view was preprocessed from one of the files */
+        virtual bool usesShaderFiles(const std::set<std::string> &files);
     };
 } // namespace OpenGLExamples
 
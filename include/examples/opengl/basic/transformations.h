@@ -10,6 +10,7 @@
 
 #include <glm/glm.hpp>
 #include <iostream>
+#include <set>
 #include <vector>
 
 #include "framework/opengl/buffermanager.h"
@@ -31,13 +32,21 @@ namespace OpenGLExamples {
         TextureManager textureManager;
         ShaderManager shaderManager;
         ProgramManager programManager;
+        Compiler compiler;
         VAOManager<glf::vertex_v3fv2f> vaoManager;
         EBOManager eboManager;
 
+        // Handles resolved once in initHandles()
+        HandleRef<float> mix;
+
       protected:
+        virtual void createPrograms();
+
+        virtual bool checkPrograms();
+
         void initHandles();
 
-        void initProgram();
+        void resolveHandles();
 
         void initBuffer();
 
@@ -60,6 +69,12 @@ namespace OpenGLExamples {
 
         /* Returns a texture as a ImTextureID pointer for ImGui to render to a renderview */
         virtual void render(int actualRenderWidth, int actualRenderHeight);
+
+        /* Relinks the programs built from one of the modified shader files */
+        virtual bool reloadShaders(const std::set<std::string> &files);
+
+        /* True if one of the shaders of the view was preprocessed from one of the files */
+        virtual bool usesShaderFiles(const std::set<std::string> &files);
     };
 } // namespace OpenGLExamples
 
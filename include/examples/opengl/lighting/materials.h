@@ -10,6 +10,7 @@
 
 #include <glm/glm.hpp>
 #include <iostream>
+#include <set>
 #include <vector>
 
 #include "framework/opengl/buffermanager.h"
@@ -20,6 +21,7 @@
 #include "framework/opengl/texturemanager.h"
 #include "framework/opengl/vaomanager.h"
 #include "framework/opengl/vertex.h"
+#include "framework/scenegraph.h"
 
 namespace OpenGLExamples {
 
@@ -31,13 +33,19 @@ namespace OpenGLExamples {
         TextureManager textureManager;
         ShaderManager shaderManager;
         ProgramManager programManager;
-        VAOManager<glf::vertex_v3fv3f> vaoCube;
+        Compiler compiler;
+        VAOManager<glf::vertex_v3fn3f> vaoCube;
 
-        VAOManager<glf::vertex_v3fv3f> vaoLight;
+        VAOManager<glf::vertex_v3fn3f> vaoLight;
 
-        VAOManager<glf::vertex_v3fv3f> vaoGrid;
+        VAOManager<glf::vertex_v3fc3f> vaoGrid;
         EBOManager eboGrid;
 
+        // Model and normal matrices of the objects, only the light moves
+        SceneGraph scene;
+        SceneGraph::Node cubeNode, lightNode, gridNode;
+        glm::vec3 lightNodePosition;
+
         // Camera variables
         float yaw = -35.0f;
         float pitch = -15.0f;
@@ -47,15 +55,51 @@ namespace OpenGLExamples {
             glm::vec3(cos(glm::radians(pitch)) * cos(glm::radians(yaw)), sin(glm::radians(pitch)), cos(glm::radians(pitch)) * sin(glm::radians(yaw)));
         glm::vec3 cameraPos = glm::vec3(-4.0f, 1.5f, 4.0f);
 
-        void createCube(VAOManager<glf::vertex_v3fv3f> &vaoManager);
+        // Handles resolved once in initHandles()
+        HandleRef<glm::vec3> lightPosition;
+        HandleRef<glm::vec3> lightAmbientColor;
+        HandleRef<glm::vec3> lightDiffuseColor;
+        HandleRef<glm::vec3> lightSpecularColor;
+        HandleRef<glm::vec3> ambientColor;
+        HandleRef<glm::vec3> diffuseColor;
+        HandleRef<glm::vec3> specularColor;
+        HandleRef<float> shininess;
+        HandleRef<float> fov;
+        HandleRef<float> nearPlane;
+        HandleRef<float> farPlane;
+        HandleRef<float> cameraSpeed;
+        HandleRef<float> cameraSensitivity;
+
+        // Uniforms resolved once the programs are linked
+        struct CubeUniforms {
+            Uniform materialAmbient, materialDiffuse, materialSpecular, materialShininess;
+            Uniform lightPosition, lightAmbient, lightDiffuse, lightSpecular;
+            Uniform viewPos, view, projection, model, normalMatrix;
+        } cubeUniforms;
+
+        struct LightUniforms {
+            Uniform lightColor, view, projection, model;
+        } lightUniforms;
+
+        struct GridUniforms {
+            Uniform view, projection, model;
+        } gridUniforms;
+
+        void createCube(VAOManager<glf::vertex_v3fn3f> &vaoManager);
         void createGrid(int size);
 
         void setCameraView();
 
+        void resolveHandles();
+
+        void resolveUniforms();
+
       protected:
-        void initHandles();
+        virtual void createPrograms();
 
-        void initProgram();
+        virtual bool checkPrograms();
+
+        void initHandles();
 
         void initBuffer();
 
@@ -78,6 +122,12 @@ namespace OpenGLExamples {
 
         /* Returns a texture as a ImTextureID pointer for ImGui to render to a renderview */
         virtual void render(int actualRenderWidth, int actualRenderHeight);
+
+        /* Relinks the programs built from one of the modified shader files */
+        virtual bool reloadShaders(const std::set<std::string> &files);
+
+        /* True if one of the shaders of the view was preprocessed from one of the files */
+        virtual bool usesShaderFiles(const std::set<std::string> &files);
     };
 } // namespace OpenGLExamples
 
@@ -0,0 +1,111 @@
+#pragma once
+
+#ifndef INSTANCING_H
+#define INSTANCING_H
+
+#include "qulkan/render_view.h"
+
+#include <GL/gl3w.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <set>
+#include <vector>
+
+#include "framework/lattice.h"
+#include "framework/opengl/buffermanager.h"
+#include "framework/opengl/ebomanager.h"
+#include "framework/opengl/gpuculling.h"
+#include "framework/opengl/instancerenderer.h"
+#include "framework/opengl/programmanager.h"
+#include "framework/opengl/shadermanager.h"
+#include "framework/opengl/vaomanager.h"
+#include "framework/opengl/vertex.h"
+
+namespace OpenGLExamples {
+
+    /*! \brief Stress test of the instanced draws, from a thousand to a million lit cubes in one draw call
+     *
+     *  The transforms are recomputed on the CPU every frame and written straight into the instance buffer, so the view measures
+     *  both the per-instance CPU cost and the GPU vertex throughput. The headless mode registers it once per instance count
+     *  (instancing1k to instancing1m) to track the scaling between releases. With "GPU Culling" the instances outside of the
+     *  frustum are removed by a compute shader before the draw, on contexts supporting it.
+     */
+    class Instancing : public Qulkan::RenderView {
+
+      private:
+        static const int MATERIAL_COUNT = 4;
+
+        BufferManager bufferManager;
+        ShaderManager shaderManager;
+        ProgramManager programManager;
+        Compiler compiler;
+        VAOManager<glf::vertex_v3fn3f> vaoCube;
+        EBOManager eboCube;
+
+        InstanceRenderer instanceRenderer;
+        GPUCulling culling;
+        int initialInstanceCount;
+        GLsizei instanceCount;
+
+        // Orbiting the lattice
+        OrbitCamera camera;
+
+        // Handles resolved once in initHandles()
+        HandleRef<float> instancesLog10;
+        HandleRef<bool> animate;
+        HandleRef<bool> gpuCulling;
+        HandleRef<float> fov;
+        HandleRef<float> cameraSensitivity;
+
+        // Uniforms resolved once the program is linked
+        struct CubeUniforms {
+            Uniform view, projection, viewPos, lightDirection;
+            GLint materials; // Array, uploaded whole after every link
+        } cubeUniforms;
+
+        void createCube();
+
+        void resizeInstances();
+
+        void writeInstances(InstanceRenderer::Range const &range, float time);
+
+        void resolveHandles();
+
+        void resolveUniforms();
+
+      protected:
+        virtual void createPrograms();
+
+        virtual bool checkPrograms();
+
+        void initHandles();
+
+        void initBuffer();
+
+        void initVertexArray();
+
+        void initOpenGLOptions();
+
+        void clean();
+
+      public:
+        Instancing(const char *viewName = "OpenGL Example: Instancing", int initialRenderWidth = 1920, int initialRenderHeight = 1080,
+                   int initialInstanceCount = 10000);
+        virtual ~Instancing() { clean(); }
+
+        /* Inits an OpenGL view */
+        virtual void init();
+
+        /* Renders every instance with a single glDrawElementsInstanced, or the visible ones with a glDrawElementsIndirect */
+        virtual void render(int actualRenderWidth, int actualRenderHeight);
+
+        /* Relinks the programs built from one of the modified shader files */
+        virtual bool reloadShaders(const std::set<std::string> &files);
+
+        /* True if one of the shaders of the view was preprocessed from one of the files */
+        virtual bool usesShaderFiles(const std::set<std::string> &files);
+    };
+} // namespace OpenGLExamples
+
+#endif
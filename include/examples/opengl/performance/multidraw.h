@@ -0,0 +1,112 @@
+#pragma once
+
+#ifndef MULTIDRAW_H
+#define MULTIDRAW_H
+
+#include "qulkan/render_view.h"
+
+#include <GL/gl3w.h>
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <set>
+#include <vector>
+
+#include "framework/frustumculler.h"
+#include "framework/lattice.h"
+#include "framework/meshloader.h"
+#include "framework/opengl/geometryarena.h"
+#include "framework/opengl/instancerenderer.h"
+#include "framework/opengl/multidrawbatch.h"
+#include "framework/opengl/programmanager.h"
+#include "framework/opengl/shadermanager.h"
+#include "framework/opengl/vertex.h"
+
+namespace OpenGLExamples {
+
+    /*! \brief Thousands of distinct meshes packed in one GeometryArena, drawn with one multi-draw per material
+     *
+     *  Every object has its own procedurally generated mesh (rounded boxes of random extents and tessellations) and its own
+     *  transform in the instance buffer, every few objects are one of the models of data/models imported by the MeshLoader instead. The "Batched" handle switches to one draw per object for comparison, which is how the
+     *  other examples draw their meshes. With "CPU Culling" only the objects whose box intersects the frustum are submitted, the
+     *  boxes follow the objects through the refit of a FrustumCuller hierarchy.
+     */
+    class MultiDraw : public Qulkan::RenderView {
+
+      private:
+        static const int MATERIAL_COUNT = 4;
+
+        ShaderManager shaderManager;
+        ProgramManager programManager;
+        Compiler compiler;
+
+        GeometryArena<glf::vertex_v3fn3f> arena;
+        std::vector<Mesh> models; // Centered and scaled to fit in [-1, 1]
+        std::vector<ArenaMesh> meshes; // One per object
+        std::vector<BoundingBox> meshBounds;
+        MultiDrawBatch batch;
+        InstanceRenderer instanceRenderer;
+        int objectCount;
+
+        FrustumCuller culler;
+        std::vector<std::uint32_t> visibleObjects;
+
+        // Orbiting the objects
+        OrbitCamera camera;
+
+        // Handles resolved once in initHandles()
+        HandleRef<bool> batched;
+        HandleRef<bool> animate;
+        HandleRef<bool> cpuCulling;
+        HandleRef<float> fov;
+        HandleRef<float> cameraSensitivity;
+
+        // Uniforms resolved once the program is linked
+        struct ObjectUniforms {
+            Uniform view, projection, viewPos, lightDirection;
+            GLint materials; // Array, uploaded whole after every link
+        } objectUniforms;
+
+        void loadModels();
+
+        void createMeshes();
+
+        void writeInstances(InstanceRenderer::Range const &range, float time);
+
+        void resolveHandles();
+
+        void resolveUniforms();
+
+      protected:
+        virtual void createPrograms();
+
+        virtual bool checkPrograms();
+
+        void initHandles();
+
+        void initBuffer();
+
+        void initOpenGLOptions();
+
+        void clean();
+
+      public:
+        MultiDraw(const char *viewName = "OpenGL Example: MultiDraw", int initialRenderWidth = 1920, int initialRenderHeight = 1080, int objectCount = 4096);
+        virtual ~MultiDraw() { clean(); }
+
+        /* Inits an OpenGL view */
+        virtual void init();
+
+        /* Renders every (visible) object, with one draw call per material when batched */
+        virtual void render(int actualRenderWidth, int actualRenderHeight);
+
+        /* Relinks the programs built from one of the modified shader files */
+        virtual bool reloadShaders(const std::set<std::string> &files);
+
+        /* True if one of the shaders of the view was preprocessed from one of the files */
+        virtual bool usesShaderFiles(const std::set<std::string> &files);
+    };
+} // namespace OpenGLExamples
+
+#endif
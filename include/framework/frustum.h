@@ -0,0 +1,45 @@
+#pragma once
+
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+/*! \brief The six planes of a view frustum, extracted from a projection * view matrix (Gribb and Hartmann)
+ *
+ *  The planes are normalized and their normals point inside, a point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0.
+ *  With the model matrix included the planes are in the space of the model.
+ */
+struct Frustum {
+    enum { PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+
+    glm::vec4 planes[PLANE_COUNT];
+
+    static Frustum fromMatrix(glm::mat4 const &viewProjection) {
+        // Rows of the matrix, glm matrices are column major
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; ++i)
+            rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+        Frustum frustum;
+        frustum.planes[PLANE_LEFT] = rows[3] + rows[0];
+        frustum.planes[PLANE_RIGHT] = rows[3] - rows[0];
+        frustum.planes[PLANE_BOTTOM] = rows[3] + rows[1];
+        frustum.planes[PLANE_TOP] = rows[3] - rows[1];
+        frustum.planes[PLANE_NEAR] = rows[3] + rows[2];
+        frustum.planes[PLANE_FAR] = rows[3] - rows[2];
+        for (glm::vec4 &plane : frustum.planes)
+            plane /= glm::length(glm::vec3(plane));
+        return frustum;
+    }
+
+    /* Conservative, a sphere outside of the frustum but not of any single plane is kept */
+    bool intersectsSphere(glm::vec3 const &center, float radius) const {
+        for (glm::vec4 const &plane : planes)
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                return false;
+        return true;
+    }
+};
+
+#endif
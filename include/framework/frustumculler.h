@@ -0,0 +1,131 @@
+#pragma once
+
+#ifndef FRUSTUMCULLER_H
+#define FRUSTUMCULLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "framework/frustum.h"
+
+/*! \brief Axis aligned bounding box */
+struct BoundingBox {
+    glm::vec3 min;
+    glm::vec3 max;
+
+    BoundingBox() : min(0.0f), max(0.0f) {}
+    BoundingBox(glm::vec3 const &min, glm::vec3 const &max) : min(min), max(max) {}
+
+    glm::vec3 center() const { return 0.5f * (min + max); }
+    glm::vec3 extent() const { return 0.5f * (max - min); }
+
+    /* Box around the transformed box (Arvo), tight for rotations and translations of a centered box */
+    BoundingBox transformed(glm::mat4 const &transform) const {
+        glm::vec3 center = glm::vec3(transform * glm::vec4(this->center(), 1.0f));
+        glm::vec3 extent = glm::abs(glm::vec3(transform[0])) * this->extent().x + glm::abs(glm::vec3(transform[1])) * this->extent().y +
+                           glm::abs(glm::vec3(transform[2])) * this->extent().z;
+        return BoundingBox(center - extent, center + extent);
+    }
+};
+
+/*! \brief CPU frustum culling of many boxes, for the views drawing without compute shaders
+ *
+ *  The boxes are kept as centers and extents in separate arrays (structure of arrays), ordered by the leaves of a bounding volume
+ *  hierarchy built with binned surface area heuristic splits. A traversal skips the subtrees outside of a plane, stops testing
+ *  the planes a subtree is fully inside of, and tests the boxes of a leaf 8 (AVX) or 4 (SSE) at a time against the remaining
+ *  planes. Above PARALLEL_THRESHOLD boxes the top of the tree is split into subtrees traversed by the OpenMP threads.
+ *
+ *  Moving a box refits the boxes of the nodes above it on the next cull(), the tree itself is only rebuilt by build() or after
+ *  boxes were added. Refitting keeps the culling correct but not the tree quality, objects moving far away call for a rebuild.
+ *
+ *       std::uint32_t rock = culler.add(rockBounds.transformed(rockTransform));
+ *       ...
+ *       culler.set(rock, rockBounds.transformed(rockTransform)); // from any thread, one thread per object
+ *       culler.cull(Frustum::fromMatrix(projection * view), visible);
+ *       for (std::uint32_t object : visible)
+ *           batch.add(materials[object], meshes[object], 1, object);
+ */
+class FrustumCuller {
+  public:
+    static const std::uint32_t LEAF_SIZE = 8;
+    static const std::size_t PARALLEL_THRESHOLD = 16384;
+
+    FrustumCuller();
+
+    void clear();
+
+    /* Returns the index of the object, given in the visible lists */
+    std::uint32_t add(BoundingBox const &box);
+
+    /* Moves the box of an object, the objects can be set concurrently */
+    void set(std::uint32_t object, BoundingBox const &box);
+
+    /* Rebuilds the hierarchy over the current boxes, done by the first cull() after an add() */
+    void build();
+
+    /* Updates the nodes above the moved boxes, done by every cull() */
+    void refit();
+
+    /* Replaces visible by the objects whose box intersects the frustum, in no particular order. Returns their count */
+    std::size_t cull(Frustum const &frustum, std::vector<std::uint32_t> &visible);
+
+    std::size_t getObjectCount() const { return slotObjects.size(); }
+    std::size_t getNodeCount() const { return nodes.size(); }
+
+    /* "AVX", "SSE" or "scalar", the box tests compiled in */
+    static char const *instructionSet();
+
+  private:
+    /* The left child of a node follows it, so that the children come after their parents and the subtree of a node covers a
+     * contiguous range of slots */
+    struct Node {
+        glm::vec3 center;
+        glm::vec3 extent;
+        std::uint32_t rightChild; // 0 for a leaf
+        std::uint32_t firstSlot;
+        std::uint32_t slotCount;
+    };
+
+    struct BuildItem {
+        glm::vec3 center;
+        glm::vec3 extent;
+        std::uint32_t object;
+    };
+
+    struct Task {
+        std::uint32_t node;
+        unsigned planeMask; // Planes the node is not known to be inside of
+    };
+
+    struct Planes;
+
+    // Boxes by slot, padded for the vector loads past the last leaf
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<std::uint8_t> moved;
+
+    std::vector<std::uint32_t> slotObjects;
+    std::vector<std::uint32_t> objectSlots;
+
+    std::vector<Node> nodes;
+    std::vector<std::uint8_t> nodeMoved;
+    bool built;
+
+    std::vector<Task> tasks;
+    std::vector<std::vector<std::uint32_t>> taskVisible;
+
+    void resizeSlots(std::size_t count);
+    void setSlot(std::uint32_t slot, glm::vec3 const &center, glm::vec3 const &extent);
+
+    std::uint32_t buildNode(std::vector<BuildItem> &items, std::size_t begin, std::size_t end);
+    void fitLeaf(Node &node) const;
+
+    static bool testNode(Planes const &planes, Node const &node, unsigned &planeMask);
+    void testLeaf(Planes const &planes, Node const &node, unsigned planeMask, std::vector<std::uint32_t> &visible) const;
+    void traverse(Planes const &planes, Task root, std::vector<std::uint32_t> &visible) const;
+};
+
+#endif
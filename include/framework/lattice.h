@@ -0,0 +1,66 @@
+#pragma once
+
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+/*! \brief Cubic lattice of objects centered on the origin, the layout of the performance examples
+ *
+ *  The objects fill the lattice x first, then y and z. Every object gets a phase hashed from its index to vary its color and
+ *  animation without storing anything per object.
+ */
+struct Lattice {
+    int side;
+    float spacing; // Between the centers of two neighbour objects
+
+    Lattice(int count, float spacing) : side(std::max(1, int(std::ceil(std::cbrt(double(count)) - 1e-6)))), spacing(spacing) {}
+
+    glm::vec3 position(int index) const {
+        glm::vec3 cell = glm::vec3(float(index % side), float((index / side) % side), float(index / (side * side)));
+        return spacing * (cell - glm::vec3(0.5f * float(side - 1)));
+    }
+
+    /* Length of a side of the lattice */
+    float extent() const { return spacing * float(side); }
+
+    /* Knuth multiplicative hash of the index, in [0, 1) */
+    static float phase(int index) { return float((std::uint32_t(index) * 2654435761u) >> 8) * (1.0f / 16777216.0f); }
+
+    /* Opaque color cycling through the hues with the phase */
+    static glm::vec4 color(float phase) {
+        return glm::vec4(0.5f + 0.5f * std::cos(6.2831853f * phase), 0.5f + 0.5f * std::cos(6.2831853f * (phase + 0.33f)),
+                         0.5f + 0.5f * std::cos(6.2831853f * (phase + 0.67f)), 1.0f);
+    }
+};
+
+/*! \brief Camera orbiting the origin, turned by dragging the mouse and zoomed with the wheel
+ *
+ *  The distance follows the extent of what it looks at, so the whole lattice is in view at any object count.
+ */
+struct OrbitCamera {
+    float yaw = -35.0f;
+    float pitch = 25.0f;
+    float zoom = 1.0f;
+
+    /* Mouse delta of a drag (zero otherwise), scaled by the sensitivity and the frame time */
+    void update(glm::vec2 const &dragDelta, float wheel, float sensitivity, float deltaTime) {
+        yaw += dragDelta.x * sensitivity * deltaTime;
+        pitch = std::clamp(pitch + dragDelta.y * sensitivity * deltaTime, -89.0f, 89.0f);
+        if (wheel != 0.0f)
+            zoom = std::clamp(zoom * std::pow(0.9f, wheel), 0.05f, 4.0f);
+    }
+
+    float distance(float extent) const { return zoom * extent * 1.6f + 2.0f; }
+
+    glm::vec3 eye(float extent) const {
+        return distance(extent) * glm::vec3(std::cos(glm::radians(pitch)) * std::cos(glm::radians(yaw)), std::sin(glm::radians(pitch)),
+                                            std::cos(glm::radians(pitch)) * std::sin(glm::radians(yaw)));
+    }
+};
+
+#endif
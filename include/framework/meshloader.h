@@ -0,0 +1,60 @@
+#pragma once
+
+#ifndef MESHLOADER_H
+#define MESHLOADER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/gl3w.h>
+
+#include "framework/opengl/vertex.h"
+
+/*! \brief Indexed triangle mesh, three indices per triangle
+ *
+ *  Normals missing from the file are computed from the triangles (area weighted), texture coordinates default to zero.
+ */
+struct Mesh {
+    std::vector<glf::vertex_v3fn3fv2f> vertices;
+    std::vector<GLuint> indices;
+    bool hasNormals = false;
+    bool hasTexcoords = false;
+
+    std::size_t triangleCount() const { return indices.size() / 3; }
+
+    void computeNormals();
+};
+
+/*! \brief Imports OBJ and PLY files as indexed meshes
+ *
+ *  The file is memory mapped and cut into chunks at line boundaries which are parsed in parallel, OBJ face corners are then
+ *  deduplicated into unique vertices. Binary PLY vertices have a fixed stride and are decoded in parallel as well.
+ *  Imported meshes are written to a binary cache, keyed by the path and checked against the size and modification time of the
+ *  source, so later runs skip the text parsing and only read the vertex and index arrays.
+ *
+ *       Mesh torus;
+ *       if (!MeshLoader::load("../data/models/torus.ply", torus))
+ *           return false;
+ *       ...
+ *       glBufferData(GL_ARRAY_BUFFER, torus.vertices.size() * sizeof(glf::vertex_v3fn3fv2f), torus.vertices.data(), GL_STATIC_DRAW);
+ */
+class MeshLoader {
+  public:
+    /* Loads an .obj or .ply file, returns false (and logs why) when it can't be read */
+    static bool load(std::string const &Filename, Mesh &Result);
+
+    /* Directory of the binary cache, an empty directory disables it */
+    static void setCacheDirectory(std::string const &Directory);
+    static std::string const &getCacheDirectory();
+
+  private:
+    static bool loadOBJ(std::string const &Filename, char const *Data, std::size_t Size, Mesh &Result);
+    static bool loadPLY(std::string const &Filename, char const *Data, std::size_t Size, Mesh &Result);
+
+    static std::string cacheFilename(std::string const &Filename);
+    static bool loadCache(std::string const &CacheFilename, std::uint64_t SourceSize, std::int64_t SourceTime, Mesh &Result);
+    static bool saveCache(std::string const &CacheFilename, std::uint64_t SourceSize, std::int64_t SourceTime, Mesh const &Result);
+};
+
+#endif
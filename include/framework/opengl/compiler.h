@@ -15,6 +15,14 @@ std::string format(const char *Message, ...);
 
 bool checkError(const char *Title);
 
+namespace glf {
+    /* Version of the current context, the views ask for 3.3 but the drivers usually create their latest core version */
+    bool versionAtLeast(int Major, int Minor);
+    /* Whether the extension is in the GL_EXTENSIONS of the current context. The functions of the features past 3.3 aren't loaded
+     * by gl3w, their callers fetch them with gl3wGetProcAddress once one of these says the driver has them */
+    bool hasExtension(char const *Name);
+} // namespace glf
+
 class Compiler {
     typedef std::map<std::string, GLuint> names_map;
     typedef std::map<GLuint, std::string> files_map;
@@ -30,7 +38,7 @@ class Compiler {
         int getVersion() const { return this->Version; }
         std::string getProfile() const { return this->Profile; }
         std::string getDefines() const;
-        std::vector<std::string> getIncludes() const { return this->Includes; }
+        std::vector<std::string> const &getIncludes() const { return this->Includes; }
 
       private:
         std::string Profile;
@@ -39,20 +47,64 @@ class Compiler {
         std::vector<std::string> Includes;
     };
 
+    /*! \brief GLSL preprocessor resolving #include directives
+     *
+     *  Includes are searched next to the including file first, then in the include directories of the command line. They can be
+     *  nested and a file containing #pragma once is only included once per shader. #line directives are emitted at every file
+     *  boundary with the index of the file in Files as source string number, so compile logs can be traced back to the right file.
+     *  File contents come from a cache shared by all compilers and revalidated against the modification time.
+     */
     class parser {
       public:
-        std::string operator()(commandline const &CommandLine, std::string const &Filename) const;
+        std::string operator()(commandline const &CommandLine, std::string const &Filename, std::vector<std::string> &Files) const;
 
       private:
-        std::string parseInclude(std::string const &Line, std::size_t const &Offset) const;
+        struct chunk {
+            char const *Data;
+            std::size_t Size;
+        };
+        struct context;
+
+        bool parseFile(context &Context, std::string const &Filename, int Depth) const;
+        std::string parseInclude(char const *Line, std::size_t Size) const;
     };
 
   public:
     ~Compiler();
 
+    /* Creates a shader from the preprocessed file, compilation is deferred to link() (or compile()) so that it can be skipped
+     * entirely when the program binary is cached. Returns 0 for a compute shader when the context has no compute support */
     GLuint create(GLenum Type, std::string const &Filename, std::string const &Arguments = std::string());
     bool destroy(GLuint const &Name);
 
+    /* Compiles the shaders created but not compiled yet */
+    void compile();
+    bool compile(GLuint const &Name);
+
+    /*! \brief Submits the link of a program from shaders created with this compiler
+     *
+     *  The program binary is looked up in the cache by a hash of the preprocessed sources, GL_RENDERER and GL_VERSION, on a miss the
+     *  shaders are compiled and the program linked. Nothing waits on the driver here: the results are collected by check(), so a batch
+     *  of programs is compiled concurrently by drivers with background compiler threads (GL_KHR_parallel_shader_compile).
+     *  A stale binary rejected by the driver is compiled again in check(), where new binaries are also written to the cache.
+     *  check_program() reports the link errors once check() was called.
+     */
+    void link(GLuint ProgramName, std::vector<GLuint> const &Shaders);
+
+    /* Files the shader was preprocessed from, the shader file first and then its includes */
+    std::vector<std::string> const &dependencies(GLuint const &Name) const;
+
+    /* Forgets the cached content of a file, or of every file */
+    static void invalidateSource(std::string const &Filename);
+    static void clearSourceCache();
+
+    /* Compute shaders need OpenGL 4.3, the views are created with a 3.3 context that the drivers usually upgrade to their latest
+     * core version. GL_ARB_compute_shader alone isn't enough, the compute shaders are #version 430 and use storage blocks */
+    static bool computeSupported();
+
+    static void setBinaryCacheDirectory(std::string const &Directory);
+    static std::string const &getBinaryCacheDirectory();
+
     bool check_program(GLuint ProgramName) const;
     bool validate_program(GLuint ProgramName) const;
 
@@ -65,6 +117,31 @@ class Compiler {
     names_map ShaderNames;
     files_map ShaderFiles;
     names_map PendingChecks;
+
+    // Preprocessed sources, kept to key the program binary cache
+    std::map<GLuint, std::string> ShaderSources;
+    std::map<GLuint, GLenum> ShaderTypes;
+    std::map<GLuint, std::vector<std::string>> ShaderDependencies;
+
+    struct pending_link {
+        GLuint Program;
+        std::vector<GLuint> Shaders;
+        std::string CacheFilename;
+        bool FromBinary;
+    };
+    std::vector<pending_link> PendingLinks;
+
+    void linkShaders(pending_link const &Link);
+    void finishLink(pending_link &Link);
+    void finishLinks();
+
+    // Replaces the source string numbers of a compile log by the file names
+    std::string translateLog(GLuint const &Name, std::string const &Log) const;
+
+    static bool binaryCacheSupported();
+    // The first call sets the number of compiler threads, it has to happen before the driver compiles anything
+    static bool parallelCompileSupported();
+    std::string binaryCacheFilename(std::vector<GLuint> const &Shaders) const;
 };
 
 std::string load_file(std::string const &Filename);
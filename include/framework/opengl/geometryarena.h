@@ -0,0 +1,165 @@
+#pragma once
+
+#ifndef GEOMETRYARENA_H
+#define GEOMETRYARENA_H
+
+#include <GL/gl3w.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "framework/opengl/vaomanager.h"
+#include "qulkan/logger.h"
+
+/*! \brief Location of a mesh in a GeometryArena, the arguments of its draw */
+struct ArenaMesh {
+    GLuint firstIndex = 0;
+    GLuint indexCount = 0;
+    GLint baseVertex = 0; // Added to the indices of the mesh, which start at 0
+    GLuint vertexCount = 0;
+
+    bool valid() const { return indexCount != 0; }
+};
+
+/*! \brief Shared vertex and index buffers holding many meshes of one vertex format, drawn through a single VAO
+ *
+ *  Meshes are appended and keep their own 0-based indices, the base vertex of the draw offsets them. The buffers double when
+ *  they are full, the content is copied on the GPU and the VAO is pointed at the new buffers. Since every mesh shares the VAO,
+ *  a whole set of meshes can be drawn by one MultiDrawBatch call.
+ *
+ *       GeometryArena<glf::vertex_v3fn3f> arena;
+ *       arena.create();
+ *       ArenaMesh rock = arena.add(rockVertices, rockIndices);
+ *       batch.add(material, rock);
+ *       ...
+ *       batch.draw(material, arena.vao());
+ */
+template <typename Vertex> class GeometryArena {
+
+  private:
+    GLuint m_vao;
+    GLuint m_vertexBuffer;
+    GLuint m_indexBuffer;
+
+    GLsizeiptr m_vertexCapacity; // In vertices
+    GLsizeiptr m_indexCapacity;  // In indices
+    GLsizeiptr m_vertexCount;
+    GLsizeiptr m_indexCount;
+    std::size_t m_meshCount;
+
+    /* Replaces buffer by one of newSize bytes holding its first usedSize bytes */
+    static void grow(GLuint &buffer, GLsizeiptr usedSize, GLsizeiptr newSize) {
+        GLuint grown = 0;
+        glGenBuffers(1, &grown);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+        glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+        if (buffer != 0 && usedSize > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedSize);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        if (buffer != 0)
+            glDeleteBuffers(1, &buffer);
+        buffer = grown;
+    }
+
+    /* The VAO keeps the buffer objects it was set up with, it is pointed again at the buffers after they grew */
+    void setupVertexArray() {
+        glBindVertexArray(m_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+        glf::setupVertexAttributes<Vertex>();
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+        glBindVertexArray(0);
+    }
+
+  public:
+    GeometryArena()
+        : m_vao(0), m_vertexBuffer(0), m_indexBuffer(0), m_vertexCapacity(0), m_indexCapacity(0), m_vertexCount(0), m_indexCount(0), m_meshCount(0) {}
+    ~GeometryArena() {}
+
+    GeometryArena(GeometryArena const &) = delete;
+    void operator=(GeometryArena const &) = delete;
+
+    /* Allocates the buffers and the VAO, needs a current context. The capacities are only initial sizes */
+    void create(GLsizeiptr vertexCapacity = 1 << 16, GLsizeiptr indexCapacity = 1 << 18) {
+        destroy();
+        m_vertexCapacity = std::max<GLsizeiptr>(vertexCapacity, 1);
+        m_indexCapacity = std::max<GLsizeiptr>(indexCapacity, 1);
+        grow(m_vertexBuffer, 0, m_vertexCapacity * GLsizeiptr(sizeof(Vertex)));
+        grow(m_indexBuffer, 0, m_indexCapacity * GLsizeiptr(sizeof(GLuint)));
+        glGenVertexArrays(1, &m_vao);
+        setupVertexArray();
+    }
+
+    void destroy() {
+        if (m_vao != 0)
+            glDeleteVertexArrays(1, &m_vao);
+        if (m_vertexBuffer != 0)
+            glDeleteBuffers(1, &m_vertexBuffer);
+        if (m_indexBuffer != 0)
+            glDeleteBuffers(1, &m_indexBuffer);
+        m_vao = m_vertexBuffer = m_indexBuffer = 0;
+        m_vertexCapacity = m_indexCapacity = m_vertexCount = m_indexCount = 0;
+        m_meshCount = 0;
+    }
+
+    /* Appends a mesh, its indices refer to its own vertices */
+    ArenaMesh add(Vertex const *vertices, std::size_t vertexCount, GLuint const *indices, std::size_t indexCount) {
+        ArenaMesh mesh;
+        if (m_vao == 0) {
+            Qulkan::Logger::Error("GeometryArena: create() has to be called before adding meshes\n");
+            return mesh;
+        }
+        if (vertexCount == 0 || indexCount == 0)
+            return mesh;
+
+        bool grown = false;
+        if (m_vertexCount + GLsizeiptr(vertexCount) > m_vertexCapacity) {
+            GLsizeiptr capacity = std::max(m_vertexCapacity * 2, m_vertexCount + GLsizeiptr(vertexCount));
+            grow(m_vertexBuffer, m_vertexCount * GLsizeiptr(sizeof(Vertex)), capacity * GLsizeiptr(sizeof(Vertex)));
+            m_vertexCapacity = capacity;
+            grown = true;
+        }
+        if (m_indexCount + GLsizeiptr(indexCount) > m_indexCapacity) {
+            GLsizeiptr capacity = std::max(m_indexCapacity * 2, m_indexCount + GLsizeiptr(indexCount));
+            grow(m_indexBuffer, m_indexCount * GLsizeiptr(sizeof(GLuint)), capacity * GLsizeiptr(sizeof(GLuint)));
+            m_indexCapacity = capacity;
+            grown = true;
+        }
+        if (grown)
+            setupVertexArray();
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, m_vertexCount * GLsizeiptr(sizeof(Vertex)), GLsizeiptr(vertexCount * sizeof(Vertex)), vertices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, m_indexCount * GLsizeiptr(sizeof(GLuint)), GLsizeiptr(indexCount * sizeof(GLuint)), indices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        mesh.firstIndex = GLuint(m_indexCount);
+        mesh.indexCount = GLuint(indexCount);
+        mesh.baseVertex = GLint(m_vertexCount);
+        mesh.vertexCount = GLuint(vertexCount);
+
+        m_vertexCount += GLsizeiptr(vertexCount);
+        m_indexCount += GLsizeiptr(indexCount);
+        ++m_meshCount;
+        return mesh;
+    }
+
+    ArenaMesh add(std::vector<Vertex> const &vertices, std::vector<GLuint> const &indices) {
+        return add(vertices.data(), vertices.size(), indices.data(), indices.size());
+    }
+
+    GLuint vao() const { return m_vao; }
+    GLuint vertexBuffer() const { return m_vertexBuffer; }
+    GLuint indexBuffer() const { return m_indexBuffer; }
+
+    std::size_t getMeshCount() const { return m_meshCount; }
+    std::size_t getVertexCount() const { return std::size_t(m_vertexCount); }
+    std::size_t getIndexCount() const { return std::size_t(m_indexCount); }
+};
+
+#endif
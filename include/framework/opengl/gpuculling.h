@@ -0,0 +1,78 @@
+#pragma once
+
+#ifndef GPUCULLING_H
+#define GPUCULLING_H
+
+#include <GL/gl3w.h>
+
+#include <glm/glm.hpp>
+
+#include "framework/frustum.h"
+#include "framework/opengl/compiler.h"
+#include "framework/opengl/geometryarena.h"
+#include "framework/opengl/instancerenderer.h"
+#include "framework/opengl/programmanager.h"
+#include "framework/opengl/shadermanager.h"
+
+/*! \brief Frustum culling of the instances of a mesh in a compute shader, drawn with the indirect arguments it writes
+ *
+ *  The bounding sphere of the mesh is transformed by each instance of an InstanceRenderer range and tested against the planes
+ *  of the frustum. The visible instances are compacted into a buffer of their own and counted in the instanceCount of a
+ *  DrawElementsIndirectCommand, which the draw reads on the GPU: the CPU never sees the visibility of the instances.
+ *  Needs compute shaders (OpenGL 4.3), check supported() before submitting the program.
+ *
+ *       GPUCulling::submitProgram(shaderManager, programManager, compiler);
+ *       ... once the programs are checked
+ *       culling.create(programManager, maxInstances);
+ *       ...
+ *       culling.cull(instanceRenderer, range, mesh, boundingSphere, Frustum::fromMatrix(projection * view));
+ *       ... use the program of the mesh
+ *       culling.drawElements(vao, GL_TRIANGLES);
+ */
+class GPUCulling {
+  public:
+    typedef InstanceRenderer::Instance Instance;
+
+    static constexpr char const *PROGRAM = "GPU_CULLING";
+    static const GLuint WORK_GROUP_SIZE = 256; // local_size_x of the shader
+
+    GPUCulling();
+
+    static bool supported();
+
+    /* Adds the compute shader (GLSL 430) and submits the link of the PROGRAM program */
+    static void submitProgram(ShaderManager &shaderManager, ProgramManager &programManager, Compiler &compiler);
+
+    /* Room for maxInstances visible instances, needs the program to be linked */
+    bool create(ProgramManager &programManager, GLsizei maxInstances);
+    void destroy();
+
+    GLsizei capacity() const { return maxInstances; }
+
+    /* To be called again after the program was relinked */
+    void resolveUniforms();
+
+    /* Dispatches the culling of the range, mesh gives the indices drawn and boundingSphere its bounds (center in xyz, radius in w) */
+    bool cull(InstanceRenderer &instanceRenderer, InstanceRenderer::Range const &range, ArenaMesh const &mesh, glm::vec4 const &boundingSphere,
+              Frustum const &frustum);
+
+    /* Draws the visible instances of the last cull(), the indices of the VAO being GL_UNSIGNED_INT */
+    void drawElements(GLuint vao, GLenum mode);
+
+    GLuint instanceBuffer() const { return outputBuffer; }
+    GLuint commandBuffer() const { return indirectBuffer; }
+
+  private:
+    ProgramManager *programManager;
+    GLuint outputBuffer;
+    GLuint indirectBuffer;
+    GLsizei maxInstances;
+    GLint storageAlignment;
+
+    struct CullingUniforms {
+        Uniform instanceCount, firstWord, boundingSphere;
+        GLint planes; // Array of Frustum::PLANE_COUNT
+    } uniforms;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#pragma once
+
+#ifndef INSTANCERENDERER_H
+#define INSTANCERENDERER_H
+
+#include <GL/gl3w.h>
+
+#include <vector>
+
+#include "framework/opengl/streambuffer.h"
+#include "framework/opengl/vertex.h"
+
+/*! \brief Draws many copies of a mesh in one call, with a transform, a color and a material index per instance
+ *
+ *  The instances of a frame are written into a StreamBuffer, either copied from an array with submit() or generated in place
+ *  through allocate(). The mesh VAO reads them at the semantic::attr::INSTANCE_* locations with a divisor of 1. OpenGL 3.3 has
+ *  no base instance, so every draw points the instance attributes of the VAO at its range of the buffer before drawing.
+ *
+ *       instanceRenderer.beginFrame();
+ *       InstanceRenderer::Range range = instanceRenderer.allocate(count);
+ *       for (GLsizei i = 0; i < range.count; ++i)
+ *           range.data[i] = glf::instance_m4fc4fu1(transforms[i], colors[i], materials[i]);
+ *       instanceRenderer.drawArrays(vaoCube.id, GL_TRIANGLES, 0, vaoCube.getVertexCount(), range);
+ *       instanceRenderer.endFrame();
+ */
+class InstanceRenderer {
+  public:
+    typedef glf::instance_m4fc4fu1 Instance;
+
+    /* Instances of the current frame, valid until endFrame() */
+    struct Range {
+        Instance *data = nullptr;
+        GLintptr offset = 0;
+        GLsizei count = 0;
+
+        bool valid() const { return data != nullptr; }
+    };
+
+    InstanceRenderer();
+
+    /* Room for maxInstances instances per frame, needs a current context */
+    bool create(GLsizei maxInstances, int frames = StreamBuffer::FRAME_REGIONS);
+    void destroy();
+
+    GLsizei capacity() const { return maxInstances; }
+
+    void beginFrame();
+
+    /* Instances to fill in place (from several threads if needed), invalid when the frame is out of room */
+    Range allocate(GLsizei count);
+
+    Range submit(Instance const *instances, GLsizei count);
+    Range submit(std::vector<Instance> const &instances) { return submit(instances.data(), GLsizei(instances.size())); }
+
+    /* Bind the VAO of the mesh, point its instance attributes at the range and draw every instance of it */
+    void drawArrays(GLuint vao, GLenum mode, GLint first, GLsizei vertexCount, Range const &range);
+    void drawElements(GLuint vao, GLenum mode, GLsizei indexCount, GLenum type, GLintptr indexOffset, Range const &range);
+
+    void endFrame();
+
+    /* Makes the instances written so far visible to the GPU, done by every draw. Needed before reading them otherwise (e.g. GPUCulling) */
+    void flush() { streamBuffer.flush(); }
+
+    /* Binds the VAO and points its instance attributes at the range, starting at its instance firstInstance. Used by the draws
+     * above, and by the other instanced draws (e.g. MultiDrawBatch) */
+    bool bindInstances(GLuint vao, Range const &range, GLuint firstInstance = 0);
+
+    /* Totals of the current frame */
+    GLsizei getInstanceCount() const { return instanceCount; }
+    int getDrawCount() const { return drawCount; }
+
+    StreamBuffer const &getStreamBuffer() const { return streamBuffer; }
+
+  private:
+    StreamBuffer streamBuffer;
+    GLsizei maxInstances;
+
+    GLsizei instanceCount;
+    int drawCount;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+
+#ifndef MULTIDRAWBATCH_H
+#define MULTIDRAWBATCH_H
+
+#include <GL/gl3w.h>
+
+#include <vector>
+
+#include "framework/opengl/geometryarena.h"
+#include "framework/opengl/instancerenderer.h"
+#include "framework/opengl/streambuffer.h"
+
+/*! \brief Layout of the commands read by glMultiDrawElementsIndirect */
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+/*! \brief Draws of GeometryArena meshes sorted by material, issued with one call per material
+ *
+ *  The commands of the frame are collected per material and written into a StreamBuffer, then each material is drawn by a
+ *  single glMultiDrawElementsIndirect (GL 4.3 or GL_ARB_multi_draw_indirect). On plain 3.3 drivers the commands of a material go
+ *  through one glMultiDrawElementsBaseVertex, or one glDrawElementsInstancedBaseVertex per command for instanced commands.
+ *  The baseInstance of a command is its first instance in the range of an InstanceRenderer, which gives every mesh its own
+ *  transforms without any uniform update between the draws.
+ *
+ *       batch.beginFrame();
+ *       for (Object const &object : objects)
+ *           batch.add(object.material, object.mesh, 1, object.instance);
+ *       for (unsigned material = 0; material < batch.getMaterialCount(); ++material) {
+ *           ... use the program of the material
+ *           batch.draw(material, arena.vao(), instanceRenderer, instances);
+ *       }
+ *       batch.endFrame();
+ */
+class MultiDrawBatch {
+  public:
+    MultiDrawBatch();
+
+    /* Room for maxCommands commands per frame over every material, needs a current context */
+    bool create(GLsizei maxCommands, int frames = StreamBuffer::FRAME_REGIONS);
+    void destroy();
+
+    void beginFrame();
+
+    void add(unsigned material, ArenaMesh const &mesh, GLuint instanceCount = 1, GLuint baseInstance = 0);
+
+    /* Draws the commands of a material with the program of the material in use. vao is the VAO of the arena the meshes are in */
+    void draw(unsigned material, GLuint vao, GLenum mode = GL_TRIANGLES);
+
+    /* Same, the baseInstance of the commands being an index into the instances of range */
+    void draw(unsigned material, GLuint vao, InstanceRenderer &instanceRenderer, InstanceRenderer::Range const &range, GLenum mode = GL_TRIANGLES);
+
+    void endFrame();
+
+    /* Materials used this frame, the largest material index plus one */
+    unsigned getMaterialCount() const { return materialCount; }
+    GLsizei getCommandCount(unsigned material) const;
+
+    /* Draw calls issued this frame, one per material when the indirect draws are supported */
+    int getDrawCallCount() const { return drawCalls; }
+
+    static bool indirectSupported();
+
+  private:
+    StreamBuffer streamBuffer;
+    std::vector<std::vector<DrawElementsIndirectCommand>> commands; // Per material, the vectors are kept between frames
+    unsigned materialCount;
+    int drawCalls;
+
+    // Arguments of glMultiDrawElementsBaseVertex, reused between the draws
+    std::vector<GLsizei> counts;
+    std::vector<void const *> offsets;
+    std::vector<GLint> baseVertices;
+
+    void drawCommands(unsigned material, GLuint vao, GLenum mode, InstanceRenderer *instanceRenderer, InstanceRenderer::Range const *range);
+};
+
+#endif
@@ -6,20 +6,244 @@
 #include <GL/gl3w.h>
 #include <GLFW/glfw3.h>
 
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <iostream>
 #include <map>
+#include <set>
 #include <vector>
 
+#include "qulkan/logger.h"
 #include "qulkan/utils.h"
 
 #include "framework/opengl/compiler.h"
+#include "framework/opengl/shadermanager.h"
+
+/*! \brief Cached description of an active uniform of a linked program
+ *
+ *  The shadow holds the raw bytes of the last value uploaded through a Uniform so that unchanged values are never sent to the driver again.
+ *  The location is -1 while the uniform is not active in the program, e.g. optimized out of the last successful link.
+ */
+struct UniformInfo {
+    GLint location;
+    GLenum type;
+    GLint size;
+
+    bool uploaded;
+    std::array<unsigned char, sizeof(glm::mat4)> shadow;
+
+    UniformInfo(GLint location = -1, GLenum type = GL_NONE, GLint size = 0) : location(location), type(type), size(size), uploaded(false) {}
+
+    /* Whether a value of valueType (GL_INT for the integer setters) can be set to the uniform. Booleans, samplers and images are set
+     * as integers */
+    bool accepts(GLenum valueType) const {
+        if (type == valueType)
+            return true;
+        if (valueType != GL_INT)
+            return false;
+        switch (type) {
+        case GL_FLOAT:
+        case GL_FLOAT_VEC2:
+        case GL_FLOAT_VEC3:
+        case GL_FLOAT_VEC4:
+        case GL_FLOAT_MAT2:
+        case GL_FLOAT_MAT3:
+        case GL_FLOAT_MAT4:
+        case GL_FLOAT_MAT2x3:
+        case GL_FLOAT_MAT2x4:
+        case GL_FLOAT_MAT3x2:
+        case GL_FLOAT_MAT3x4:
+        case GL_FLOAT_MAT4x2:
+        case GL_FLOAT_MAT4x3:
+        case GL_DOUBLE:
+        case GL_DOUBLE_VEC2:
+        case GL_DOUBLE_VEC3:
+        case GL_DOUBLE_VEC4:
+        case GL_INT_VEC2:
+        case GL_INT_VEC3:
+        case GL_INT_VEC4:
+        case GL_UNSIGNED_INT:
+        case GL_UNSIGNED_INT_VEC2:
+        case GL_UNSIGNED_INT_VEC3:
+        case GL_UNSIGNED_INT_VEC4:
+        case GL_BOOL_VEC2:
+        case GL_BOOL_VEC3:
+        case GL_BOOL_VEC4:
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    /* Updates the shadow copy and returns true if the value differs from the last uploaded one */
+    bool update(const void *data, std::size_t bytes) {
+        if (uploaded && std::memcmp(shadow.data(), data, bytes) == 0)
+            return false;
+        std::memcpy(shadow.data(), data, bytes);
+        uploaded = true;
+        return true;
+    }
+};
+
+/*! \brief Dirty-tracked handle to a uniform of a program
+ *
+ *  Obtained once after linking with programManager.uniform("PROGRAM", "name"). The setters only issue glUniform* when the value
+ *  actually changed. As with glUniform*, the program must be in use when setting a value.
+ *  A Uniform of an inactive (optimized out) uniform is invalid and its setters do nothing. The handle follows the relinks of the
+ *  program: it becomes valid again when a reload makes the uniform active. Setting a value of another type than the declaration
+ *  of the uniform asserts.
+ */
+class Uniform {
+
+  private:
+    UniformInfo *m_info;
+
+    bool settable(GLenum valueType) const {
+        if (m_info == nullptr || m_info->location == -1)
+            return false;
+        bool accepted = m_info->accepts(valueType);
+        ASSERT(accepted, "Uniform set with a value of another type than its declaration");
+        return accepted;
+    }
+
+  public:
+    Uniform() : m_info(nullptr) {}
+    explicit Uniform(UniformInfo *info) : m_info(info) {}
+
+    bool valid() const { return m_info != nullptr && m_info->location != -1; }
+    GLint location() const { return m_info != nullptr ? m_info->location : -1; }
+
+    void set(bool value) { set(int(value)); }
+
+    void set(int value) {
+        if (settable(GL_INT) && m_info->update(&value, sizeof(value)))
+            glUniform1i(m_info->location, value);
+    }
+
+    void set(float value) {
+        if (settable(GL_FLOAT) && m_info->update(&value, sizeof(value)))
+            glUniform1f(m_info->location, value);
+    }
+
+    void set(const glm::vec2 &value) {
+        if (settable(GL_FLOAT_VEC2) && m_info->update(glm::value_ptr(value), sizeof(value)))
+            glUniform2fv(m_info->location, 1, glm::value_ptr(value));
+    }
+
+    void set(const glm::vec3 &value) {
+        if (settable(GL_FLOAT_VEC3) && m_info->update(glm::value_ptr(value), sizeof(value)))
+            glUniform3fv(m_info->location, 1, glm::value_ptr(value));
+    }
+
+    void set(const glm::vec4 &value) {
+        if (settable(GL_FLOAT_VEC4) && m_info->update(glm::value_ptr(value), sizeof(value)))
+            glUniform4fv(m_info->location, 1, glm::value_ptr(value));
+    }
+
+    void set(const glm::mat3 &value) {
+        if (settable(GL_FLOAT_MAT3) && m_info->update(glm::value_ptr(value), sizeof(value)))
+            glUniformMatrix3fv(m_info->location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
+    void set(const glm::mat4 &value) {
+        if (settable(GL_FLOAT_MAT4) && m_info->update(glm::value_ptr(value), sizeof(value)))
+            glUniformMatrix4fv(m_info->location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+};
 
 class ProgramManager {
 
   private:
+    typedef std::map<std::string, UniformInfo> uniforms_map;
+
     std::map<std::string, GLuint> m_programs_map;
+    std::map<std::string, uniforms_map> m_uniforms_map;
+    std::map<std::string, std::vector<std::string>> m_shaders_map;
     int m_max;
 
+    static void invalidate(uniforms_map &uniforms) {
+        for (auto &uniform : uniforms)
+            uniform.second = UniformInfo();
+    }
+
+    // Arrays are reported as "name[0]", they are cached as "name"
+    static std::string baseName(const std::string &uniformName) {
+        std::size_t arrayOffset = uniformName.rfind("[0]");
+        if (arrayOffset != std::string::npos && arrayOffset + 3 == uniformName.size())
+            return uniformName.substr(0, arrayOffset);
+        return uniformName;
+    }
+
+    // Carries the values of the uniforms over to a relinked program, samplers units and values set once stay as they were
+    static void copyUniforms(GLuint from, GLuint to) {
+        GLint previous = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &previous);
+        glUseProgram(to);
+
+        GLint activeUniforms = 0;
+        GLint maxNameLength = 0;
+        glGetProgramiv(to, GL_ACTIVE_UNIFORMS, &activeUniforms);
+        glGetProgramiv(to, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+        std::vector<GLchar> nameBuffer(std::max(maxNameLength, 1));
+        for (GLint i = 0; i < activeUniforms; ++i) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = GL_NONE;
+            glGetActiveUniform(to, GLuint(i), GLsizei(nameBuffer.size()), &length, &size, &type, nameBuffer.data());
+            GLint fromLocation = glGetUniformLocation(from, nameBuffer.data());
+            GLint toLocation = glGetUniformLocation(to, nameBuffer.data());
+            if (fromLocation == -1 || toLocation == -1 || size != 1)
+                continue;
+
+            GLfloat f[16];
+            GLint v[4];
+            switch (type) {
+            case GL_FLOAT:
+                glGetUniformfv(from, fromLocation, f);
+                glUniform1fv(toLocation, 1, f);
+                break;
+            case GL_FLOAT_VEC2:
+                glGetUniformfv(from, fromLocation, f);
+                glUniform2fv(toLocation, 1, f);
+                break;
+            case GL_FLOAT_VEC3:
+                glGetUniformfv(from, fromLocation, f);
+                glUniform3fv(toLocation, 1, f);
+                break;
+            case GL_FLOAT_VEC4:
+                glGetUniformfv(from, fromLocation, f);
+                glUniform4fv(toLocation, 1, f);
+                break;
+            case GL_FLOAT_MAT3:
+                glGetUniformfv(from, fromLocation, f);
+                glUniformMatrix3fv(toLocation, 1, GL_FALSE, f);
+                break;
+            case GL_FLOAT_MAT4:
+                glGetUniformfv(from, fromLocation, f);
+                glUniformMatrix4fv(toLocation, 1, GL_FALSE, f);
+                break;
+            case GL_INT:
+            case GL_BOOL:
+            case GL_SAMPLER_2D:
+            case GL_SAMPLER_3D:
+            case GL_SAMPLER_CUBE:
+            case GL_SAMPLER_2D_SHADOW:
+                glGetUniformiv(from, fromLocation, v);
+                glUniform1i(toLocation, v[0]);
+                break;
+            default:
+                break;
+            }
+        }
+
+        glUseProgram(GLuint(previous));
+    }
+
   public:
     ProgramManager() : m_max(0){};
     ~ProgramManager(){};
@@ -28,16 +252,164 @@ class ProgramManager {
 
     void addProgram(std::string programName) {
         m_programs_map[programName] = glCreateProgram();
+        // The handles of a view created again stay usable, they are valid once the new program is reflected
+        auto uniforms = m_uniforms_map.find(programName);
+        if (uniforms != m_uniforms_map.end())
+            invalidate(uniforms->second);
         ++m_max;
     }
 
-    GLuint operator()(const std::string programName) { return programID(programName); }
+    GLuint operator()(const std::string &programName) { return programID(programName); }
 
-    GLuint programID(const std::string programName) {
-        ASSERT(m_programs_map.find(programName) != m_programs_map.end(), "No program with that name found: " + programName);
+    /* Submits the link of a program from named shaders, remembered so that the program can be relinked by reload() */
+    void link(const std::string &programName, const std::vector<std::string> &shaderNames, ShaderManager &shaderManager, Compiler &compiler) {
+        std::vector<GLuint> shaders;
+        for (const std::string &shaderName : shaderNames)
+            shaders.push_back(shaderManager(shaderName));
+        m_shaders_map[programName] = shaderNames;
+        compiler.link(programID(programName), shaders);
+    }
 
-        return m_programs_map[programName];
+    /* Waits for the links submitted with the compiler and checks every program, returns false when one of them failed.
+     * The shaders are not needed anymore once the programs are linked, the compiler deletes them */
+    bool check(ShaderManager &shaderManager, Compiler &compiler) {
+        bool linked = compiler.check();
+        for (auto &program : m_shaders_map)
+            linked = compiler.check_program(programID(program.first)) && linked;
+        compiler.clear();
+        shaderManager.release();
+        return linked;
     }
+
+    /*! \brief Relinks the programs built from one of the files, or every program when files is empty
+     *
+     *  Only the shaders of these programs are preprocessed and compiled again, all of them before the results are checked.
+     *  The new shaders belong to a compiler of their own, deleted along with it once linked, the ShaderManager keeps no name of them.
+     *  A program is replaced once the new one linked successfully, until then the old one stays in use and the errors are logged.
+     *  The uniform values are carried over and a reflected program is reflected again, its Uniform handles follow the new
+     *  locations. Returns the names of the relinked programs.
+     */
+    std::vector<std::string> reload(ShaderManager &shaderManager, const std::set<std::string> &files) {
+        Compiler compiler;
+        std::map<std::string, GLuint> recreated; // Shaders shared by several programs are compiled once
+        std::vector<std::pair<std::string, GLuint>> linking;
+        for (auto &program : m_shaders_map) {
+            const std::vector<std::string> &shaderNames = program.second;
+            if (!files.empty() && std::none_of(shaderNames.begin(), shaderNames.end(), [&](const std::string &shaderName) {
+                    return shaderManager.dependsOn(shaderName, files);
+                }))
+                continue;
+
+            std::vector<GLuint> shaders;
+            for (const std::string &shaderName : shaderNames) {
+                auto shader = recreated.find(shaderName);
+                if (shader == recreated.end())
+                    shader = recreated.emplace(shaderName, shaderManager.recreate(shaderName, compiler)).first;
+                shaders.push_back(shader->second);
+            }
+
+            GLuint name = glCreateProgram();
+            compiler.link(name, shaders);
+            linking.push_back(std::make_pair(program.first, name));
+        }
+
+        std::vector<std::string> relinked;
+        if (linking.empty())
+            return relinked;
+
+        compiler.check();
+        for (auto &program : linking) {
+            if (!compiler.check_program(program.second)) {
+                Qulkan::Logger::Error("ProgramManager: %s failed to relink, keeping the previous program\n", program.first.c_str());
+                glDeleteProgram(program.second);
+                continue;
+            }
+
+            GLuint &current = m_programs_map[program.first];
+            copyUniforms(current, program.second);
+            glDeleteProgram(current);
+            current = program.second;
+            if (m_uniforms_map.count(program.first) > 0)
+                reflect(program.first);
+            for (const std::string &shaderName : m_shaders_map[program.first])
+                shaderManager.relinked(shaderName, compiler, recreated[shaderName]);
+
+            Qulkan::Logger::Info("ProgramManager: Relinked %s\n", program.first.c_str());
+            relinked.push_back(program.first);
+        }
+        return relinked;
+    }
+
+    GLuint programID(const std::string &programName) {
+        auto it = m_programs_map.find(programName);
+        if (it == m_programs_map.end()) {
+            ASSERT(false, "No program with that name found: " + programName);
+            return 0;
+        }
+        return it->second;
+    }
+
+    /*! \brief Enumerates the active uniforms of a linked program and caches their location and type
+     *
+     *  Needs to be called after linking the program. The entries are updated in place, so the Uniform handles obtained before stay
+     *  valid: the uniforms no longer active are marked invalid and the others get their new location.
+     */
+    void reflect(const std::string &programName) {
+        GLuint program = programID(programName);
+        uniforms_map &uniforms = m_uniforms_map[programName];
+        invalidate(uniforms);
+
+        GLint activeUniforms = 0;
+        GLint maxNameLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &activeUniforms);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+        std::vector<GLchar> nameBuffer(std::max(maxNameLength, 1));
+        for (GLint i = 0; i < activeUniforms; ++i) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = GL_NONE;
+            glGetActiveUniform(program, GLuint(i), GLsizei(nameBuffer.size()), &length, &size, &type, nameBuffer.data());
+
+            std::string name(nameBuffer.data(), length);
+            GLint location = glGetUniformLocation(program, name.c_str());
+            // Members of uniform blocks have no location
+            if (location == -1)
+                continue;
+
+            uniforms[baseName(name)] = UniformInfo(location, type, size);
+        }
+    }
+
+    /* Returns a dirty-tracked handle to a uniform of a reflected program, to be resolved once outside of the render loop */
+    Uniform uniform(const std::string &programName, const std::string &uniformName) {
+        auto programIt = m_uniforms_map.find(programName);
+        if (programIt == m_uniforms_map.end()) {
+            ASSERT(false, "Program " + programName + " has not been reflected, call reflect() after linking it");
+            return Uniform();
+        }
+        // An inactive uniform gets an invalid entry, filled in if a later link makes it active
+        return Uniform(&programIt->second[baseName(uniformName)]);
+    }
+
+    /* Local size declared by the compute shader of a linked program, to be queried once after linking. Zero for the other programs */
+    glm::ivec3 workGroupSize(const std::string &programName) {
+        glm::ivec3 size(0);
+        GLint linked = GL_FALSE;
+        GLuint program = programID(programName);
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked != GL_TRUE || !Compiler::computeSupported())
+            return size;
+
+        // A program without compute shader is a GL_INVALID_OPERATION, which is not left to the next error check
+        glGetProgramiv(program, GL_COMPUTE_WORK_GROUP_SIZE, glm::value_ptr(size));
+        if (glGetError() != GL_NO_ERROR)
+            size = glm::ivec3(0);
+        return size;
+    }
+
+    /* Returns the cached location of a uniform, -1 if it is not active */
+    GLint uniformLocation(const std::string &programName, const std::string &uniformName) { return uniform(programName, uniformName).location(); }
 };
 
 #endif
@@ -54,7 +54,10 @@ namespace semantic
 			NORMAL	 = 1,
 			COLOR	 = 3,
 			TEXCOORD = 4,
-			DRAW_ID  = 5
+			DRAW_ID  = 5,
+			INSTANCE_TRANSFORM = 8, // 8 to 11, one column each
+			INSTANCE_COLOR	   = 12,
+			INSTANCE_MATERIAL  = 13
 		};
 	}//namespace attr
 
@@ -6,41 +6,105 @@
 #include <GL/gl3w.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
 #include <iostream>
 #include <map>
+#include <set>
 #include <vector>
 
+#include "qulkan/shaderwatcher.h"
 #include "qulkan/utils.h"
 
 #include "framework/opengl/compiler.h"
 
+/*! \brief Named shaders of a view
+ *
+ *  Keeps how every shader was created so that it can be created again on its own when one of the files it was preprocessed from
+ *  changes. These files are registered to the ShaderWatcher.
+ */
 class ShaderManager {
 
   private:
-    std::map<std::string, GLuint> m_shaders_map;
-    std::map<std::string, std::string> m_path_map;
+    struct ShaderInfo {
+        GLuint id = 0;
+        GLenum type = GL_NONE;
+        std::string path;
+        std::string arguments;
+        std::vector<std::string> dependencies;
+    };
 
-  public:
-    void addShader(std::string shaderName, std::string path, GLenum shaderType, Compiler &compiler) {
+    std::map<std::string, ShaderInfo> m_shaders_map;
 
-        m_shaders_map[shaderName] = compiler.create(shaderType, path, "--version 330 --profile core");
+    const ShaderInfo &info(const std::string &shaderName) {
+        ASSERT(m_shaders_map.find(shaderName) != m_shaders_map.end(), "No shader with that name found");
+        return m_shaders_map[shaderName];
+    }
 
-        m_path_map[shaderName] = path;
+  public:
+    /* Compiler arguments of the shaders added without any, the GLSL version of the OpenGL 3.3 core context */
+    static constexpr char const *DEFAULT_ARGUMENTS = "--version 330 --profile core";
+
+    /* The arguments set the #version of the shader (e.g. "--version 430 --profile core" for a compute shader), along with the
+     * defines and include directories. Without --version the #version line of the file is used */
+    void addShader(std::string shaderName, std::string path, GLenum shaderType, Compiler &compiler, std::string const &arguments = DEFAULT_ARGUMENTS) {
+        ShaderInfo &shader = m_shaders_map[shaderName];
+        shader.type = shaderType;
+        shader.path = path;
+        shader.arguments = arguments;
+        shader.dependencies.clear();
+        shader.id = recreate(shaderName, compiler);
     }
 
-    GLuint operator()(const std::string shaderName) { return shaderID(shaderName); }
+    /* Creates the shader again from its files with another compiler and returns the new shader name, owned by that compiler.
+     * The shader of the manager is left as it is. Until relinked() the files of the new one are added to its dependencies, a
+     * program that fails to relink is retried when any file of its last good or of its broken shaders changes */
+    GLuint recreate(const std::string &shaderName, Compiler &compiler) {
+        ShaderInfo &shader = m_shaders_map[shaderName];
+        GLuint id = compiler.create(shader.type, shader.path, shader.arguments);
 
-    GLuint shaderID(const std::string shaderName) {
-        ASSERT(m_shaders_map.find(shaderName) != m_shaders_map.end(), "No shader with that name found");
+        for (const std::string &dependency : compiler.dependencies(id)) {
+            if (std::find(shader.dependencies.begin(), shader.dependencies.end(), dependency) == shader.dependencies.end())
+                shader.dependencies.push_back(dependency);
+            Qulkan::ShaderWatcher::Instance().watch(dependency);
+        }
 
-        return m_shaders_map[shaderName];
+        return id;
     }
 
-    char const *shaderPath(const std::string shaderName) {
-        ASSERT(m_path_map.find(shaderName) != m_path_map.end(), "No shader path with that name found");
+    /* The program of the shader recreated by that compiler relinked, its dependencies become the files the new shader was
+     * preprocessed from. The files dropped from them stay watched but don't trigger a reload anymore */
+    void relinked(const std::string &shaderName, Compiler &compiler, GLuint id) {
+        ShaderInfo &shader = m_shaders_map[shaderName];
+        shader.dependencies = compiler.dependencies(id);
+    }
 
-        return m_path_map[shaderName].c_str();
+    /* Forgets the shader names once the compiler of addShader() deleted them, the programs linked from them are kept */
+    void release() {
+        for (auto &shader : m_shaders_map)
+            shader.second.id = 0;
     }
+
+    /* True if the shader was preprocessed from one of the files */
+    bool dependsOn(const std::string &shaderName, const std::set<std::string> &files) {
+        for (const std::string &dependency : info(shaderName).dependencies)
+            if (files.count(dependency) > 0)
+                return true;
+        return false;
+    }
+
+    /* True if any of the shaders was preprocessed from one of the files */
+    bool dependsOn(const std::set<std::string> &files) {
+        for (auto &shader : m_shaders_map)
+            if (dependsOn(shader.first, files))
+                return true;
+        return false;
+    }
+
+    GLuint operator()(const std::string shaderName) { return shaderID(shaderName); }
+
+    GLuint shaderID(const std::string shaderName) { return info(shaderName).id; }
+
+    char const *shaderPath(const std::string shaderName) { return info(shaderName).path.c_str(); }
 };
 
 #endif
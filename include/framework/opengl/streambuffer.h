@@ -0,0 +1,97 @@
+#pragma once
+
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <GL/gl3w.h>
+
+#include <cstddef>
+
+/*! \brief Ring buffer for the data rewritten every frame (uniforms, instance attributes, dynamic vertices)
+ *
+ *  The buffer is split into one region per frame in flight. A frame writes into its region through a mapping that is never
+ *  synchronized by the driver, instead the region is fenced at endFrame() and beginFrame() only waits for the fence of the region
+ *  it reuses, written FRAME_REGIONS frames ago.
+ *  With GL_ARB_buffer_storage (core in 4.4) the buffer stays persistently and coherently mapped. On plain 3.3 drivers the region
+ *  is mapped with GL_MAP_UNSYNCHRONIZED_BIT and unmapped by flush(), which has to be called before the draws reading it.
+ *
+ *       streamBuffer.beginFrame();
+ *       StreamBuffer::Allocation instances = streamBuffer.allocate(count * sizeof(glm::mat4));
+ *       memcpy(instances.data, transforms, count * sizeof(glm::mat4));
+ *       streamBuffer.flush();
+ *       ... draws sourcing streamBuffer.id() at instances.offset
+ *       streamBuffer.endFrame();
+ */
+class StreamBuffer {
+  public:
+    struct Allocation {
+        void *data = nullptr;
+        GLintptr offset = 0; // In the buffer, for glVertexAttribPointer or glBindBufferRange
+        GLsizeiptr size = 0;
+
+        bool valid() const { return data != nullptr; }
+    };
+
+    static const int FRAME_REGIONS = 3;
+
+    StreamBuffer();
+    ~StreamBuffer();
+
+    StreamBuffer(StreamBuffer const &) = delete;
+    void operator=(StreamBuffer const &) = delete;
+
+    /* Allocates regionCount regions of regionSize bytes, needs a current context */
+    bool create(GLsizeiptr regionSize, int regionCount = FRAME_REGIONS);
+    void destroy();
+
+    /* Moves to the next region, waiting for the GPU to be done with it if needed */
+    void beginFrame();
+
+    /* Sub-allocation of the current region, invalid when the region is full */
+    Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+
+    /* Aligned for glBindBufferRange(GL_UNIFORM_BUFFER, ...) */
+    Allocation allocateUniform(GLsizeiptr size);
+
+    /* Makes the writes visible to the following draws, nothing to do for a persistent coherent mapping */
+    void flush();
+
+    /* Fences the region after the last draw reading from it */
+    void endFrame();
+
+    void bindRange(GLenum target, GLuint index, Allocation const &allocation) const;
+
+    GLuint id() const { return buffer; }
+    bool isPersistent() const { return persistent; }
+    GLsizeiptr getRegionSize() const { return regionSize; }
+    GLsizeiptr getUsedSize() const { return head; }
+
+    /* Frames that had to wait for the GPU, the ring is too short when it grows */
+    int getStallCount() const { return stalls; }
+
+    static bool persistentMappingSupported();
+
+  private:
+    static const int MAX_REGIONS = 8;
+
+    GLuint buffer;
+    bool persistent;
+    char *persistentData;
+
+    GLsizeiptr regionSize;
+    int regionCount;
+    int region;
+    GLsync fences[MAX_REGIONS];
+    GLsizeiptr head; // Used bytes of the current region
+
+    // Unsynchronized mapping of the 3.3 path, from mappedOffset to the end of the region
+    char *mappedData;
+    GLsizeiptr mappedOffset;
+
+    int stalls;
+    bool full;
+
+    GLintptr regionOffset() const { return GLintptr(region) * regionSize; }
+};
+
+#endif
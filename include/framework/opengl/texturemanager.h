@@ -10,6 +10,7 @@
 #include <map>
 #include <vector>
 
+#include "framework/opengl/texturestreamer.h"
 #include "qulkan/utils.h"
 
 class TextureManager {
@@ -18,6 +19,7 @@ class TextureManager {
     int m_max;
     std::map<std::string, int> m_textures_map;
     std::map<std::string, std::string> m_path_map;
+    std::map<std::string, TextureStreamer::Handle> m_streamed_map;
 
   public:
     TextureManager() : m_max(0){};
@@ -40,9 +42,44 @@ class TextureManager {
         textures.resize(m_max);
     }
 
+    /* Streams the image in the background, the name refers to a placeholder until the texture is resident. Views loading the same
+     * path with the same parameters share the texture */
+    void loadTexture(std::string textureName, std::string path, TextureParameters const &parameters = TextureParameters()) {
+        TextureStreamer::Handle handle = TextureStreamer::Instance().acquire(path, parameters);
+        auto streamed = m_streamed_map.find(textureName);
+        if (streamed != m_streamed_map.end())
+            TextureStreamer::Instance().release(streamed->second);
+        m_streamed_map[textureName] = handle;
+        m_path_map[textureName] = path;
+    }
+
+    bool isResident(const std::string textureName) {
+        auto streamed = m_streamed_map.find(textureName);
+        return streamed == m_streamed_map.end() || TextureStreamer::Instance().isResident(streamed->second);
+    }
+
+    /* Whether a streamed texture is still decoded or uploaded, views drawn with placeholders redraw until then */
+    bool isLoading() {
+        for (auto const &streamed : m_streamed_map)
+            if (TextureStreamer::Instance().isLoading(streamed.second))
+                return true;
+        return false;
+    }
+
+    /* Gives the streamed textures back, they are kept until the next frame in case the view loads them again */
+    void releaseStreamed() {
+        for (auto const &streamed : m_streamed_map)
+            TextureStreamer::Instance().release(streamed.second);
+        m_streamed_map.clear();
+    }
+
     GLuint operator()(const std::string textureName) { return textureID(textureName); }
 
     GLuint textureID(const std::string textureName) {
+        auto streamed = m_streamed_map.find(textureName);
+        if (streamed != m_streamed_map.end())
+            return TextureStreamer::Instance().texture(streamed->second);
+
         ASSERT(m_textures_map.find(textureName) != m_textures_map.end(), "No texture with that name found");
 
         return textures[m_textures_map[textureName]];
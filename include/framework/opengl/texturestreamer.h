@@ -0,0 +1,165 @@
+#pragma once
+
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+
+#include <GL/gl3w.h>
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/*! \brief Sampling state of a streamed texture, part of the key under which the textures are shared */
+struct TextureParameters {
+    GLint wrapS = GL_REPEAT;
+    GLint wrapT = GL_REPEAT;
+    GLint minFilter = GL_LINEAR;
+    GLint magFilter = GL_LINEAR;
+    glm::vec4 borderColor = glm::vec4(0.0f);
+    bool mipmaps = true;
+};
+
+/*! \brief Loads image files into textures in the background, shared by every view requesting the same file
+ *
+ *  The files are decoded by a pool of worker threads. update() uploads the decoded images through a ring of pixel unpack buffers,
+ *  a few rows at a time within a byte budget per frame, so a large image is spread over several frames instead of stalling one.
+ *  Until its last row is uploaded (and its mipmaps generated) a texture is drawn as a 1x1 grey placeholder.
+ *
+ *  Requests of the same path and parameters share one GL texture, counted by acquire() and release(). A texture released by
+ *  every view is only deleted by the next update(), so a view recompiled by clean() then init() gets it back without reloading.
+ *  TextureManager::loadTexture() goes through it, update() has to be called once per frame with the GL context current.
+ *
+ *       TextureStreamer::Handle image = TextureStreamer::Instance().acquire("../data/images/raw_vulkan.jpg");
+ *       ...
+ *       glBindTexture(GL_TEXTURE_2D, TextureStreamer::Instance().texture(image));
+ *       ...
+ *       TextureStreamer::Instance().release(image);
+ */
+class TextureStreamer {
+  public:
+    typedef std::uint32_t Handle;
+
+    static constexpr Handle INVALID = 0xFFFFFFFFu;
+
+    static TextureStreamer &Instance() {
+        static TextureStreamer instance;
+        return instance;
+    }
+
+    TextureStreamer(TextureStreamer const &) = delete;
+    void operator=(TextureStreamer const &) = delete;
+
+    /* Requests the texture of an image file, needs the GL context to be current */
+    Handle acquire(std::string const &path, TextureParameters const &parameters = TextureParameters());
+    void release(Handle handle);
+
+    /* The texture once resident, the placeholder until then (or when the file couldn't be decoded) */
+    GLuint texture(Handle handle);
+    bool isResident(Handle handle) const;
+    /* Not yet resident nor failed */
+    bool isLoading(Handle handle) const;
+
+    /* Uploads the decoded images within the budget and deletes the released textures, once per frame */
+    void update();
+
+    /* Blocks until every requested texture is resident, e.g. before the deterministic frames of the headless mode */
+    void finish();
+
+    /* Bytes uploaded per update(), at least one row of the current image is uploaded per frame */
+    void setUploadBudget(std::size_t bytes) { uploadBudget = bytes; }
+    std::size_t getUploadBudget() const { return uploadBudget; }
+
+    /* Textures waiting to be decoded or uploaded */
+    std::size_t pending() const;
+
+    /* Waits for the workers and deletes every texture and buffer. Needs the GL context to be current */
+    void shutdown();
+
+  private:
+    static const int RING_SIZE = 3;
+
+    enum State { DECODING, DECODED, RESIDENT, FAILED };
+
+    struct Image {
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        unsigned char *pixels = nullptr; // From stbi_load
+
+        ~Image();
+    };
+
+    struct Entry {
+        std::string key;
+        std::string path;
+        TextureParameters parameters;
+        int references = 0; // Freed by update() once released by every view and decoded
+        State state = DECODING;
+        GLuint texture = 0;
+        std::shared_ptr<Image> image;
+        int uploadedRows = 0;
+    };
+
+    struct Job {
+        Handle handle;
+        std::string path;
+    };
+
+    struct Decoded {
+        Handle handle;
+        std::shared_ptr<Image> image; // Without pixels when the decode failed
+    };
+
+    struct Slot {
+        GLuint pbo = 0;
+        GLsizeiptr capacity = 0;
+        GLsync fence = nullptr;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<Handle> freeEntries;
+    std::map<std::string, Handle> entriesByKey;
+    std::deque<Handle> uploads; // Decoded, in completion order
+    GLuint placeholder;
+    std::size_t uploadBudget;
+
+    std::array<Slot, RING_SIZE> ring;
+    int nextSlot;
+
+    std::vector<std::thread> workers;
+    std::mutex jobsMutex;
+    std::condition_variable jobsCondition;
+    std::deque<Job> jobs;
+    bool stopWorkers;
+
+    mutable std::mutex decodedMutex;
+    std::condition_variable decodedCondition;
+    std::deque<Decoded> decoded;
+    std::size_t decoding; // Jobs not yet in decoded
+
+    TextureStreamer();
+    ~TextureStreamer();
+
+    void startWorkers();
+    void stopWorkersAndJoin();
+    void workerLoop();
+
+    GLuint getPlaceholder();
+
+    void collectDecoded(bool wait);
+    void deleteReleased();
+    /* Uploads the next rows of the image within the budget, returns true once the image is done with */
+    bool upload(Entry &entry, std::size_t &budget, bool wait);
+};
+
+#endif
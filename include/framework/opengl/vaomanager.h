@@ -11,6 +11,48 @@
 
 #include "vertex.h"
 
+namespace glf {
+
+    inline GLenum glComponentType(component Type) {
+        switch (Type) {
+        case component::DOUBLE:
+            return GL_DOUBLE;
+        case component::INT8:
+            return GL_BYTE;
+        case component::UINT8:
+            return GL_UNSIGNED_BYTE;
+        case component::INT16:
+            return GL_SHORT;
+        case component::UINT16:
+            return GL_UNSIGNED_SHORT;
+        case component::INT32:
+            return GL_INT;
+        case component::UINT32:
+            return GL_UNSIGNED_INT;
+        default:
+            return GL_FLOAT;
+        }
+    }
+
+    /* Points the attributes of the vertex layout at the buffer bound to GL_ARRAY_BUFFER and enables them in the bound VAO.
+     * Integer attributes that aren't normalized stay integers in the shader, a divisor of 1 makes the attributes per instance.
+     * The vertices start at the byte offset base of the buffer, e.g. a sub-allocation of a StreamBuffer */
+    template <typename Vertex> void setupVertexAttributes(GLuint divisor = 0, GLintptr base = 0) {
+        typedef checked_layout<Vertex> layout;
+        for (vertex_attribute const &Attribute : layout::attributes) {
+            void const *pointer = reinterpret_cast<void const *>(base + GLintptr(Attribute.offset));
+            if (Attribute.integer() && !Attribute.normalized)
+                glVertexAttribIPointer(Attribute.location, Attribute.count, glComponentType(Attribute.type), GLsizei(layout::stride), pointer);
+            else
+                glVertexAttribPointer(Attribute.location, Attribute.count, glComponentType(Attribute.type), Attribute.normalized ? GL_TRUE : GL_FALSE,
+                                      GLsizei(layout::stride), pointer);
+            glVertexAttribDivisor(Attribute.location, divisor);
+            glEnableVertexAttribArray(Attribute.location);
+        }
+    }
+
+} // namespace glf
+
 template <typename T> class VAOManager {
 
   private:
@@ -31,6 +73,9 @@ template <typename T> class VAOManager {
         ++m_vertexCount;
     }
 
+    /* Sets up the attributes of T from its glf::vertex_layout, with the VAO and the vertex buffer bound */
+    void setupAttributes(GLuint divisor = 0) const { glf::setupVertexAttributes<T>(divisor); }
+
     std::size_t getVertexCount() { return m_vertexCount; }
     std::size_t getVertexSize() { return sizeof(T); }
     std::size_t getVertexDataSize() { return m_vertexSize; }
@@ -2,11 +2,18 @@
 
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/type_precision.hpp>
+#include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 
+#include <cstddef>
+#include <cstdint>
 #include <variant>
+
+#include "framework/opengl/semantics.h"
+#include "framework/vertexlayout.h"
+
 namespace glf {
 
     struct vertex_v2fv2f {
@@ -44,11 +51,28 @@ namespace glf {
         glm::vec3 Texcoord;
     };
 
+    struct vertex_v3fc3f {
+        vertex_v3fc3f(glm::vec3 const &Position, glm::vec3 const &Color) : Position(Position), Color(Color) {}
+
+        glm::vec3 Position;
+        glm::vec3 Color;
+    };
+
     struct vertex_v3fn3f {
-        vertex_v3fn3f(glm::vec3 const &Position, glm::vec3 const &Texcoord) : Position(Position), Texcoord(Texcoord) {}
+        vertex_v3fn3f(glm::vec3 const &Position, glm::vec3 const &Normal) : Position(Position), Normal(Normal) {}
 
         glm::vec3 Position;
-        glm::vec3 Texcoord;
+        glm::vec3 Normal;
+    };
+
+    struct vertex_v3fn3fv2f {
+        vertex_v3fn3fv2f() {}
+        vertex_v3fn3fv2f(glm::vec3 const &Position, glm::vec3 const &Normal, glm::vec2 const &Texcoord)
+            : Position(Position), Normal(Normal), Texcoord(Texcoord) {}
+
+        glm::vec3 Position;
+        glm::vec3 Normal;
+        glm::vec2 Texcoord;
     };
 
     struct vertex_v3fv3fv1i {
@@ -126,6 +150,145 @@ namespace glf {
         glm::vec4 Color;
     };
 
+    /* Per instance attributes of the instanced draws (InstanceRenderer), read with a divisor of 1 */
+    struct instance_m4fc4fu1 {
+        instance_m4fc4fu1() {}
+        instance_m4fc4fu1(glm::mat4 const &Transform, glm::vec4 const &Color, std::uint32_t Material)
+            : Transform(Transform), Color(Color), Material(Material) {}
+
+        glm::mat4 Transform;
+        glm::vec4 Color;
+        std::uint32_t Material;
+    };
+
+    // Attribute layouts, the shader locations follow semantic::attr
+    template <> struct vertex_layout<vertex_v2fv2f> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v2fv2f, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v2fv2f, Texcoord, semantic::attr::TEXCOORD)};
+    };
+
+    template <> struct vertex_layout<vertex_v3fv2f> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v3fv2f, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v3fv2f, Texcoord, semantic::attr::TEXCOORD)};
+    };
+
+    template <> struct vertex_layout<vertex_v3fv4u8> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v3fv4u8, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE_NORMALIZED(vertex_v3fv4u8, Color, semantic::attr::COLOR)};
+    };
+
+    template <> struct vertex_layout<vertex_v2fv3f> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v2fv3f, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v2fv3f, Texcoord, semantic::attr::TEXCOORD)};
+    };
+
+    template <> struct vertex_layout<vertex_v3fv3f> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v3fv3f, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v3fv3f, Texcoord, semantic::attr::TEXCOORD)};
+    };
+
+    template <> struct vertex_layout<vertex_v3fc3f> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v3fc3f, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v3fc3f, Color, semantic::attr::COLOR)};
+    };
+
+    template <> struct vertex_layout<vertex_v3fn3f> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v3fn3f, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v3fn3f, Normal, semantic::attr::NORMAL)};
+    };
+
+    template <> struct vertex_layout<vertex_v3fn3fv2f> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v3fn3fv2f, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v3fn3fv2f, Normal, semantic::attr::NORMAL),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v3fn3fv2f, Texcoord, semantic::attr::TEXCOORD)};
+    };
+
+    template <> struct vertex_layout<vertex_v3fv3fv1i> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v3fv3fv1i, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v3fv3fv1i, Texcoord, semantic::attr::TEXCOORD),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v3fv3fv1i, DrawID, semantic::attr::DRAW_ID)};
+    };
+
+    template <> struct vertex_layout<vertex_v4fv2f> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v4fv2f, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v4fv2f, Texcoord, semantic::attr::TEXCOORD)};
+    };
+
+    template <> struct vertex_layout<vertex_v2fc4f> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v2fc4f, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v2fc4f, Color, semantic::attr::COLOR)};
+    };
+
+    template <> struct vertex_layout<vertex_v2fc4d> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v2fc4d, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v2fc4d, Color, semantic::attr::COLOR)};
+    };
+
+    template <> struct vertex_layout<vertex_v4fc4f> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v4fc4f, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v4fc4f, Color, semantic::attr::COLOR)};
+    };
+
+    template <> struct vertex_layout<vertex_v2fc4ub> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v2fc4ub, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE_NORMALIZED(vertex_v2fc4ub, Color, semantic::attr::COLOR)};
+    };
+
+    template <> struct vertex_layout<vertex_v2fv2fv4ub> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v2fv2fv4ub, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v2fv2fv4ub, Texcoord, semantic::attr::TEXCOORD),
+                                                          GLF_VERTEX_ATTRIBUTE_NORMALIZED(vertex_v2fv2fv4ub, Color, semantic::attr::COLOR)};
+    };
+
+    template <> struct vertex_layout<vertex_v2fv2fv4f> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v2fv2fv4f, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v2fv2fv4f, Texcoord, semantic::attr::TEXCOORD),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v2fv2fv4f, Color, semantic::attr::COLOR)};
+    };
+
+    template <> struct vertex_layout<vertex_v4fv4f> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v4fv4f, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v4fv4f, Texcoord, semantic::attr::TEXCOORD)};
+    };
+
+    template <> struct vertex_layout<vertex_v4fv4fv4f> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v4fv4fv4f, Position, semantic::attr::POSITION),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v4fv4fv4f, Texcoord, semantic::attr::TEXCOORD),
+                                                          GLF_VERTEX_ATTRIBUTE(vertex_v4fv4fv4f, Color, semantic::attr::COLOR)};
+    };
+
+    // A matrix takes one location per column
+    template <> struct vertex_layout<instance_m4fc4fu1> {
+        static constexpr vertex_attribute attributes[] = {
+            make_vertex_attribute<glm::vec4>(semantic::attr::INSTANCE_TRANSFORM + 0, offsetof(instance_m4fc4fu1, Transform) + 0 * sizeof(glm::vec4), false),
+            make_vertex_attribute<glm::vec4>(semantic::attr::INSTANCE_TRANSFORM + 1, offsetof(instance_m4fc4fu1, Transform) + 1 * sizeof(glm::vec4), false),
+            make_vertex_attribute<glm::vec4>(semantic::attr::INSTANCE_TRANSFORM + 2, offsetof(instance_m4fc4fu1, Transform) + 2 * sizeof(glm::vec4), false),
+            make_vertex_attribute<glm::vec4>(semantic::attr::INSTANCE_TRANSFORM + 3, offsetof(instance_m4fc4fu1, Transform) + 3 * sizeof(glm::vec4), false),
+            GLF_VERTEX_ATTRIBUTE(instance_m4fc4fu1, Color, semantic::attr::INSTANCE_COLOR),
+            GLF_VERTEX_ATTRIBUTE(instance_m4fc4fu1, Material, semantic::attr::INSTANCE_MATERIAL)};
+    };
+
+    // Every layout is validated here rather than on first use
+    static_assert(checked_layout<vertex_v2fv2f>::count == 2, "vertex_v2fv2f layout");
+    static_assert(checked_layout<vertex_v3fv2f>::count == 2, "vertex_v3fv2f layout");
+    static_assert(checked_layout<vertex_v3fv4u8>::count == 2, "vertex_v3fv4u8 layout");
+    static_assert(checked_layout<vertex_v2fv3f>::count == 2, "vertex_v2fv3f layout");
+    static_assert(checked_layout<vertex_v3fv3f>::count == 2, "vertex_v3fv3f layout");
+    static_assert(checked_layout<vertex_v3fc3f>::count == 2, "vertex_v3fc3f layout");
+    static_assert(checked_layout<vertex_v3fn3f>::count == 2, "vertex_v3fn3f layout");
+    static_assert(checked_layout<vertex_v3fn3fv2f>::count == 3, "vertex_v3fn3fv2f layout");
+    static_assert(checked_layout<vertex_v3fv3fv1i>::count == 3, "vertex_v3fv3fv1i layout");
+    static_assert(checked_layout<vertex_v4fv2f>::count == 2, "vertex_v4fv2f layout");
+    static_assert(checked_layout<vertex_v2fc4f>::count == 2, "vertex_v2fc4f layout");
+    static_assert(checked_layout<vertex_v2fc4d>::count == 2, "vertex_v2fc4d layout");
+    static_assert(checked_layout<vertex_v4fc4f>::count == 2, "vertex_v4fc4f layout");
+    static_assert(checked_layout<vertex_v2fc4ub>::count == 2, "vertex_v2fc4ub layout");
+    static_assert(checked_layout<vertex_v2fv2fv4ub>::count == 3, "vertex_v2fv2fv4ub layout");
+    static_assert(checked_layout<vertex_v2fv2fv4f>::count == 3, "vertex_v2fv2fv4f layout");
+    static_assert(checked_layout<vertex_v4fv4f>::count == 2, "vertex_v4fv4f layout");
+    static_assert(checked_layout<vertex_v4fv4fv4f>::count == 3, "vertex_v4fv4fv4f layout");
+    static_assert(checked_layout<instance_m4fc4fu1>::count == 6, "instance_m4fc4fu1 layout");
+
     // typedef std::variant<vertex_v2fv2f, vertex_v3fv2f, vertex_v3fv4u8, vertex_v2fv3f, vertex_v3fv3f, vertex_v3fn3f, vertex_v3fv3fv1i, vertex_v4fv2f,
     //                      vertex_v2fc4f, vertex_v2fc4d, vertex_v4fc4f, vertex_v2fc4ub, vertex_v2fv2fv4ub, vertex_v2fv2fv4f, vertex_v4fv4f, vertex_v4fv4fv4f>
     //     vertex_data;
@@ -0,0 +1,84 @@
+#pragma once
+
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/*! \brief Hierarchy of transforms with cached world and normal matrices
+ *
+ *  The transforms are stored in contiguous arrays sorted by depth, the parents before their children. update() propagates the
+ *  dirty flags of the modified local transforms down to the children in one pass over the arrays, then recomputes the world
+ *  and normal matrices of the dirty nodes only, level by level with SIMD matrix products (SSE, or AVX when compiled in).
+ *  Static nodes cost nothing once their matrices are cached.
+ *
+ *  Nodes are stable handles, the arrays are only reordered by the update() following a create() or a remove().
+ *
+ *       SceneGraph::Node car = scene.create();
+ *       SceneGraph::Node wheel = scene.create(car, glm::translate(glm::mat4(1.0f), wheelOffset));
+ *       ...
+ *       scene.setLocal(car, carTransform);
+ *       scene.update();
+ *       modelUniform.set(scene.getWorld(wheel));
+ *       normalMatrixUniform.set(scene.getNormalMatrix(wheel));
+ */
+class SceneGraph {
+  public:
+    typedef std::uint32_t Node;
+
+    static constexpr Node NONE = 0xFFFFFFFFu;
+
+    SceneGraph();
+
+    void clear();
+
+    /* Adds a node under parent (a root by default), its matrices are valid after the next update() */
+    Node create(Node parent = NONE, glm::mat4 const &local = glm::mat4(1.0f));
+
+    /* Removes the node and its descendants */
+    void remove(Node node);
+
+    void setLocal(Node node, glm::mat4 const &local);
+    glm::mat4 const &getLocal(Node node) const { return locals[indices[node]]; }
+
+    /* Cached by the last update() */
+    glm::mat4 const &getWorld(Node node) const { return worlds[indices[node]]; }
+    glm::mat3 const &getNormalMatrix(Node node) const { return normals[indices[node]]; }
+
+    Node getParent(Node node) const;
+
+    /* Recomputes the matrices of the modified nodes and of their descendants */
+    void update();
+
+    std::size_t getNodeCount() const { return nodes.size(); }
+    std::size_t getUpdatedCount() const { return updatedCount; } // By the last update()
+
+  private:
+    // By index, sorted by depth
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<glm::mat3> normals;
+    std::vector<std::uint32_t> parents; // Index of the parent, NONE for the roots
+    std::vector<std::uint32_t> depths;
+    std::vector<std::uint8_t> dirty;
+    std::vector<std::uint8_t> removed;
+    std::vector<Node> nodes;
+
+    // By node
+    std::vector<std::uint32_t> indices; // NONE for the free nodes
+    std::vector<Node> freeNodes;
+
+    std::vector<std::size_t> levels; // First index of each depth, and the node count at the end
+    bool reorder;
+
+    std::vector<std::uint32_t> updated;
+    std::size_t updatedCount;
+
+    void sortByDepth();
+};
+
+#endif
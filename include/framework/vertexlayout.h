@@ -0,0 +1,134 @@
+#pragma once
+
+#ifndef VERTEXLAYOUT_H
+#define VERTEXLAYOUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/*! \brief Compile time description of the attributes of a vertex struct
+ *
+ *  Each vertex struct specializes glf::vertex_layout once, the component type and count of every attribute are deduced from the
+ *  member types. The OpenGL attribute setup (glf::setupVertexAttributes) and the Vulkan binding and attribute descriptions
+ *  (VKHelper::ReflectedVertexFormat) are generated from it, and checked_layout rejects at compile time a layout that doesn't
+ *  describe its struct exactly.
+ *
+ *       template <> struct glf::vertex_layout<vertex_v3fv2f> {
+ *           static constexpr glf::vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(vertex_v3fv2f, Position, semantic::attr::POSITION),
+ *                                                                  GLF_VERTEX_ATTRIBUTE(vertex_v3fv2f, Texcoord, semantic::attr::TEXCOORD)};
+ *       };
+ */
+namespace glf {
+
+    enum class component { FLOAT, DOUBLE, INT8, UINT8, INT16, UINT16, INT32, UINT32 };
+
+    constexpr std::size_t component_size(component Type) {
+        switch (Type) {
+        case component::INT8:
+        case component::UINT8:
+            return 1;
+        case component::INT16:
+        case component::UINT16:
+            return 2;
+        case component::DOUBLE:
+            return 8;
+        default:
+            return 4;
+        }
+    }
+
+    struct vertex_attribute {
+        unsigned location;
+        component type;
+        unsigned count;
+        std::size_t offset;
+        std::size_t size;
+        bool normalized; // Integers read as floats in [0, 1] or [-1, 1]
+
+        constexpr bool integer() const { return type != component::FLOAT && type != component::DOUBLE; }
+    };
+
+    template <typename T> struct component_traits;
+    template <> struct component_traits<float> { static constexpr component type = component::FLOAT; };
+    template <> struct component_traits<double> { static constexpr component type = component::DOUBLE; };
+    template <> struct component_traits<std::int8_t> { static constexpr component type = component::INT8; };
+    template <> struct component_traits<std::uint8_t> { static constexpr component type = component::UINT8; };
+    template <> struct component_traits<std::int16_t> { static constexpr component type = component::INT16; };
+    template <> struct component_traits<std::uint16_t> { static constexpr component type = component::UINT16; };
+    template <> struct component_traits<std::int32_t> { static constexpr component type = component::INT32; };
+    template <> struct component_traits<std::uint32_t> { static constexpr component type = component::UINT32; };
+
+    // Scalars, and glm vectors through their value_type
+    template <typename T, typename = void> struct attribute_traits {
+        static constexpr component type = component_traits<T>::type;
+        static constexpr unsigned count = 1;
+    };
+    template <typename T> struct attribute_traits<T, std::void_t<typename T::value_type>> {
+        static constexpr component type = component_traits<typename T::value_type>::type;
+        static constexpr unsigned count = unsigned(sizeof(T) / sizeof(typename T::value_type));
+    };
+
+    template <typename Member> constexpr vertex_attribute make_vertex_attribute(unsigned Location, std::size_t Offset, bool Normalized) {
+        return vertex_attribute{Location, attribute_traits<Member>::type, attribute_traits<Member>::count, Offset, sizeof(Member), Normalized};
+    }
+
+    /* Attribute read from a member of the vertex struct at a shader location */
+#define GLF_VERTEX_ATTRIBUTE(Vertex, Member, Location) glf::make_vertex_attribute<decltype(Vertex::Member)>(Location, offsetof(Vertex, Member), false)
+#define GLF_VERTEX_ATTRIBUTE_NORMALIZED(Vertex, Member, Location) glf::make_vertex_attribute<decltype(Vertex::Member)>(Location, offsetof(Vertex, Member), true)
+
+    /* Specialized for every vertex struct, with a static constexpr vertex_attribute attributes[] */
+    template <typename Vertex> struct vertex_layout;
+
+    namespace detail {
+        template <typename Vertex> constexpr std::size_t attribute_count() { return sizeof(vertex_layout<Vertex>::attributes) / sizeof(vertex_attribute); }
+
+        template <typename Vertex> constexpr bool counts_valid() {
+            for (vertex_attribute const &Attribute : vertex_layout<Vertex>::attributes)
+                if (Attribute.count < 1 || Attribute.count > 4 || Attribute.size != Attribute.count * component_size(Attribute.type))
+                    return false;
+            return true;
+        }
+
+        template <typename Vertex> constexpr bool attributes_inside() {
+            for (vertex_attribute const &Attribute : vertex_layout<Vertex>::attributes)
+                if (Attribute.offset + Attribute.size > sizeof(Vertex) || Attribute.offset % component_size(Attribute.type) != 0)
+                    return false;
+            return true;
+        }
+
+        template <typename Vertex> constexpr bool attributes_disjoint() {
+            constexpr std::size_t Count = attribute_count<Vertex>();
+            for (std::size_t i = 0; i < Count; ++i)
+                for (std::size_t j = i + 1; j < Count; ++j) {
+                    vertex_attribute const &a = vertex_layout<Vertex>::attributes[i];
+                    vertex_attribute const &b = vertex_layout<Vertex>::attributes[j];
+                    if (a.location == b.location || (a.offset < b.offset + b.size && b.offset < a.offset + a.size))
+                        return false;
+                }
+            return true;
+        }
+
+        template <typename Vertex> constexpr bool attributes_cover() {
+            std::size_t Size = 0;
+            for (vertex_attribute const &Attribute : vertex_layout<Vertex>::attributes)
+                Size += Attribute.size;
+            return Size == sizeof(Vertex);
+        }
+    } // namespace detail
+
+    /* The layout of a vertex struct, validated. Used instead of vertex_layout by the code generating the GPU descriptions */
+    template <typename Vertex> struct checked_layout : vertex_layout<Vertex> {
+        static_assert(std::is_standard_layout<Vertex>::value, "vertex structs must be standard layout (no virtual functions) for offsetof to be valid");
+        static_assert(detail::counts_valid<Vertex>(), "vertex attributes have 1 to 4 components of one scalar type");
+        static_assert(detail::attributes_inside<Vertex>(), "vertex attribute outside of its struct or misaligned");
+        static_assert(detail::attributes_disjoint<Vertex>(), "vertex attributes overlap or share a location");
+        static_assert(detail::attributes_cover<Vertex>(), "vertex layout doesn't declare every member of its struct, or the struct has padding");
+
+        static constexpr std::size_t count = detail::attribute_count<Vertex>();
+        static constexpr std::size_t stride = sizeof(Vertex);
+    };
+
+} // namespace glf
+
+#endif
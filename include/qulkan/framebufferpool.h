@@ -0,0 +1,134 @@
+#pragma once
+
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#include <GL/gl3w.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Qulkan {
+
+    /*! \brief Declarative description of the attachments of a render target
+     *
+     *  Each color format is a texture bound to GL_COLOR_ATTACHMENT0 + i, every one of them written in a single pass (e.g. a G-buffer).
+     *  Depth is a renderbuffer unless depthTexture is set, GL_NONE leaves it out. With samples > 1 the view renders into multisampled
+     *  renderbuffers which are resolved into the textures after render().
+     *
+     *       Qulkan::AttachmentSpec spec;
+     *       spec.colorFormats = {GL_RGBA16F, GL_R11F_G11F_B10F};
+     *       spec.depthTexture = true;
+     *       spec.samples = 4;
+     *       setAttachments(spec);
+     */
+    struct AttachmentSpec {
+        std::vector<GLenum> colorFormats = {GL_RGBA8};
+        GLenum depthFormat = GL_DEPTH24_STENCIL8;
+        bool depthTexture = false;
+        int samples = 1;
+
+        bool multisampled() const { return samples > 1; }
+        bool operator==(const AttachmentSpec &other) const {
+            return colorFormats == other.colorFormats && depthFormat == other.depthFormat && depthTexture == other.depthTexture && samples == other.samples;
+        }
+        bool operator!=(const AttachmentSpec &other) const { return !(*this == other); }
+    };
+
+    /*! \brief Framebuffer with the attachments of an AttachmentSpec
+     *
+     *  The attachments are allocated at the size class of the requested size, the rendered area is the lower left width x height corner.
+     *  framebuffer always holds the single sampled textures, multisampled targets are drawn through drawFramebuffer() and resolve().
+     */
+    struct RenderTarget {
+        GLuint framebuffer = 0;
+        std::vector<GLuint> colors;
+        GLuint depth = 0; // texture or renderbuffer, see spec.depthTexture
+
+        // Multisampled renderbuffers, only when spec.samples > 1
+        GLuint multisampleFramebuffer = 0;
+        std::vector<GLuint> multisampleColors;
+        GLuint multisampleDepth = 0;
+
+        AttachmentSpec spec;
+        int width = 0;
+        int height = 0;
+        int allocatedWidth = 0;
+        int allocatedHeight = 0;
+
+        bool valid() const { return framebuffer != 0; }
+        GLuint color(int index = 0) const { return index >= 0 && index < int(colors.size()) ? colors[index] : 0; }
+        GLuint depthTexture() const { return spec.depthTexture ? depth : 0; }
+
+        /* Framebuffer to bind for rendering */
+        GLuint drawFramebuffer() const { return multisampleFramebuffer != 0 ? multisampleFramebuffer : framebuffer; }
+
+        /* Resolves the multisampled attachments into the textures, does nothing for single sampled targets */
+        void resolve() const;
+    };
+
+    /* Blits every color attachment of the read framebuffer into the same attachment of the draw one, and the depth when requested.
+     * Depth is always copied with GL_NEAREST as required by glBlitFramebuffer */
+    void blitAttachments(GLuint readFramebuffer, int readWidth, int readHeight, GLuint drawFramebuffer, int drawWidth, int drawHeight, int colorCount,
+                         bool depth, GLenum filter);
+
+    /*! \brief Recycles the render targets of the views
+     *
+     *  Sizes are rounded up to a multiple of SIZE_CLASS so a target released by a resize is reused for any size of the same class.
+     *  A released target can still be referenced by the ImGui draw data of the current frame, it only becomes available again on the
+     *  next update(). Targets left unused for IDLE_FRAMES frames are deleted, trim() and shutdown() free them right away.
+     */
+    class FramebufferPool {
+      public:
+        static FramebufferPool &Instance() {
+            static FramebufferPool instance;
+            return instance;
+        }
+
+        FramebufferPool(FramebufferPool const &) = delete;
+        void operator=(FramebufferPool const &) = delete;
+
+        RenderTarget acquire(int width, int height, const AttachmentSpec &spec = AttachmentSpec());
+        void release(RenderTarget &target);
+
+        /* Recycles the targets released during the previous frame and deletes the idle ones, once per frame */
+        void update();
+
+        /* Deletes every target not in use */
+        void trim();
+
+        /* Deletes every target, the ones still in use are dropped when released */
+        void shutdown();
+
+        int allocatedTargets() const { return allocatedCount; }
+        int pooledTargets() const { return int(available.size() + retired.size()); }
+        std::size_t allocatedBytes() const { return allocatedMemory; }
+
+        /* Samples actually used for a request, clamped to GL_MAX_SAMPLES */
+        static int supportedSamples(int samples);
+
+        static const int SIZE_CLASS = 64;
+        static const int IDLE_FRAMES = 120;
+
+      private:
+        struct Entry {
+            RenderTarget target;
+            uint64_t frame; // frame of the release
+        };
+
+        std::vector<Entry> available;
+        std::vector<Entry> retired;
+        int allocatedCount;
+        std::size_t allocatedMemory;
+        bool stopped;
+
+        FramebufferPool() : allocatedCount(0), allocatedMemory(0), stopped(false) {}
+
+        RenderTarget create(int allocatedWidth, int allocatedHeight, const AttachmentSpec &spec);
+        void destroy(RenderTarget &target);
+        static std::size_t targetBytes(const RenderTarget &target);
+    };
+
+} // namespace Qulkan
+
+#endif
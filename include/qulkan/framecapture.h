@@ -0,0 +1,105 @@
+#pragma once
+
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <GL/gl3w.h>
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "qulkan/render_view.h"
+
+namespace Qulkan {
+
+    /*! \brief 8-bit RGBA pixels of a captured framebuffer, bottom row first as returned by OpenGL */
+    struct CapturedImage {
+        int width;
+        int height;
+        int channels;
+        std::vector<unsigned char> pixels;
+    };
+
+    /*! \brief Non-stalling framebuffer readback
+     *
+     *  A capture only records a glReadPixels into a pixel pack buffer followed by a fence, so the GPU keeps running.
+     *  update() has to be called once per frame: it polls the fences without waiting, maps the buffers whose copy
+     *  completed (usually one or two frames later) and hands the pixels over to a background thread for encoding.
+     *
+     *       Qulkan::FrameCapture::Instance().savePNG(renderView, "image.png");
+     *
+     */
+    class FrameCapture {
+      public:
+        typedef std::function<void(CapturedImage &&)> Callback;
+
+        static FrameCapture &Instance() {
+            static FrameCapture instance;
+            return instance;
+        }
+
+        FrameCapture(FrameCapture const &) = delete;
+        void operator=(FrameCapture const &) = delete;
+
+        /* Queues the readback of the current content of a view, the callback is called on the main thread once the pixels are available.
+         * Returns false if all the pixel buffers are in flight */
+        bool capture(const RenderView &renderView, Callback callback);
+
+        /* Captures a view and writes it as a png file from the encoding thread */
+        bool savePNG(const RenderView &renderView, const std::string &filename);
+
+        /* Runs a job on the encoding thread */
+        void enqueueJob(std::function<void()> job);
+
+        /* Polls the pending readbacks, to be called once per frame with the GL context current */
+        void update();
+
+        /* Number of readbacks still waiting for the GPU */
+        int pending() const;
+
+        /* Returns true if a capture can be queued without being skipped */
+        bool available() const;
+
+        /* Blocks until the oldest pending readback completes and hands it over, for producers that must not skip frames */
+        void waitOldest();
+
+        /* Flushes the pending readbacks, waits for the encoding thread and releases the pixel buffers. Needs the GL context to be current */
+        void shutdown();
+
+      private:
+        static const int RING_SIZE = 4;
+
+        struct Slot {
+            GLuint pbo = 0;
+            GLsizeiptr capacity = 0;
+            GLsync fence = nullptr;
+            int width = 0;
+            int height = 0;
+            Callback callback;
+        };
+
+        std::array<Slot, RING_SIZE> ring;
+        int nextSlot;
+
+        std::thread worker;
+        std::mutex jobsMutex;
+        std::condition_variable jobsCondition;
+        std::deque<std::function<void()>> jobs;
+        bool stopWorker;
+
+        FrameCapture();
+        ~FrameCapture();
+
+        void readback(Slot &slot);
+        void workerLoop();
+    };
+
+} // namespace Qulkan
+
+#endif
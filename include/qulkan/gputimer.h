@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace Qulkan {
+
+    /*! \brief GPU duration of a sequence of commands measured with GL_TIME_ELAPSED queries
+     *
+     *  Queries are taken from a small ring and their results are only read once available, a few frames later,
+     *  so timing never stalls the pipeline. When every query of the ring is still in flight the measurement is skipped.
+     *  Only one timer can be running at a time, GL_TIME_ELAPSED queries can't be nested.
+     */
+    class GPUTimer {
+      public:
+        struct Sample {
+            uint64_t frame;
+            float milliseconds;
+        };
+
+        GPUTimer();
+        ~GPUTimer();
+
+        GPUTimer(GPUTimer const &) = delete;
+        void operator=(GPUTimer const &) = delete;
+
+        void begin();
+        void end();
+
+        /* Reads back the results of the completed queries, never waits */
+        void collect();
+
+        float minimum() const { return minMs; }
+        float average() const { return averageMs; }
+        float maximum() const { return maxMs; }
+
+        /* Durations of the last WINDOW_SIZE measurements, oldest first */
+        const std::vector<float> &window() const { return windowMs; }
+
+        /* Longer history kept for exports */
+        const std::deque<Sample> &history() const { return samples; }
+
+        void reset();
+
+        static const int WINDOW_SIZE = 120;
+        static const int HISTORY_SIZE = 4096;
+
+      private:
+        static const int RING_SIZE = 4;
+
+        std::array<unsigned int, RING_SIZE> queries;
+        std::array<uint64_t, RING_SIZE> queryFrames;
+        std::array<bool, RING_SIZE> pending;
+        int nextQuery;
+        int oldestQuery;
+        bool running;
+
+        std::deque<Sample> samples;
+        std::vector<float> windowMs;
+        float minMs, averageMs, maxMs;
+
+        void addSample(uint64_t frame, float milliseconds);
+    };
+
+} // namespace Qulkan
+
+#endif
@@ -12,6 +12,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 
@@ -42,18 +43,42 @@ inline const char *toString(Type type) {
     }
 }
 
+/*! \brief Maps a C++ value type to the handle types able to store it
+ *
+ *  COLOR3_HANDLE shares its storage with VEC3_HANDLE, TEXT_HANDLE values are not stored in typed storage.
+ */
+template <typename T> inline bool isHandleType(Type type) {
+    if constexpr (std::is_same_v<T, bool>)
+        return type == BOOL_HANDLE;
+    else if constexpr (std::is_same_v<T, int>)
+        return type == INT_HANDLE;
+    else if constexpr (std::is_same_v<T, float>)
+        return type == FLOAT_HANDLE;
+    else if constexpr (std::is_same_v<T, double>)
+        return type == DOUBLE_HANDLE;
+    else if constexpr (std::is_same_v<T, glm::vec2>)
+        return type == VEC2_HANDLE;
+    else if constexpr (std::is_same_v<T, glm::vec3>)
+        return type == VEC3_HANDLE || type == COLOR3_HANDLE;
+    else if constexpr (std::is_same_v<T, glm::vec4>)
+        return type == VEC4_HANDLE;
+    else
+        return false;
+}
+
 struct Handle {
 
     std::string name;
     std::string displayName;
     Type type;
-    std::any value;
+    std::any value;    // initial value, or the value itself for handles without typed storage (TEXT)
     std::any invValue; // only for bool
     std::any minValues;
     std::any maxValues;
     bool *active;
+    void *data; // typed storage owned by the HandleManager, set when the handle is added
 
-    Handle(std::string name, Type type, std::any value, bool *active = nullptr) : name(name), type(type), value(value), active(active) {
+    Handle(std::string name, Type type, std::any value, bool *active = nullptr) : name(name), type(type), value(value), active(active), data(nullptr) {
         displayName = name;
         // setting default min and max values and inverse
         switch (type) {
@@ -99,7 +124,10 @@ struct Handle {
         }
     }
     Handle(std::string name, Type type, std::any value, std::any minValues, std::any maxValues, bool *active = nullptr)
-        : name(name), type(type), value(value), minValues(minValues), maxValues(maxValues), active(active) {}
+        : name(name), type(type), value(value), minValues(minValues), maxValues(maxValues), active(active), data(nullptr) {
+        if (type == BOOL_HANDLE)
+            invValue = !std::any_cast<bool>(value);
+    }
     ~Handle() {}
 
     bool isActive() {
@@ -110,41 +138,186 @@ struct Handle {
         }
     }
 
+    /* Returns a pointer to the current value, in typed storage once the handle has been added to a HandleManager */
+    template <typename T> T *valuePtr() {
+        if (data != nullptr) {
+            ASSERT(isHandleType<T>(type), "Handle " + name + " is not of the requested type, it is of type " + toString(type));
+            return static_cast<T *>(data);
+        }
+        return std::any_cast<T>(&value);
+    }
+
+    /* Copies the current value of another handle of the same type, returns true if the value changed */
+    bool copyValue(Handle &other) {
+        switch (type) {
+        case BOOL_HANDLE:
+            invValue = !other.getValue<bool>();
+            return copyTypedValue<bool>(other);
+        case INT_HANDLE:
+            return copyTypedValue<int>(other);
+        case FLOAT_HANDLE:
+            return copyTypedValue<float>(other);
+        case DOUBLE_HANDLE:
+            return copyTypedValue<double>(other);
+        case VEC2_HANDLE:
+            return copyTypedValue<glm::vec2>(other);
+        case VEC3_HANDLE:
+        case COLOR3_HANDLE:
+            return copyTypedValue<glm::vec3>(other);
+        case VEC4_HANDLE:
+            return copyTypedValue<glm::vec4>(other);
+        default:
+            value = other.value;
+            return false;
+        }
+    }
+
+    template <typename T> bool copyTypedValue(Handle &other) {
+        T *dest = valuePtr<T>();
+        const T &src = *other.valuePtr<T>();
+        if (*dest == src)
+            return false;
+        *dest = src;
+        return true;
+    }
+
     template <typename T> T getInvValue() { return std::any_cast<T>(invValue); }
-    template <typename T> T getValue() { return std::any_cast<T>(value); }
+    template <typename T> T getValue() {
+        T *current = valuePtr<T>();
+        ASSERT(current != nullptr, "Handle " + name + " is not of the requested type, it is of type " + toString(type));
+        return *current;
+    }
     template <typename T> T getMinValues() { return std::any_cast<T>(minValues); }
     template <typename T> T getMaxValues() { return std::any_cast<T>(maxValues); }
 };
 
+/*! \brief Typed reference to the value of a handle
+ *
+ *  Resolve it once (typically in initHandles()) with handleManager.getRef<T>("name") and read it in render() with *ref,
+ *  which is a single load instead of a name lookup and an any_cast. A reference stays valid until the handles are emptied.
+ */
+template <typename T> class HandleRef {
+
+  private:
+    T *m_value;
+
+  public:
+    HandleRef() : m_value(nullptr) {}
+    explicit HandleRef(T *value) : m_value(value) {}
+
+    bool valid() const { return m_value != nullptr; }
+
+    T &operator*() const { return *m_value; }
+    T *operator->() const { return m_value; }
+    T *get() const { return m_value; }
+};
+
+/*! \brief Chunked storage of handle values of one type
+ *
+ *  Values are stored contiguously in fixed size chunks so that their address never changes when new handles are added.
+ */
+template <typename T> class HandleStorage {
+
+  private:
+    static constexpr std::size_t ChunkSize = 64;
+
+    std::vector<std::unique_ptr<T[]>> m_chunks;
+    std::size_t m_size;
+
+  public:
+    HandleStorage() : m_size(0) {}
+
+    T *allocate(const T &value) {
+        if (m_size == m_chunks.size() * ChunkSize)
+            m_chunks.push_back(std::make_unique<T[]>(ChunkSize));
+        T *slot = &m_chunks.back()[m_size % ChunkSize];
+        *slot = value;
+        ++m_size;
+        return slot;
+    }
+
+    void clear() {
+        m_chunks.clear();
+        m_size = 0;
+    }
+};
+
 class HandleManager {
 
   private:
     std::map<std::string, std::shared_ptr<Handle>> m_handles_map;
     std::vector<std::shared_ptr<Handle>> m_handles;
 
+    std::tuple<HandleStorage<bool>, HandleStorage<int>, HandleStorage<float>, HandleStorage<double>, HandleStorage<glm::vec2>, HandleStorage<glm::vec3>,
+               HandleStorage<glm::vec4>>
+        m_storages;
+
+    template <typename T> void *store(Handle &handle) { return std::get<HandleStorage<T>>(m_storages).allocate(std::any_cast<T>(handle.value)); }
+
   public:
     HandleManager() {}
+    HandleManager(const HandleManager &) = delete;
+    HandleManager &operator=(const HandleManager &) = delete;
     ~HandleManager() {}
+
     void addHandle(Handle handle) {
+        switch (handle.type) {
+        case BOOL_HANDLE:
+            handle.data = store<bool>(handle);
+            break;
+        case INT_HANDLE:
+            handle.data = store<int>(handle);
+            break;
+        case FLOAT_HANDLE:
+            handle.data = store<float>(handle);
+            break;
+        case DOUBLE_HANDLE:
+            handle.data = store<double>(handle);
+            break;
+        case VEC2_HANDLE:
+            handle.data = store<glm::vec2>(handle);
+            break;
+        case VEC3_HANDLE:
+        case COLOR3_HANDLE:
+            handle.data = store<glm::vec3>(handle);
+            break;
+        case VEC4_HANDLE:
+            handle.data = store<glm::vec4>(handle);
+            break;
+        default:
+            break;
+        }
         auto newHandle = std::make_shared<Handle>(handle);
         m_handles_map[handle.name] = newHandle;
         m_handles.push_back(newHandle);
     }
 
+    /* Removes all handles, invalidating every HandleRef obtained from this manager */
     void emptyHandles() {
         m_handles_map.clear();
         m_handles.clear();
+        std::apply([](auto &...storage) { (storage.clear(), ...); }, m_storages);
     }
 
-    std::vector<std::shared_ptr<Handle>> getHandles() const { return m_handles; }
+    const std::vector<std::shared_ptr<Handle>> &getHandles() const { return m_handles; }
+
+    std::shared_ptr<Handle> getHandle(const std::string &name) {
+        auto it = m_handles_map.find(name);
+        if (it == m_handles_map.end()) {
+            ASSERT(false, "No handle with that name found: " + name);
+            return nullptr;
+        }
+        return it->second;
+    }
 
-    std::shared_ptr<Handle> getHandle(std::string name) {
-        std::string message = "No handle with that name found: " + name;
-        ASSERT(m_handles_map.find(name) != m_handles_map.end(), message);
-        return m_handles_map[name];
+    /* Resolves a typed reference to the value of a handle, to be done once outside of the render loop */
+    template <typename T> HandleRef<T> getRef(const std::string &name) {
+        std::shared_ptr<Handle> handle = getHandle(name);
+        ASSERT(isHandleType<T>(handle->type), "Handle " + name + " is not of the requested type, it is of type " + toString(handle->type));
+        return HandleRef<T>(handle->valuePtr<T>());
     }
 
-    std::shared_ptr<Handle> operator()(std::string name) { return getHandle(name); }
+    std::shared_ptr<Handle> operator()(const std::string &name) { return getHandle(name); }
 };
 
 #endif
@@ -5,6 +5,7 @@
 
 #include "imgui.h"
 
+#include <mutex>
 #include <stdio.h>
 
 namespace Qulkan {
@@ -20,7 +21,7 @@ namespace Qulkan {
      *       or
      *       Qulkan::Logger::Error("My value is : %u",myValue);
      *
-     *   The logger support printf formatting style.
+     *   The logger support printf formatting style and can be used from any thread.
      *
      */
     class Logger {
@@ -37,6 +38,7 @@ namespace Qulkan {
         Logger() {
             AutoScroll = true;
             ScrollToBottom = false;
+            ConsoleOutput = false;
             Clear();
         }
 
@@ -50,14 +52,20 @@ namespace Qulkan {
         ImVector<int> LineOffsets; // Index to lines offset. We maintain this with AddLog() calls, allowing us to have a random access on lines
         bool AutoScroll;
         bool ScrollToBottom;
+        bool ConsoleOutput;
+        std::recursive_mutex Mutex;
 
       public:
         void Clear() {
+            std::lock_guard<std::recursive_mutex> lock(Mutex);
             Buf.clear();
             LineOffsets.clear();
             LineOffsets.push_back(0);
         }
 
+        /* Also prints the messages to stdout (stderr for errors), for runs without a user interface */
+        static void SetConsoleOutput(bool enabled) { Instance().ConsoleOutput = enabled; }
+
         template <typename... Args> static void Info(const char *fmt, Args... args) { Instance().Log(LogLevel::INFO_LOG, fmt, args...); }
 
         template <typename... Args> static void Warning(const char *fmt, Args... args) { Instance().Log(LogLevel::WARN_LOG, fmt, args...); }
@@ -68,6 +76,7 @@ namespace Qulkan {
         }
 
         void Log(const LogLevel logLevel, const char *fmt, ...) {
+            std::lock_guard<std::recursive_mutex> lock(Mutex);
             int old_size = Buf.size();
             va_list args;
             va_start(args, fmt);
@@ -85,6 +94,14 @@ namespace Qulkan {
             default:
                 break;
             }
+            if (ConsoleOutput) {
+                va_list consoleArgs;
+                va_copy(consoleArgs, args);
+                FILE *console = logLevel == LogLevel::ERROR_LOG ? stderr : stdout;
+                fputs(Buf.begin() + old_size, console);
+                vfprintf(console, fmt, consoleArgs);
+                va_end(consoleArgs);
+            }
             Buf.appendfv(fmt, args);
             va_end(args);
             for (int new_size = Buf.size(); old_size < new_size; old_size++)
@@ -95,6 +112,7 @@ namespace Qulkan {
         }
 
         void Window(bool *p_open = NULL) {
+            std::lock_guard<std::recursive_mutex> lock(Mutex);
 
             if (!ImGui::Begin("Logger", p_open)) {
                 ImGui::End();
@@ -0,0 +1,158 @@
+#pragma once
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Qulkan {
+
+    /*! \brief Instrumenting CPU profiler
+     *
+     *  Scopes are timed with the zone macros, names must be string literals (or outlive the profiler):
+     *
+     *       QULKAN_PROFILE_ZONE("renderWindows");
+     *       QULKAN_PROFILE_ZONE_DETAIL("RenderView::render", renderView.name());
+     *
+     *  Every thread records its zones into its own single producer ring buffer, no lock is taken on the hot path.
+     *  The main thread drains the rings once per frame in newFrame(). While disabled at runtime a zone costs one
+     *  relaxed atomic load, without QULKAN_ENABLE_PROFILER the macros compile to nothing.
+     *  A ring is only allocated by the first zone a thread records while enabled, and given back to the threads started
+     *  later once its thread exited and the ring was drained. The history of the thread stays until it ages out.
+     *  The recorded zones are shown in a flame view and can be exported in the Chrome trace event format
+     *  (chrome://tracing, ui.perfetto.dev).
+     */
+    class Profiler {
+      public:
+        struct Event {
+            const char *name;
+            const char *detail;
+            uint64_t start; // ns since the profiler creation
+            uint64_t end;
+            uint32_t depth;
+        };
+
+        static Profiler &Instance() {
+            static Profiler instance;
+            return instance;
+        }
+
+        Profiler(Profiler const &) = delete;
+        void operator=(Profiler const &) = delete;
+
+        static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+        static void setEnabled(bool enable) { enabled.store(enable, std::memory_order_relaxed); }
+
+        /* Names the calling thread in the flame view and the exports */
+        static void setThreadName(const char *name);
+
+        /* Marks the beginning of a frame on the main thread and drains the rings of every thread */
+        void newFrame();
+
+        /* Writes the recorded history as Chrome trace event JSON */
+        bool exportChromeTrace(const char *filename);
+
+        void Window(bool *p_open = NULL);
+
+        /* Internal, used by ProfileZone */
+        static uint64_t now();
+        static void record(const char *name, const char *detail, uint64_t start, uint64_t end, uint32_t depth);
+        static thread_local uint32_t zoneDepth;
+
+      private:
+        static const uint32_t RING_SIZE = 1 << 15;
+        static const int HISTORY_FRAMES = 300;
+
+        struct ThreadBuffer {
+            std::string name;
+            uint32_t id;
+            std::unique_ptr<Event[]> ring;
+            std::atomic<uint64_t> head; // written by the owning thread only
+            uint64_t tail;              // read by the main thread only
+            std::deque<Event> history;
+            bool exited; // The owning thread exited, the ring is given back once drained
+
+            ThreadBuffer(uint32_t id, std::unique_ptr<Event[]> ring) : id(id), ring(std::move(ring)), head(0), tail(0), exited(false) {}
+        };
+
+        /* Ring of the calling thread, given back when the thread exits */
+        struct ThreadSlot {
+            ThreadBuffer *buffer = nullptr;
+            std::string name;
+
+            ~ThreadSlot();
+        };
+
+        static std::atomic<bool> enabled;
+        static std::atomic<bool> destroyed;
+        static thread_local ThreadSlot threadSlot;
+
+        std::mutex threadsMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> threads;
+        std::vector<std::unique_ptr<Event[]>> freeRings;
+        uint32_t nextThreadId;
+
+        std::deque<uint64_t> frameStarts;
+        bool paused;
+        uint64_t dropped;
+
+        Profiler();
+        ~Profiler();
+
+        ThreadBuffer *registerThread(const std::string &name);
+        void releaseThread(ThreadBuffer *buffer);
+        void recycleExitedThreads();
+        void drain(ThreadBuffer &buffer);
+    };
+
+    /*! \brief Times the enclosing scope, see QULKAN_PROFILE_ZONE */
+    class ProfileZone {
+      private:
+        const char *name;
+        const char *detail;
+        uint64_t start;
+        bool active;
+
+      public:
+        ProfileZone(const char *name, const char *detail = nullptr) : name(name), detail(detail), active(Profiler::isEnabled()) {
+            if (active) {
+                start = Profiler::now();
+                ++Profiler::zoneDepth;
+            }
+        }
+
+        ~ProfileZone() {
+            if (active) {
+                --Profiler::zoneDepth;
+                Profiler::record(name, detail, start, Profiler::now(), Profiler::zoneDepth);
+            }
+        }
+
+        ProfileZone(ProfileZone const &) = delete;
+        void operator=(ProfileZone const &) = delete;
+    };
+
+} // namespace Qulkan
+
+#define QULKAN_PROFILE_CONCAT_IMPL(a, b) a##b
+#define QULKAN_PROFILE_CONCAT(a, b) QULKAN_PROFILE_CONCAT_IMPL(a, b)
+
+#if defined(QULKAN_ENABLE_PROFILER)
+#define QULKAN_PROFILE_ZONE(name) Qulkan::ProfileZone QULKAN_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define QULKAN_PROFILE_ZONE_DETAIL(name, detail) Qulkan::ProfileZone QULKAN_PROFILE_CONCAT(profileZone, __LINE__)(name, detail)
+#define QULKAN_PROFILE_FUNCTION() Qulkan::ProfileZone QULKAN_PROFILE_CONCAT(profileZone, __LINE__)(__func__)
+#define QULKAN_PROFILE_THREAD(name) Qulkan::Profiler::setThreadName(name)
+#else
+#define QULKAN_PROFILE_ZONE(name) ((void)0)
+#define QULKAN_PROFILE_ZONE_DETAIL(name, detail) ((void)0)
+#define QULKAN_PROFILE_FUNCTION() ((void)0)
+#define QULKAN_PROFILE_THREAD(name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "qulkan/framecapture.h"
+#include "qulkan/render_view.h"
+#include "utils/pngwriter.h"
+
+namespace Qulkan {
+
+    /*! \brief Records a render view to disk at a fixed timestep
+     *
+     *  While recording, the simulated delta time is fixed to 1 / framesPerSecond and the view is rendered and captured
+     *  once per application frame. Captured frames are encoded by a pool of worker threads either as a PNG sequence
+     *  or as a single raw Y4M (4:4:4) stream. At most queueCapacity frames are in flight, when the encoders fall behind
+     *  the main loop waits for them instead of buffering more frames.
+     *
+     *       Qulkan::Recorder::Instance().start(renderView, settings);
+     *
+     */
+    class Recorder {
+      public:
+        enum Format { PNG_SEQUENCE = 0, Y4M = 1 };
+
+        struct Settings {
+            Format format = PNG_SEQUENCE;
+            std::string output = "recording"; // "<output>_00000.png" or "<output>.y4m"
+            int frameCount = 240;
+            int framesPerSecond = 60;
+            int workerCount = 4;
+            int queueCapacity = 16;
+            PNGWriter::Options pngOptions = PNGWriter::Options::Fast();
+        };
+
+        static Recorder &Instance() {
+            static Recorder instance;
+            return instance;
+        }
+
+        Recorder(Recorder const &) = delete;
+        void operator=(Recorder const &) = delete;
+
+        /* Starts recording a view, returns false if a recording is already running or the output can't be opened */
+        bool start(RenderView &renderView, const Settings &settings);
+
+        /* Stops capturing new frames, the frames already captured are still written */
+        void stop();
+
+        /* Renders and captures the next frame of the recorded view, to be called once per frame before the views are drawn */
+        void update();
+
+        bool isRecording() const;
+        bool isRecording(const RenderView &renderView) const;
+
+        int capturedFrames() const { return captured; }
+        int writtenFrames() const { return written; }
+        int totalFrames() const { return settings.frameCount; }
+
+      private:
+        enum State { IDLE, RECORDING, FINISHING };
+
+        State state;
+        Settings settings;
+        RenderView *recordedView;
+        bool viewWasContinuous;
+        bool viewHadDynamicResolution;
+        float previousFixedDeltaTime;
+
+        int captured;
+        std::atomic<int> written;
+
+        // Frames between their capture and the end of their encoding, bounded by queueCapacity
+        std::mutex inFlightMutex;
+        std::condition_variable inFlightCondition;
+        int inFlight;
+
+        std::vector<std::thread> workers;
+        std::mutex jobsMutex;
+        std::condition_variable jobsCondition;
+        std::deque<std::function<void()>> jobs;
+        bool stopWorkers;
+
+        // Y4M frames have to be written in order, encoded frames wait here for their predecessors
+        FILE *stream;
+        int streamWidth;
+        int streamHeight;
+        std::mutex streamMutex;
+        std::map<int, std::vector<unsigned char>> encodedFrames;
+        int nextStreamFrame;
+
+        Recorder();
+        ~Recorder();
+
+        void waitForSlot();
+        void encode(int frameIndex, const CapturedImage &image);
+        void releaseSlot();
+        void endCapture();
+        void finish();
+        void workerLoop();
+    };
+
+} // namespace Qulkan
+
+#endif
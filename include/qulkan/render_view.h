@@ -4,9 +4,15 @@
 #define RENDER_VIEW_H
 
 #include "imgui.h"
+#include "qulkan/framebufferpool.h"
+#include "qulkan/gputimer.h"
 #include "qulkan/handlemanager.h"
 #include "qulkan/utils.h"
+#include <chrono>
+#include <deque>
 #include <memory>
+#include <set>
+#include <string>
 
 namespace Qulkan {
 
@@ -18,8 +24,22 @@ namespace Qulkan {
         bool mouseMirror;
         int mirrorWith;
         int mirrorWithCombo;
+        bool followWindowSize = false;
         PreferenceManager(bool mouseOverlay, int mirrorWith, int mirrorWithCombo, bool mouseMirror)
-            : mouseOverlay(mouseOverlay), mirrorWith(mirrorWith), mirrorWithCombo(mirrorWithCombo), mouseMirror(mouseMirror){};
+            : mouseOverlay(mouseOverlay), mouseMirror(mouseMirror), mirrorWith(mirrorWith), mirrorWithCombo(mirrorWithCombo){};
+    };
+
+    /*! \brief Render scale of a view adjusted to keep its GPU time under a budget
+     *
+     *  The view renders at scale x its size into a smaller target which is upscaled into its texture. The scale follows the GPU time
+     *  measured by the view's GPUTimer, assuming the cost grows with the number of pixels. Once the view stops being redrawn it
+     *  renders once more at full resolution.
+     */
+    struct DynamicResolution {
+        bool enabled = false;
+        float targetMs = 8.0f;
+        float minScale = 0.25f;
+        float maxScale = 1.0f;
     };
 
     class RenderView {
@@ -38,12 +58,36 @@ namespace Qulkan {
         bool captureMouse;
 
         ViewType viewType;
-        ImTextureID renderViewTexture;
-        unsigned int renderFramebuffer;
+        AttachmentSpec attachmentSpec;
+        RenderTarget renderTarget;
+        int displayedAttachment;
+
+        // Size requested while resizing, applied once it settles
+        bool resizePending;
+        int pendingWidth;
+        int pendingHeight;
+        std::chrono::steady_clock::time_point pendingSince;
 
         int actualRenderWidth;
         int actualRenderHeight;
 
+        bool dirty;
+        bool continuousRendering;
+
+        bool programsSubmitted; // By submitPrograms(), until initPrograms() checks them
+
+        GPUTimer gpuTimer;
+
+        DynamicResolution dynamicResolution;
+        RenderTarget scaledTarget; // Rendered into when the render scale is below 1
+        float renderScale;
+        float renderedScale;                            // Scale of the current content of the texture
+        std::deque<std::pair<uint64_t, float>> frameScales; // Scale of the last frames, matched with the late GPU timings
+        uint64_t lastTimedFrame;
+
+        void updateRenderScale();
+        void renderScaled(float scale);
+
       protected:
         // Mouse properties
         glm::vec2 screenMousePos; // normalized inscreen mouse position
@@ -59,10 +103,23 @@ namespace Qulkan {
         bool initialized;
         bool error;
 
+        /* Adds the shaders and programs of the view and submits their links, without waiting on the driver */
+        virtual void createPrograms() {}
+
+        /* Waits for the links submitted by createPrograms() and checks them, returns false when one of the programs failed */
+        virtual bool checkPrograms() { return true; }
+
+        /* Checks the programs in init(), they are submitted here unless submitPrograms() already did (e.g. when the view is recompiled) */
+        void initPrograms();
+
       public:
         RenderView(const char *viewName = "Render View", int initialRenderWidth = 1920, int initialRenderHeight = 1080, ViewType viewType = ViewType::OPENGL);
 
-        virtual ~RenderView(){};
+        virtual ~RenderView();
+
+        /* First step of the initialisation, issues the shader compiles and program links of createPrograms() once per init().
+         * initViews() submits the programs of every view before initializing any of them, so the compiles overlap */
+        void submitPrograms();
 
         /* Inits the render view */
         virtual void init() = 0;
@@ -73,23 +130,72 @@ namespace Qulkan {
         /* Returns a texture/rendered image as a ImTextureID pointer for ImGui to render to a renderview */
         virtual void render(int actualRenderWidth, int actualRenderHeight) = 0;
 
+        /* Renders the view to its texture if it needs to be redrawn (or renders continuously) and returns the texture */
         ImTextureID renderToTexture();
 
+        /* Marks the view as needing to be rendered again on the next frame */
+        void requestRedraw();
+        bool isDirty() const;
+
+        /* Views animating on their own (e.g. with time) should render every frame */
+        void setContinuousRendering(bool continuous);
+        bool isContinuousRendering() const;
+
+        /* Replaces the render target, the previous one goes back to the FramebufferPool */
         void recreateFramebuffer(int actualRenderWidth, int actualRenderHeight);
 
+        /* Replaces the attachments of the render target, e.g. several color formats for a G-buffer written in one pass or multisampling.
+         * render() is called with the (multisampled) draw framebuffer bound, the resolve happens afterwards */
+        void setAttachments(const AttachmentSpec &spec);
+        const AttachmentSpec &getAttachments() const;
+
+        /* Attachment textures of the last render, resolved when multisampled */
+        const RenderTarget &getRenderTarget() const;
+
+        /* Color attachment shown in the window and captured by FrameCapture */
+        void setDisplayedAttachment(int index);
+        int getDisplayedAttachment() const;
+
+        /* Coalesces the resizes requested every frame (e.g. while a dock is dragged), the framebuffer is only recreated once the size
+         * stayed the same for RESIZE_SETTLE_MS and the mouse is released */
+        void requestResize(int width, int height);
+
+        static constexpr int RESIZE_SETTLE_MS = 150;
+
         bool isInitialized() const;
 
+        /* Relinks every program of the view, falls back to a full clean() and init() for views that can't reload their shaders */
         void recompileShaders();
 
+        /* Relinks the programs depending on one of the modified shader files, the geometry, textures and framebuffers are kept */
+        void shaderFilesChanged(const std::set<std::string> &files);
+
+        /* Overridden by the views able to relink only the programs built from one of the files (every program for an empty set).
+         * Returns false when the shaders can't be reloaded on their own */
+        virtual bool reloadShaders(const std::set<std::string> &files) { return false; }
+
+        /* True when one of the files is a shader file of the view (or included by one), a view that failed to initialize is only
+         * recompiled for the changes of its own shaders */
+        virtual bool usesShaderFiles(const std::set<std::string> &files) { return false; }
+
         HandleManager &getHandleManager();
         PreferenceManager &getPreferenceManager();
 
+        /* GPU time spent in render(), measured a few frames late */
+        GPUTimer &getGPUTimer();
+
+        DynamicResolution &getDynamicResolution();
+        float getRenderScale() const;
+
         int width() const;
         int height() const;
 
         unsigned int getRenderFramebuffer() const;
         ImTextureID getRenderViewTexture() const;
 
+        /* Texture coordinates of the upper right corner of the rendered area, the texture is allocated by size class */
+        glm::vec2 getRenderViewTextureExtent() const;
+
         glm::vec2 getInRectPos() const;
         void setInRectPos(glm::vec2 pos);
 
@@ -0,0 +1,63 @@
+#pragma once
+
+#ifndef SHADERWATCHER_H
+#define SHADERWATCHER_H
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+
+namespace Qulkan {
+
+    /*! \brief Watches shader files and their includes for modifications
+     *
+     *  ShaderManager registers every file a shader was preprocessed from. On Linux the parent directories are watched with inotify,
+     *  so files replaced by a rename (as many editors save) are still seen; elsewhere the modification times are polled.
+     *  A file is reported once it stopped changing for a short while, so a save written in several steps triggers a single reload.
+     *
+     *       for (const std::string &file : Qulkan::ShaderWatcher::Instance().poll())
+     *           ...
+     */
+    class ShaderWatcher {
+      public:
+        static ShaderWatcher &Instance() {
+            static ShaderWatcher instance;
+            return instance;
+        }
+
+        ShaderWatcher(ShaderWatcher const &) = delete;
+        void operator=(ShaderWatcher const &) = delete;
+
+        void watch(const std::string &filename);
+
+        /* Returns the watched files modified since the last call, never blocks */
+        std::set<std::string> poll();
+
+        void setEnabled(bool enable) { enabled = enable; }
+        bool isEnabled() const { return enabled; }
+
+      private:
+        typedef std::chrono::steady_clock clock;
+
+        static constexpr int DEBOUNCE_MS = 100;
+        static constexpr int POLL_INTERVAL_MS = 500;
+
+        bool enabled;
+        int inotifyFd;
+        std::map<int, std::string> directories; // inotify watch descriptor to directory
+        std::map<std::string, std::filesystem::file_time_type> files;
+        std::map<std::string, clock::time_point> modified;
+        clock::time_point lastPoll;
+
+        ShaderWatcher();
+        ~ShaderWatcher();
+
+        void readEvents();
+        void pollTimes();
+    };
+
+} // namespace Qulkan
+
+#endif
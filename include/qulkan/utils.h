@@ -24,5 +24,10 @@ namespace Qulkan {
     extern void updateDeltaTime(float currentFrameTime);
     extern uint64_t getFrameNumber();
     extern float getDeltaTime();
+    /* Simulated time in seconds, the sum of the delta times. Use it instead of glfwGetTime() for animations */
+    extern float getTime();
+    /* Overrides the measured delta time with a fixed step, 0 restores the wall clock */
+    extern void setFixedDeltaTime(float fixedDeltaTime);
+    extern float getFixedDeltaTime();
 } // namespace Qulkan
 #endif
\ No newline at end of file
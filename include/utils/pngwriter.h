@@ -5,17 +5,44 @@
 
 #include <png.h>
 
+#include <vector>
+
+/*! \brief PNG encoder for 8-bit or float images
+ *
+ *  The writer does not take ownership of the image buffer. Images are expected bottom row first, as returned by OpenGL,
+ *  and are flipped while encoding unless flipY is disabled. Float images are converted to 8-bit in parallel.
+ */
 class PNGWriter {
 
+  public:
+    struct Options {
+        int compressionLevel; // zlib level, 0 (fastest) to 9 (smallest)
+        int filters;          // PNG_FILTER_* mask, PNG_FILTER_NONE is the fastest
+        bool flipY;
+
+        Options(int compressionLevel = 6, int filters = PNG_ALL_FILTERS, bool flipY = true)
+            : compressionLevel(compressionLevel), filters(filters), flipY(flipY) {}
+
+        /* Favors encoding speed over file size, for batch captures */
+        static Options Fast() { return Options(1, PNG_FILTER_NONE); }
+    };
+
   private:
     int width, height, channels;
-    float *imageBuffer;
+    const float *floatBuffer;
+    const unsigned char *byteBuffer;
+    Options options;
+
+    std::vector<png_byte> converted;
 
   public:
-    PNGWriter(int width, int height, int channels, float *imageBuffer);
-    ~PNGWriter() { delete imageBuffer; };
+    PNGWriter(int width, int height, int channels, const float *imageBuffer, const Options &options = Options());
+    PNGWriter(int width, int height, int channels, const unsigned char *imageBuffer, const Options &options = Options());
 
     int writePNG(const char *filename, char *imageTitle);
+
+    /* Converts float values in [0,1] to bytes, clamping values out of range */
+    static void convertRow(const float *src, png_byte *dst, int count);
 };
 
 #endif
@@ -9,6 +9,8 @@
 
 #include <vector>
 
+#include "framework/vertexlayout.h"
+
 namespace VKHelper {
 
     class VertexFormat {
@@ -24,6 +26,91 @@ namespace VKHelper {
             virtual VkVertexInputBindingDescription createBindingDescription() const = 0;
     };
 
+    /* VkFormat read by a reflected vertex attribute, VK_FORMAT_UNDEFINED when Vulkan has none */
+    constexpr VkFormat vertexAttributeFormat(const glf::vertex_attribute &attribute) {
+        constexpr VkFormat floats[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+        constexpr VkFormat doubles[] = {VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT};
+        constexpr VkFormat sint8[] = {VK_FORMAT_R8_SINT, VK_FORMAT_R8G8_SINT, VK_FORMAT_R8G8B8_SINT, VK_FORMAT_R8G8B8A8_SINT};
+        constexpr VkFormat snorm8[] = {VK_FORMAT_R8_SNORM, VK_FORMAT_R8G8_SNORM, VK_FORMAT_R8G8B8_SNORM, VK_FORMAT_R8G8B8A8_SNORM};
+        constexpr VkFormat uint8[] = {VK_FORMAT_R8_UINT, VK_FORMAT_R8G8_UINT, VK_FORMAT_R8G8B8_UINT, VK_FORMAT_R8G8B8A8_UINT};
+        constexpr VkFormat unorm8[] = {VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_R8G8B8A8_UNORM};
+        constexpr VkFormat sint16[] = {VK_FORMAT_R16_SINT, VK_FORMAT_R16G16_SINT, VK_FORMAT_R16G16B16_SINT, VK_FORMAT_R16G16B16A16_SINT};
+        constexpr VkFormat snorm16[] = {VK_FORMAT_R16_SNORM, VK_FORMAT_R16G16_SNORM, VK_FORMAT_R16G16B16_SNORM, VK_FORMAT_R16G16B16A16_SNORM};
+        constexpr VkFormat uint16[] = {VK_FORMAT_R16_UINT, VK_FORMAT_R16G16_UINT, VK_FORMAT_R16G16B16_UINT, VK_FORMAT_R16G16B16A16_UINT};
+        constexpr VkFormat unorm16[] = {VK_FORMAT_R16_UNORM, VK_FORMAT_R16G16_UNORM, VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16A16_UNORM};
+        constexpr VkFormat sint32[] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+        constexpr VkFormat uint32[] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+
+        if (attribute.count < 1 || attribute.count > 4)
+            return VK_FORMAT_UNDEFINED;
+        const unsigned index = attribute.count - 1;
+        switch (attribute.type) {
+        case glf::component::FLOAT:
+            return floats[index];
+        case glf::component::DOUBLE:
+            return doubles[index];
+        case glf::component::INT8:
+            return attribute.normalized ? snorm8[index] : sint8[index];
+        case glf::component::UINT8:
+            return attribute.normalized ? unorm8[index] : uint8[index];
+        case glf::component::INT16:
+            return attribute.normalized ? snorm16[index] : sint16[index];
+        case glf::component::UINT16:
+            return attribute.normalized ? unorm16[index] : uint16[index];
+        case glf::component::INT32:
+            return attribute.normalized ? VK_FORMAT_UNDEFINED : sint32[index];
+        case glf::component::UINT32:
+            return attribute.normalized ? VK_FORMAT_UNDEFINED : uint32[index];
+        }
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    template <typename Vertex> constexpr bool vertexFormatsSupported() {
+        for (const glf::vertex_attribute &attribute : glf::vertex_layout<Vertex>::attributes)
+            if (vertexAttributeFormat(attribute) == VK_FORMAT_UNDEFINED)
+                return false;
+        return true;
+    }
+
+    /*! \brief VertexFormat generated from the glf::vertex_layout of a vertex struct
+     *
+     *  The struct stays a plain standard layout type, the pipeline is created with ReflectedVertexFormat<Vertex>{}.
+     */
+    template <typename Vertex> class ReflectedVertexFormat final : public VertexFormat {
+        typedef glf::checked_layout<Vertex> Layout;
+        static_assert(vertexFormatsSupported<Vertex>(), "vertex attribute without a matching VkFormat (32 bit integers can't be normalized)");
+
+      public:
+        explicit ReflectedVertexFormat(uint32_t binding = 0, VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX)
+            : binding(binding), inputRate(inputRate) {}
+
+      private:
+        uint32_t binding;
+        VkVertexInputRate inputRate;
+
+        virtual std::vector<VkVertexInputAttributeDescription> createAttributeDescriptions() const {
+            std::vector<VkVertexInputAttributeDescription> descriptions;
+            descriptions.reserve(Layout::count);
+            for (const glf::vertex_attribute &attribute : Layout::attributes) {
+                VkVertexInputAttributeDescription description = {};
+                description.binding = binding;
+                description.location = attribute.location;
+                description.format = vertexAttributeFormat(attribute);
+                description.offset = static_cast<uint32_t>(attribute.offset);
+                descriptions.push_back(description);
+            }
+            return descriptions;
+        }
+
+        virtual VkVertexInputBindingDescription createBindingDescription() const {
+            VkVertexInputBindingDescription description = {};
+            description.binding = binding;
+            description.stride = static_cast<uint32_t>(Layout::stride);
+            description.inputRate = inputRate;
+            return description;
+        }
+    };
+
 } // namespace Base
 
 #endif //__VK_HELPER_VERTEX_FORMAT_HPP__
\ No newline at end of file
@@ -1,28 +1,32 @@
 #ifndef __VULKAN_QULKAN_SIMPLE_VERTEX_FORMAT_HPP__
 #define __VULKAN_QULKAN_SIMPLE_VERTEX_FORMAT_HPP__
 
+#include <cstddef>
+
 #include <glm/glm.hpp>
 
 #include "vulkan/api/vertex_format.hpp"
 
 namespace Qulkan::Vulkan {
 
-    class ColoredVertex final : public VKHelper::VertexFormat {
-
-      public:
-        ColoredVertex(); // Used to get access to the attribute and binding descriptions
+    // Plain vertex data, the pipeline gets its descriptions from VKHelper::ReflectedVertexFormat<ColoredVertex>
+    struct ColoredVertex {
+        ColoredVertex();
         ColoredVertex(const glm::vec3 &aPos, const glm::vec3 &aColor);
 
-        virtual ~ColoredVertex();
-
-      private:
         glm::vec3 pos;
         glm::vec3 color;
-
-        virtual std::vector<VkVertexInputAttributeDescription> createAttributeDescriptions() const;
-        virtual VkVertexInputBindingDescription createBindingDescription() const;
     };
 
 } // namespace Qulkan::Vulkan
 
+namespace glf {
+
+    template <> struct vertex_layout<Qulkan::Vulkan::ColoredVertex> {
+        static constexpr vertex_attribute attributes[] = {GLF_VERTEX_ATTRIBUTE(Qulkan::Vulkan::ColoredVertex, pos, 0),
+                                                          GLF_VERTEX_ATTRIBUTE(Qulkan::Vulkan::ColoredVertex, color, 1)};
+    };
+
+} // namespace glf
+
 #endif //__VULKAN_QULKAN_SIMPLE_VERTEX_FORMAT_HPP__
\ No newline at end of file
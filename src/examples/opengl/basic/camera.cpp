@@ -13,13 +13,10 @@
 #include "framework/opengl/vertex.h"
 #include "qulkan/logger.h"
 #include "qulkan/utils.h"
-#include "utils/stb_image.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#define BUFFER_OFFSET(i) ((char *)NULL + (i))
-
 namespace OpenGLExamples {
 
     void Camera::createCube() {
@@ -69,6 +66,9 @@ namespace OpenGLExamples {
 
     Camera::Camera(const char *viewName, int initialRenderWidth, int initialRenderHeight)
         : Qulkan::RenderView(viewName, initialRenderWidth, initialRenderHeight) {
+        // Animated with time, needs to be rendered every frame
+        setContinuousRendering(true);
+
         createCube();
         cubePositions.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
         cubePositions.push_back(glm::vec3(2.0f, 5.0f, -15.0f));
@@ -99,27 +99,31 @@ namespace OpenGLExamples {
         handleManager.addHandle(cameraSpeed);
         Handle cameraSensitivity("Camera Sensitivity", Type::FLOAT_HANDLE, 0.1f, 0.001f, 1.0f);
         handleManager.addHandle(cameraSensitivity);
+
+        resolveHandles();
     }
 
-    void Camera::initProgram() {
+    void Camera::resolveHandles() {
+        mix = handleManager.getRef<float>("Mix");
+        fov = handleManager.getRef<float>("FoV");
+        nearPlane = handleManager.getRef<float>("Near Plane");
+        farPlane = handleManager.getRef<float>("Far Plane");
+        cameraSpeed = handleManager.getRef<float>("Camera Speed");
+        cameraSensitivity = handleManager.getRef<float>("Camera Sensitivity");
+    }
 
-        Compiler compiler;
+    void Camera::createPrograms() {
 
         shaderManager.addShader("VERT_DEFAULT", "../data/shaders/examples/basic/coordinatesystems.vert", GL_VERTEX_SHADER, compiler);
         shaderManager.addShader("FRAG_DEFAULT", "../data/shaders/examples/basic/coordinatesystems.frag", GL_FRAGMENT_SHADER, compiler);
 
         programManager.addProgram("DEFAULT");
 
-        glAttachShader(programManager("DEFAULT"), shaderManager("VERT_DEFAULT"));
-        glAttachShader(programManager("DEFAULT"), shaderManager("FRAG_DEFAULT"));
-        glLinkProgram(programManager("DEFAULT"));
-
-        error = compiler.check() && error;
-        error = compiler.check_program(programManager("DEFAULT")) && error;
-
-        return;
+        programManager.link("DEFAULT", {"VERT_DEFAULT", "FRAG_DEFAULT"}, shaderManager, compiler);
     }
 
+    bool Camera::checkPrograms() { return programManager.check(shaderManager, compiler); }
+
     void Camera::initBuffer() {
 
         bufferManager.addBuffer("VERTEX");
@@ -136,49 +140,13 @@ namespace OpenGLExamples {
 
     void Camera::initTexture() {
 
-        textureManager.addTexture("IMAGE_VULKAN1", "../data/images/raw_vulkan.jpg");
-        textureManager.addTexture("IMAGE_VULKAN2", "../data/images/vulkan_mountain.png");
-        textureManager.addTexture("RENDERVIEW");
-
-        glGenTextures(textureManager.size(), &textureManager.textures[0]);
-        // Image texture 1
-        glBindTexture(GL_TEXTURE_2D, textureManager("IMAGE_VULKAN1"));
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        // Load first image
-        int width, height, nrChannels;
-        unsigned char *texData1 = stbi_load(textureManager.texturePath("IMAGE_VULKAN1"), &width, &height, &nrChannels, 0);
-
-        if (texData1) {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texData1);
-            glGenerateMipmap(GL_TEXTURE_2D);
-        } else {
-            Qulkan::Logger::Error("Failed to load texture 1");
-        }
-        stbi_image_free(texData1);
+        // Decoded and uploaded in the background, shared with the other views loading the same images
+        textureManager.loadTexture("IMAGE_VULKAN1", "../data/images/raw_vulkan.jpg");
 
-        // Image texture 2
-        glBindTexture(GL_TEXTURE_2D, textureManager("IMAGE_VULKAN2"));
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, glm::value_ptr(glm::vec4(0.0)));
-
-        // Load second image (RGBA)
-        unsigned char *texData2 = stbi_load(textureManager.texturePath("IMAGE_VULKAN2"), &width, &height, &nrChannels, 0);
-
-        if (texData2) {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texData2);
-            glGenerateMipmap(GL_TEXTURE_2D);
-        } else {
-            Qulkan::Logger::Error("Failed to load texture 2");
-        }
-        stbi_image_free(texData2);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        TextureParameters clampToBorder;
+        clampToBorder.wrapS = GL_CLAMP_TO_BORDER;
+        clampToBorder.wrapT = GL_CLAMP_TO_BORDER;
+        textureManager.loadTexture("IMAGE_VULKAN2", "../data/images/vulkan_mountain.png", clampToBorder);
 
         // Bind to programm
         glUseProgram(programManager("DEFAULT"));
@@ -193,11 +161,7 @@ namespace OpenGLExamples {
         glBindVertexArray(vaoManager.id);
         glBindBuffer(GL_ARRAY_BUFFER, bufferManager("VERTEX"));
 
-        glVertexAttribPointer(semantic::attr::POSITION, 3, GL_FLOAT, GL_FALSE, vaoManager.getVertexSize(), BUFFER_OFFSET(0));
-        glEnableVertexAttribArray(semantic::attr::POSITION);
-
-        glVertexAttribPointer(semantic::attr::TEXCOORD, 2, GL_FLOAT, GL_FALSE, vaoManager.getVertexSize(), BUFFER_OFFSET(sizeof(glm::vec3)));
-        glEnableVertexAttribArray(semantic::attr::TEXCOORD);
+        vaoManager.setupAttributes();
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
         glBindVertexArray(0);
@@ -212,7 +176,7 @@ namespace OpenGLExamples {
 
         if (handleManager.getHandles().empty())
             initHandles();
-        initProgram();
+        initPrograms();
         initBuffer();
         initTexture();
         initVertexArray();
@@ -231,12 +195,19 @@ namespace OpenGLExamples {
         glEnable(GL_DEPTH_TEST);
     }
 
+    bool Camera::reloadShaders(const std::set<std::string> &files) {
+        programManager.reload(shaderManager, files);
+        return true;
+    }
+
+    bool Camera::usesShaderFiles(const std::set<std::string> &files) { return shaderManager.dependsOn(files); }
+
     void Camera::clean() {
         glDeleteFramebuffers(framebufferManager.size(), &framebufferManager.framebuffers[0]);
         glDeleteProgram(programManager("DEFAULT"));
 
         glDeleteBuffers(bufferManager.size(), &bufferManager.buffers[0]);
-        glDeleteTextures(textureManager.size(), &textureManager.textures[0]);
+        textureManager.releaseStreamed();
         glDeleteVertexArrays(1, &vaoManager.id);
     }
 
@@ -252,7 +223,7 @@ namespace OpenGLExamples {
         // Camera settings
         float radius = 10.0f;
 
-        float sensitivity = handleManager("Camera Sensitivity")->getValue<float>();
+        float sensitivity = *cameraSensitivity;
         if (isMouseDragging(0)) {
             yaw += mouseDelta.x * sensitivity * Qulkan::getDeltaTime();
             pitch += -mouseDelta.y * sensitivity * Qulkan::getDeltaTime();
@@ -270,7 +241,6 @@ namespace OpenGLExamples {
         }
 
         if (mouseWheel != 0.0f) {
-            auto fov = std::any_cast<float>(&handleManager("FoV")->value);
             if (*fov >= 1.0f && *fov <= 45.0f)
                 *fov -= mouseWheel;
             if (*fov <= 1.0f)
@@ -279,27 +249,23 @@ namespace OpenGLExamples {
                 *fov = 45.0f;
         }
 
-        float cameraSpeed = handleManager("Camera Speed")->getValue<float>() * Qulkan::getDeltaTime();
+        float speed = *cameraSpeed * Qulkan::getDeltaTime();
         if (isKeyDown(GLFW_KEY_LEFT_SHIFT))
-            cameraSpeed = cameraSpeed * 3.0f;
+            speed = speed * 3.0f;
         if (isKeyDown(GLFW_KEY_W))
-            cameraPos += cameraSpeed * cameraFront;
+            cameraPos += speed * cameraFront;
         if (isKeyDown(GLFW_KEY_S))
-            cameraPos -= cameraSpeed * cameraFront;
+            cameraPos -= speed * cameraFront;
         if (isKeyDown(GLFW_KEY_A))
-            cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
+            cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * speed;
         if (isKeyDown(GLFW_KEY_D))
-            cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
+            cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * speed;
 
         glm::mat4 view = glm::mat4(1.0f);
         view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
 
         glm::mat4 projection;
-        float nearPlane = handleManager("Near Plane")->getValue<float>();
-        float farPlane = handleManager("Far Plane")->getValue<float>();
-
-        projection =
-            glm::perspective(glm::radians(handleManager("FoV")->getValue<float>()), (float)actualRenderWidth / actualRenderHeight, nearPlane, farPlane);
+        projection = glm::perspective(glm::radians(*fov), (float)actualRenderWidth / actualRenderHeight, *nearPlane, *farPlane);
 
         glUseProgram(programManager("DEFAULT"));
 
@@ -307,8 +273,11 @@ namespace OpenGLExamples {
         glBindTexture(GL_TEXTURE_2D, textureManager("IMAGE_VULKAN1"));
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, textureManager("IMAGE_VULKAN2"));
+        // Drawn again once the streamed images replace the placeholders
+        if (textureManager.isLoading())
+            requestRedraw();
 
-        glUniform1f(glGetUniformLocation(programManager("DEFAULT"), "Mix"), handleManager("Mix")->getValue<float>());
+        glUniform1f(glGetUniformLocation(programManager("DEFAULT"), "Mix"), *mix);
 
         // Bind view and projection matrix to shader program
         glUniformMatrix4fv(glGetUniformLocation(programManager("DEFAULT"), "view"), 1, GL_FALSE, glm::value_ptr(view));
@@ -320,7 +289,7 @@ namespace OpenGLExamples {
             glm::mat4 model = glm::mat4(1.0f);
             model = glm::translate(model, cubePositions[i]);
             float angle = 20.0f * i;
-            model = glm::rotate(model, glm::radians(angle) + ((float)std::pow(-1.0f, (i % 2))) * (float)glfwGetTime(), glm::vec3(1.0f, 0.3f, 0.5f));
+            model = glm::rotate(model, glm::radians(angle) + ((float)std::pow(-1.0f, (i % 2))) * Qulkan::getTime(), glm::vec3(1.0f, 0.3f, 0.5f));
             // Bind a new model for each set of draws
             glUniformMatrix4fv(glGetUniformLocation(programManager("DEFAULT"), "model"), 1, GL_FALSE, glm::value_ptr(model));
             // Draw a cube using draw arrays without any ebo to avoid having to set unique texture coordinates for each face.
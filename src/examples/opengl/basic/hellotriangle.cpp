@@ -13,17 +13,14 @@
 #include "framework/opengl/vertex.h"
 #include "qulkan/logger.h"
 #include "qulkan/utils.h"
-#include "utils/stb_image.h"
-
-#define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
 namespace OpenGLExamples {
 
     HelloTriangle::HelloTriangle(const char *viewName, int initialRenderWidth, int initialRenderHeight)
         : Qulkan::RenderView(viewName, initialRenderWidth, initialRenderHeight) {
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f)));   // top
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, -0.5f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));  // bottom right
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f))); // bottom left
+        vaoManager.addVertex(glf::vertex_v3fc3f(glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f)));   // top
+        vaoManager.addVertex(glf::vertex_v3fc3f(glm::vec3(0.5f, -0.5f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));  // bottom right
+        vaoManager.addVertex(glf::vertex_v3fc3f(glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f))); // bottom left
 
         eboManager.addTriangle(0, 1, 2);
     }
@@ -33,27 +30,26 @@ namespace OpenGLExamples {
         Handle transparency("Transparency", Type::FLOAT_HANDLE, 1.0f);
 
         handleManager.addHandle(transparency);
+
+        resolveHandles();
     }
 
-    void HelloTriangle::initProgram() {
+    void HelloTriangle::resolveHandles() {
+        transparency = handleManager.getRef<float>("Transparency");
+    }
 
-        Compiler compiler;
+    void HelloTriangle::createPrograms() {
 
         shaderManager.addShader("VERT_DEFAULT", "../data/shaders/examples/basic/hellotriangle.vert", GL_VERTEX_SHADER, compiler);
         shaderManager.addShader("FRAG_DEFAULT", "../data/shaders/examples/basic/hellotriangle.frag", GL_FRAGMENT_SHADER, compiler);
 
         programManager.addProgram("DEFAULT");
 
-        glAttachShader(programManager("DEFAULT"), shaderManager("VERT_DEFAULT"));
-        glAttachShader(programManager("DEFAULT"), shaderManager("FRAG_DEFAULT"));
-        glLinkProgram(programManager("DEFAULT"));
-
-        error = compiler.check() && error;
-        error = compiler.check_program(programManager("DEFAULT")) && error;
-
-        return;
+        programManager.link("DEFAULT", {"VERT_DEFAULT", "FRAG_DEFAULT"}, shaderManager, compiler);
     }
 
+    bool HelloTriangle::checkPrograms() { return programManager.check(shaderManager, compiler); }
+
     void HelloTriangle::initBuffer() {
 
         bufferManager.addBuffer("ELEMENT");
@@ -76,28 +72,8 @@ namespace OpenGLExamples {
 
     void HelloTriangle::initTexture() {
 
-        textureManager.addTexture("IMAGE", "../data/images/raw_vulkan.jpg");
-
-        glGenTextures(textureManager.size(), &textureManager.textures[0]);
-        // Image texture
-        glBindTexture(GL_TEXTURE_2D, textureManager("IMAGE"));
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glBindTexture(GL_TEXTURE_2D, 0);
-
-        int width, height, nrChannels;
-        unsigned char *texData = stbi_load(textureManager.texturePath("IMAGE"), &width, &height, &nrChannels, 0);
-
-        if (texData) {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texData);
-            glGenerateMipmap(GL_TEXTURE_2D);
-        } else {
-            Qulkan::Logger::Error("Failed to load texture");
-        }
-
-        stbi_image_free(texData);
+        // Decoded and uploaded in the background, shared with the other views loading the same image
+        textureManager.loadTexture("IMAGE", "../data/images/raw_vulkan.jpg");
 
         return;
     }
@@ -107,11 +83,7 @@ namespace OpenGLExamples {
         glBindVertexArray(vaoManager.id);
         glBindBuffer(GL_ARRAY_BUFFER, bufferManager("VERTEX"));
 
-        glVertexAttribPointer(semantic::attr::POSITION, 3, GL_FLOAT, GL_FALSE, vaoManager.getVertexSize(), BUFFER_OFFSET(0));
-        glEnableVertexAttribArray(semantic::attr::POSITION);
-
-        glVertexAttribPointer(semantic::attr::COLOR, 3, GL_FLOAT, GL_FALSE, vaoManager.getVertexSize(), BUFFER_OFFSET(sizeof(glm::vec3)));
-        glEnableVertexAttribArray(semantic::attr::COLOR);
+        vaoManager.setupAttributes();
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
         // Bin element buffer array to array ob
@@ -129,7 +101,7 @@ namespace OpenGLExamples {
         // Avoids recreating the handles in case we recompile the shaders
         if (handleManager.getHandles().empty())
             initHandles();
-        initProgram();
+        initPrograms();
         initBuffer();
         initTexture();
         initVertexArray();
@@ -148,12 +120,19 @@ namespace OpenGLExamples {
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     }
 
+    bool HelloTriangle::reloadShaders(const std::set<std::string> &files) {
+        programManager.reload(shaderManager, files);
+        return true;
+    }
+
+    bool HelloTriangle::usesShaderFiles(const std::set<std::string> &files) { return shaderManager.dependsOn(files); }
+
     void HelloTriangle::clean() {
         glDeleteFramebuffers(framebufferManager.size(), &framebufferManager.framebuffers[0]);
         glDeleteProgram(programManager("DEFAULT"));
 
         glDeleteBuffers(bufferManager.size(), &bufferManager.buffers[0]);
-        glDeleteTextures(textureManager.size(), &textureManager.textures[0]);
+        textureManager.releaseStreamed();
         glDeleteVertexArrays(1, &vaoManager.id);
     }
 
@@ -169,7 +148,7 @@ namespace OpenGLExamples {
 
         glUseProgram(programManager("DEFAULT"));
 
-        glUniform1f(glGetUniformLocation(programManager("DEFAULT"), "Transparency"), handleManager("Transparency")->getValue<float>());
+        glUniform1f(glGetUniformLocation(programManager("DEFAULT"), "Transparency"), *transparency);
 
         glBindVertexArray(vaoManager.id);
         glDrawElementsInstancedBaseVertex(GL_TRIANGLES, eboManager.getElementCount(), GL_UNSIGNED_INT, 0, 1, 0);
@@ -13,17 +13,17 @@
 #include "framework/opengl/vertex.h"
 #include "qulkan/logger.h"
 #include "qulkan/utils.h"
-#include "utils/stb_image.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#define BUFFER_OFFSET(i) ((char *)NULL + (i))
-
 namespace OpenGLExamples {
 
     Transformations::Transformations(const char *viewName, int initialRenderWidth, int initialRenderHeight)
         : Qulkan::RenderView(viewName, initialRenderWidth, initialRenderHeight) {
+        // Animated with time, needs to be rendered every frame
+        setContinuousRendering(true);
+
         vaoManager.addVertex(glf::vertex_v3fv2f(glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(0.0f, 0.0f)));   // top right
         vaoManager.addVertex(glf::vertex_v3fv2f(glm::vec3(1.0f, -1.0f, 0.0f), glm::vec2(0.0f, 1.0f)));  // top left
         vaoManager.addVertex(glf::vertex_v3fv2f(glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec2(1.0f, 1.0f))); // bottom left
@@ -38,27 +38,26 @@ namespace OpenGLExamples {
         Handle mix("Mix", Type::FLOAT_HANDLE, 0.5f);
 
         handleManager.addHandle(mix);
+
+        resolveHandles();
     }
 
-    void Transformations::initProgram() {
+    void Transformations::resolveHandles() {
+        mix = handleManager.getRef<float>("Mix");
+    }
 
-        Compiler compiler;
+    void Transformations::createPrograms() {
 
         shaderManager.addShader("VERT_DEFAULT", "../data/shaders/examples/basic/transformations.vert", GL_VERTEX_SHADER, compiler);
         shaderManager.addShader("FRAG_DEFAULT", "../data/shaders/examples/basic/transformations.frag", GL_FRAGMENT_SHADER, compiler);
 
         programManager.addProgram("DEFAULT");
 
-        glAttachShader(programManager("DEFAULT"), shaderManager("VERT_DEFAULT"));
-        glAttachShader(programManager("DEFAULT"), shaderManager("FRAG_DEFAULT"));
-        glLinkProgram(programManager("DEFAULT"));
-
-        error = compiler.check() && error;
-        error = compiler.check_program(programManager("DEFAULT")) && error;
-
-        return;
+        programManager.link("DEFAULT", {"VERT_DEFAULT", "FRAG_DEFAULT"}, shaderManager, compiler);
     }
 
+    bool Transformations::checkPrograms() { return programManager.check(shaderManager, compiler); }
+
     void Transformations::initBuffer() {
 
         bufferManager.addBuffer("ELEMENT");
@@ -81,48 +80,13 @@ namespace OpenGLExamples {
 
     void Transformations::initTexture() {
 
-        textureManager.addTexture("IMAGE_VULKAN1", "../data/images/raw_vulkan.jpg");
-        textureManager.addTexture("IMAGE_VULKAN2", "../data/images/vulkan_mountain.png");
+        // Decoded and uploaded in the background, shared with the other views loading the same images
+        textureManager.loadTexture("IMAGE_VULKAN1", "../data/images/raw_vulkan.jpg");
 
-        glGenTextures(textureManager.size(), &textureManager.textures[0]);
-        // Image texture 1
-        glBindTexture(GL_TEXTURE_2D, textureManager("IMAGE_VULKAN1"));
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        // Load first image
-        int width, height, nrChannels;
-        unsigned char *texData1 = stbi_load(textureManager.texturePath("IMAGE_VULKAN1"), &width, &height, &nrChannels, 0);
-
-        if (texData1) {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, texData1);
-            glGenerateMipmap(GL_TEXTURE_2D);
-        } else {
-            Qulkan::Logger::Error("Failed to load texture 1");
-        }
-        stbi_image_free(texData1);
-
-        // Image texture 2
-        glBindTexture(GL_TEXTURE_2D, textureManager("IMAGE_VULKAN2"));
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, glm::value_ptr(glm::vec4(0.0)));
-
-        // Load second image (RGBA)
-        unsigned char *texData2 = stbi_load(textureManager.texturePath("IMAGE_VULKAN2"), &width, &height, &nrChannels, 0);
-
-        if (texData2) {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texData2);
-            glGenerateMipmap(GL_TEXTURE_2D);
-        } else {
-            Qulkan::Logger::Error("Failed to load texture 2");
-        }
-        stbi_image_free(texData2);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        TextureParameters clampToBorder;
+        clampToBorder.wrapS = GL_CLAMP_TO_BORDER;
+        clampToBorder.wrapT = GL_CLAMP_TO_BORDER;
+        textureManager.loadTexture("IMAGE_VULKAN2", "../data/images/vulkan_mountain.png", clampToBorder);
 
         // Bind to programm
         glUseProgram(programManager("DEFAULT"));
@@ -137,11 +101,7 @@ namespace OpenGLExamples {
         glBindVertexArray(vaoManager.id);
         glBindBuffer(GL_ARRAY_BUFFER, bufferManager("VERTEX"));
 
-        glVertexAttribPointer(semantic::attr::POSITION, 3, GL_FLOAT, GL_FALSE, vaoManager.getVertexSize(), BUFFER_OFFSET(0));
-        glEnableVertexAttribArray(semantic::attr::POSITION);
-
-        glVertexAttribPointer(semantic::attr::TEXCOORD, 2, GL_FLOAT, GL_FALSE, vaoManager.getVertexSize(), BUFFER_OFFSET(sizeof(glm::vec3)));
-        glEnableVertexAttribArray(semantic::attr::TEXCOORD);
+        vaoManager.setupAttributes();
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
         // Bin element buffer array to array ob
@@ -158,7 +118,7 @@ namespace OpenGLExamples {
 
         if (handleManager.getHandles().empty())
             initHandles();
-        initProgram();
+        initPrograms();
         initBuffer();
         initTexture();
         initVertexArray();
@@ -176,12 +136,19 @@ namespace OpenGLExamples {
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     }
 
+    bool Transformations::reloadShaders(const std::set<std::string> &files) {
+        programManager.reload(shaderManager, files);
+        return true;
+    }
+
+    bool Transformations::usesShaderFiles(const std::set<std::string> &files) { return shaderManager.dependsOn(files); }
+
     void Transformations::clean() {
         glDeleteFramebuffers(framebufferManager.size(), &framebufferManager.framebuffers[0]);
         glDeleteProgram(programManager("DEFAULT"));
 
         glDeleteBuffers(bufferManager.size(), &bufferManager.buffers[0]);
-        glDeleteTextures(textureManager.size(), &textureManager.textures[0]);
+        textureManager.releaseStreamed();
         glDeleteVertexArrays(1, &vaoManager.id);
     }
 
@@ -199,15 +166,18 @@ namespace OpenGLExamples {
 
         glm::mat4 trans = glm::mat4(1.0f);
         trans = glm::scale(trans, glm::vec3(0.75f, 0.75f, 0.0f));
-        trans = glm::rotate(trans, (float)glfwGetTime(), glm::vec3(0.0f, 1.0f, 0.0f));
-        trans = glm::rotate(trans, (float)glfwGetTime() * 2.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+        trans = glm::rotate(trans, Qulkan::getTime(), glm::vec3(0.0f, 1.0f, 0.0f));
+        trans = glm::rotate(trans, Qulkan::getTime() * 2.0f, glm::vec3(1.0f, 0.0f, 0.0f));
 
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, textureManager("IMAGE_VULKAN1"));
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, textureManager("IMAGE_VULKAN2"));
+        // Drawn again once the streamed images replace the placeholders
+        if (textureManager.isLoading())
+            requestRedraw();
 
-        glUniform1f(glGetUniformLocation(programManager("DEFAULT"), "Mix"), handleManager("Mix")->getValue<float>());
+        glUniform1f(glGetUniformLocation(programManager("DEFAULT"), "Mix"), *mix);
 
         glUniformMatrix4fv(glGetUniformLocation(programManager("DEFAULT"), "transform"), 1, GL_FALSE, glm::value_ptr(trans));
 
@@ -18,15 +18,13 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#define BUFFER_OFFSET(i) ((char *)NULL + (i))
-
 namespace OpenGLExamples {
 
     void Colors::setCameraView() {
         // Camera settings
         float radius = 10.0f;
 
-        float sensitivity = handleManager("Camera Sensitivity")->getValue<float>();
+        float sensitivity = *cameraSensitivity;
         if (isMouseDragging(0)) {
             yaw += mouseDelta.x * sensitivity * Qulkan::getDeltaTime();
             pitch += -mouseDelta.y * sensitivity * Qulkan::getDeltaTime();
@@ -44,7 +42,6 @@ namespace OpenGLExamples {
         }
 
         if (mouseWheel != 0.0f) {
-            auto fov = std::any_cast<float>(&handleManager("FoV")->value);
             if (*fov >= 1.0f && *fov <= 45.0f)
                 *fov -= mouseWheel;
             if (*fov <= 1.0f)
@@ -53,17 +50,17 @@ namespace OpenGLExamples {
                 *fov = 45.0f;
         }
 
-        float cameraSpeed = handleManager("Camera Speed")->getValue<float>() * Qulkan::getDeltaTime();
+        float speed = *cameraSpeed * Qulkan::getDeltaTime();
         if (isKeyDown(GLFW_KEY_LEFT_SHIFT))
-            cameraSpeed = cameraSpeed * 3.0f;
+            speed = speed * 3.0f;
         if (isKeyDown(GLFW_KEY_W))
-            cameraPos += cameraSpeed * cameraFront;
+            cameraPos += speed * cameraFront;
         if (isKeyDown(GLFW_KEY_S))
-            cameraPos -= cameraSpeed * cameraFront;
+            cameraPos -= speed * cameraFront;
         if (isKeyDown(GLFW_KEY_A))
-            cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
+            cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * speed;
         if (isKeyDown(GLFW_KEY_D))
-            cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
+            cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * speed;
     }
 
     void Colors::createCube(VAOManager<glf::vertex_v3fv2f> &vaoManager) {
@@ -141,11 +138,22 @@ namespace OpenGLExamples {
         handleManager.addHandle(cameraSpeed);
         Handle cameraSensitivity("Camera Sensitivity", Type::FLOAT_HANDLE, 0.1f, 0.001f, 1.0f);
         handleManager.addHandle(cameraSensitivity);
+
+        resolveHandles();
     }
 
-    void Colors::initProgram() {
+    void Colors::resolveHandles() {
+        lightPosition = handleManager.getRef<glm::vec3>("Light Position");
+        lightColor = handleManager.getRef<glm::vec3>("Light Color");
+        objectColor = handleManager.getRef<glm::vec3>("Object Color");
+        fov = handleManager.getRef<float>("FoV");
+        nearPlane = handleManager.getRef<float>("Near Plane");
+        farPlane = handleManager.getRef<float>("Far Plane");
+        cameraSpeed = handleManager.getRef<float>("Camera Speed");
+        cameraSensitivity = handleManager.getRef<float>("Camera Sensitivity");
+    }
 
-        Compiler compiler;
+    void Colors::createPrograms() {
 
         // Cube shader
         shaderManager.addShader("VERT_CUBE", "../data/shaders/examples/lighting/colors_cube.vert", GL_VERTEX_SHADER, compiler);
@@ -157,24 +165,14 @@ namespace OpenGLExamples {
 
         programManager.addProgram("CUBE_SHADER");
 
-        glAttachShader(programManager("CUBE_SHADER"), shaderManager("VERT_CUBE"));
-        glAttachShader(programManager("CUBE_SHADER"), shaderManager("FRAG_CUBE"));
-        glLinkProgram(programManager("CUBE_SHADER"));
-
-        error = compiler.check() && error;
-        error = compiler.check_program(programManager("CUBE_SHADER")) && error;
+        programManager.link("CUBE_SHADER", {"VERT_CUBE", "FRAG_CUBE"}, shaderManager, compiler);
 
         programManager.addProgram("LIGHT_SHADER");
-        glAttachShader(programManager("LIGHT_SHADER"), shaderManager("VERT_LIGHT"));
-        glAttachShader(programManager("LIGHT_SHADER"), shaderManager("FRAG_LIGHT"));
-        glLinkProgram(programManager("LIGHT_SHADER"));
-
-        error = compiler.check() && error;
-        error = compiler.check_program(programManager("LIGHT_SHADER")) && error;
-
-        return;
+        programManager.link("LIGHT_SHADER", {"VERT_LIGHT", "FRAG_LIGHT"}, shaderManager, compiler);
     }
 
+    bool Colors::checkPrograms() { return programManager.check(shaderManager, compiler); }
+
     void Colors::initBuffer() {
 
         bufferManager.addBuffer("VERTEX");
@@ -198,22 +196,14 @@ namespace OpenGLExamples {
         glBindVertexArray(vaoCube.id);
         glBindBuffer(GL_ARRAY_BUFFER, bufferManager("VERTEX"));
 
-        glVertexAttribPointer(semantic::attr::POSITION, 3, GL_FLOAT, GL_FALSE, vaoCube.getVertexSize(), BUFFER_OFFSET(0));
-        glEnableVertexAttribArray(semantic::attr::POSITION);
-
-        glVertexAttribPointer(semantic::attr::TEXCOORD, 2, GL_FLOAT, GL_FALSE, vaoCube.getVertexSize(), BUFFER_OFFSET(sizeof(glm::vec3)));
-        glEnableVertexAttribArray(semantic::attr::TEXCOORD);
+        vaoCube.setupAttributes();
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
         glGenVertexArrays(1, &vaoLight.id);
         glBindVertexArray(vaoLight.id);
         glBindBuffer(GL_ARRAY_BUFFER, bufferManager("VERTEX"));
 
-        glVertexAttribPointer(semantic::attr::POSITION, 3, GL_FLOAT, GL_FALSE, vaoLight.getVertexSize(), BUFFER_OFFSET(0));
-        glEnableVertexAttribArray(semantic::attr::POSITION);
-
-        glVertexAttribPointer(semantic::attr::TEXCOORD, 2, GL_FLOAT, GL_FALSE, vaoLight.getVertexSize(), BUFFER_OFFSET(sizeof(glm::vec3)));
-        glEnableVertexAttribArray(semantic::attr::TEXCOORD);
+        vaoLight.setupAttributes();
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
         glBindVertexArray(0);
@@ -228,7 +218,7 @@ namespace OpenGLExamples {
 
         if (handleManager.getHandles().empty())
             initHandles();
-        initProgram();
+        initPrograms();
         initBuffer();
         initTexture();
         initVertexArray();
@@ -247,6 +237,13 @@ namespace OpenGLExamples {
         glEnable(GL_DEPTH_TEST);
     }
 
+    bool Colors::reloadShaders(const std::set<std::string> &files) {
+        programManager.reload(shaderManager, files);
+        return true;
+    }
+
+    bool Colors::usesShaderFiles(const std::set<std::string> &files) { return shaderManager.dependsOn(files); }
+
     void Colors::clean() {
         glDeleteFramebuffers(framebufferManager.size(), &framebufferManager.framebuffers[0]);
         glDeleteProgram(programManager("CUBE_SHADER"));
@@ -273,23 +270,17 @@ namespace OpenGLExamples {
         view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
 
         glm::mat4 projection;
-        float nearPlane = handleManager("Near Plane")->getValue<float>();
-        float farPlane = handleManager("Far Plane")->getValue<float>();
-
-        projection =
-            glm::perspective(glm::radians(handleManager("FoV")->getValue<float>()), (float)actualRenderWidth / actualRenderHeight, nearPlane, farPlane);
+        projection = glm::perspective(glm::radians(*fov), (float)actualRenderWidth / actualRenderHeight, *nearPlane, *farPlane);
 
         glm::mat4 model = glm::mat4(1.0f);
 
-        glm::vec3 lightColor = handleManager("Light Color")->getValue<glm::vec3>();
-        glm::vec3 lightPos = handleManager("Light Position")->getValue<glm::vec3>();
-        glm::vec3 objectColor = handleManager("Object Color")->getValue<glm::vec3>();
+        const glm::vec3 &lightPos = *lightPosition;
 
         glUseProgram(programManager("CUBE_SHADER"));
 
         // Bind uniforms to the cube shader program
-        glUniform3f(glGetUniformLocation(programManager("CUBE_SHADER"), "lightColor"), lightColor.r, lightColor.g, lightColor.b);
-        glUniform3f(glGetUniformLocation(programManager("CUBE_SHADER"), "objectColor"), objectColor.r, objectColor.g, objectColor.b);
+        glUniform3f(glGetUniformLocation(programManager("CUBE_SHADER"), "lightColor"), lightColor->r, lightColor->g, lightColor->b);
+        glUniform3f(glGetUniformLocation(programManager("CUBE_SHADER"), "objectColor"), objectColor->r, objectColor->g, objectColor->b);
         glUniformMatrix4fv(glGetUniformLocation(programManager("CUBE_SHADER"), "view"), 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(glGetUniformLocation(programManager("CUBE_SHADER"), "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
@@ -306,7 +297,7 @@ namespace OpenGLExamples {
         glUseProgram(programManager("LIGHT_SHADER"));
 
         // Bind uniforms to the light shader program
-        glUniform3f(glGetUniformLocation(programManager("LIGHT_SHADER"), "lightColor"), lightColor.r, lightColor.g, lightColor.b);
+        glUniform3f(glGetUniformLocation(programManager("LIGHT_SHADER"), "lightColor"), lightColor->r, lightColor->g, lightColor->b);
         glUniformMatrix4fv(glGetUniformLocation(programManager("LIGHT_SHADER"), "view"), 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(glGetUniformLocation(programManager("LIGHT_SHADER"), "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
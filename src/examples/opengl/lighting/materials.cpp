@@ -3,6 +3,7 @@
 #include <array>
 #include <glm/glm.hpp>
 #include <iostream>
+#include <limits>
 #include <string>
 
 #include <GL/gl3w.h>
@@ -18,15 +19,13 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#define BUFFER_OFFSET(i) ((char *)NULL + (i))
-
 namespace OpenGLExamples {
 
     void Materials::setCameraView() {
         // Camera settings
         float radius = 10.0f;
 
-        float sensitivity = handleManager("Camera Sensitivity")->getValue<float>();
+        float sensitivity = *cameraSensitivity;
         if (isMouseDragging(0)) {
             yaw += mouseDelta.x * sensitivity * Qulkan::getDeltaTime();
             pitch += -mouseDelta.y * sensitivity * Qulkan::getDeltaTime();
@@ -44,7 +43,6 @@ namespace OpenGLExamples {
         }
 
         if (mouseWheel != 0.0f) {
-            auto fov = std::any_cast<float>(&handleManager("FoV")->value);
             if (*fov >= 1.0f && *fov <= 180.0f)
                 *fov -= mouseWheel;
             if (*fov <= 1.0f)
@@ -53,62 +51,62 @@ namespace OpenGLExamples {
                 *fov = 180.0f;
         }
 
-        float cameraSpeed = handleManager("Camera Speed")->getValue<float>() * Qulkan::getDeltaTime();
+        float speed = *cameraSpeed * Qulkan::getDeltaTime();
         if (isKeyDown(GLFW_KEY_LEFT_SHIFT))
-            cameraSpeed = cameraSpeed * 3.0f;
+            speed = speed * 3.0f;
         if (isKeyDown(GLFW_KEY_W))
-            cameraPos += cameraSpeed * cameraFront;
+            cameraPos += speed * cameraFront;
         if (isKeyDown(GLFW_KEY_S))
-            cameraPos -= cameraSpeed * cameraFront;
+            cameraPos -= speed * cameraFront;
         if (isKeyDown(GLFW_KEY_A))
-            cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
+            cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * speed;
         if (isKeyDown(GLFW_KEY_D))
-            cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
+            cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * speed;
     }
 
-    void Materials::createCube(VAOManager<glf::vertex_v3fv3f> &vaoManager) {
-
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, 0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, 0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, 0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f)));
-
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(0.0f, 0.0f, 1.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.0f, 0.0f, 1.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(0.0f, 0.0f, 1.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(0.0f, 0.0f, 1.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, 0.5f, 0.5f), glm::vec3(0.0f, 0.0f, 1.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(0.0f, 0.0f, 1.0f)));
-
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, 0.5f, 0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, 0.5f, -0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, 0.5f, 0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)));
-
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(1.0f, 0.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, 0.5f, -0.5f), glm::vec3(1.0f, 0.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(1.0f, 0.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(1.0f, 0.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(1.0f, 0.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(1.0f, 0.0f, 0.0f)));
-
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, -1.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(0.0f, -1.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.0f, -1.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.0f, -1.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(0.0f, -1.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, -1.0f, 0.0f)));
-
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, 0.5f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, 0.5f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, 0.5f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
-        vaoManager.addVertex(glf::vertex_v3fv3f(glm::vec3(-0.5f, 0.5f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    void Materials::createCube(VAOManager<glf::vertex_v3fn3f> &vaoManager) {
+
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, 0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, 0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, 0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f)));
+
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(0.0f, 0.0f, 1.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.0f, 0.0f, 1.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(0.0f, 0.0f, 1.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(0.0f, 0.0f, 1.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, 0.5f, 0.5f), glm::vec3(0.0f, 0.0f, 1.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(0.0f, 0.0f, 1.0f)));
+
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, 0.5f, 0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, 0.5f, -0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, 0.5f, 0.5f), glm::vec3(-1.0f, 0.0f, 0.0f)));
+
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(1.0f, 0.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, 0.5f, -0.5f), glm::vec3(1.0f, 0.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(1.0f, 0.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(1.0f, 0.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(1.0f, 0.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(1.0f, 0.0f, 0.0f)));
+
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, -1.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(0.0f, -1.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.0f, -1.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.0f, -1.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(0.0f, -1.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, -1.0f, 0.0f)));
+
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, 0.5f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, 0.5f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, 0.5f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        vaoManager.addVertex(glf::vertex_v3fn3f(glm::vec3(-0.5f, 0.5f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f)));
     }
 
     void Materials::createGrid(int size) {
@@ -120,13 +118,13 @@ namespace OpenGLExamples {
 
         for (int j = -size; j <= size; j++) {
             glm::vec3 color = j == 0 ? xAxisColor : gridColor;
-            vaoGrid.addVertex(glf::vertex_v3fv3f(glm::vec3(j, 0.0, -(size + 1)), color));
-            vaoGrid.addVertex(glf::vertex_v3fv3f(glm::vec3(j, 0.0, (size + 1)), color));
+            vaoGrid.addVertex(glf::vertex_v3fc3f(glm::vec3(j, 0.0, -(size + 1)), color));
+            vaoGrid.addVertex(glf::vertex_v3fc3f(glm::vec3(j, 0.0, (size + 1)), color));
         }
         for (int j = -size; j <= size; j++) {
             glm::vec3 color = j == 0 ? zAxisColor : gridColor;
-            vaoGrid.addVertex(glf::vertex_v3fv3f(glm::vec3(-(size + 1), 0.0, j), color));
-            vaoGrid.addVertex(glf::vertex_v3fv3f(glm::vec3((size + 1), 0.0, j), color));
+            vaoGrid.addVertex(glf::vertex_v3fc3f(glm::vec3(-(size + 1), 0.0, j), color));
+            vaoGrid.addVertex(glf::vertex_v3fc3f(glm::vec3((size + 1), 0.0, j), color));
         }
         for (int i = 0; i < (2 * size + 1) * 2 * 2; i += 2) {
             eboGrid.addLine(i, i + 1);
@@ -138,6 +136,11 @@ namespace OpenGLExamples {
         createCube(vaoLight);
         createCube(vaoCube);
         createGrid(100);
+
+        cubeNode = scene.create();
+        gridNode = scene.create();
+        lightNode = scene.create();
+        lightNodePosition = glm::vec3(std::numeric_limits<float>::max()); // Placed by the first render
     }
 
     void Materials::initHandles() {
@@ -179,11 +182,27 @@ namespace OpenGLExamples {
         handleManager.addHandle(cameraSpeed);
         Handle cameraSensitivity("Camera Sensitivity", Type::FLOAT_HANDLE, 0.1f, 0.001f, 1.0f);
         handleManager.addHandle(cameraSensitivity);
+
+        resolveHandles();
     }
 
-    void Materials::initProgram() {
+    void Materials::resolveHandles() {
+        lightPosition = handleManager.getRef<glm::vec3>("Light Position");
+        lightAmbientColor = handleManager.getRef<glm::vec3>("Ambient Color##light");
+        lightDiffuseColor = handleManager.getRef<glm::vec3>("Diffuse Color##light");
+        lightSpecularColor = handleManager.getRef<glm::vec3>("Specular Color##light");
+        ambientColor = handleManager.getRef<glm::vec3>("Ambient Color##material");
+        diffuseColor = handleManager.getRef<glm::vec3>("Diffuse Color##material");
+        specularColor = handleManager.getRef<glm::vec3>("Specular Color##material");
+        shininess = handleManager.getRef<float>("Shininess##material");
+        fov = handleManager.getRef<float>("FoV");
+        nearPlane = handleManager.getRef<float>("Near Plane");
+        farPlane = handleManager.getRef<float>("Far Plane");
+        cameraSpeed = handleManager.getRef<float>("Camera Speed");
+        cameraSensitivity = handleManager.getRef<float>("Camera Sensitivity");
+    }
 
-        Compiler compiler;
+    void Materials::createPrograms() {
 
         // Cube shader
         shaderManager.addShader("VERT_CUBE", "../data/shaders/examples/lighting/materials_cube.vert", GL_VERTEX_SHADER, compiler);
@@ -198,30 +217,43 @@ namespace OpenGLExamples {
         shaderManager.addShader("FRAG_GRID", "../data/shaders/examples/lighting/grid.frag", GL_FRAGMENT_SHADER, compiler);
 
         programManager.addProgram("CUBE_SHADER");
-        glAttachShader(programManager("CUBE_SHADER"), shaderManager("VERT_CUBE"));
-        glAttachShader(programManager("CUBE_SHADER"), shaderManager("FRAG_CUBE"));
-        glLinkProgram(programManager("CUBE_SHADER"));
-
-        error = compiler.check() && error;
-        error = compiler.check_program(programManager("CUBE_SHADER")) && error;
+        programManager.link("CUBE_SHADER", {"VERT_CUBE", "FRAG_CUBE"}, shaderManager, compiler);
 
         programManager.addProgram("LIGHT_SHADER");
-        glAttachShader(programManager("LIGHT_SHADER"), shaderManager("VERT_LIGHT"));
-        glAttachShader(programManager("LIGHT_SHADER"), shaderManager("FRAG_LIGHT"));
-        glLinkProgram(programManager("LIGHT_SHADER"));
-
-        error = compiler.check() && error;
-        error = compiler.check_program(programManager("LIGHT_SHADER")) && error;
+        programManager.link("LIGHT_SHADER", {"VERT_LIGHT", "FRAG_LIGHT"}, shaderManager, compiler);
 
         programManager.addProgram("GRID_SHADER");
-        glAttachShader(programManager("GRID_SHADER"), shaderManager("VERT_GRID"));
-        glAttachShader(programManager("GRID_SHADER"), shaderManager("FRAG_GRID"));
-        glLinkProgram(programManager("GRID_SHADER"));
-
-        error = compiler.check() && error;
-        error = compiler.check_program(programManager("GRID_SHADER")) && error;
+        programManager.link("GRID_SHADER", {"VERT_GRID", "FRAG_GRID"}, shaderManager, compiler);
+    }
 
-        return;
+    bool Materials::checkPrograms() { return programManager.check(shaderManager, compiler); }
+
+    void Materials::resolveUniforms() {
+        programManager.reflect("CUBE_SHADER");
+        cubeUniforms.materialAmbient = programManager.uniform("CUBE_SHADER", "material.ambient");
+        cubeUniforms.materialDiffuse = programManager.uniform("CUBE_SHADER", "material.diffuse");
+        cubeUniforms.materialSpecular = programManager.uniform("CUBE_SHADER", "material.specular");
+        cubeUniforms.materialShininess = programManager.uniform("CUBE_SHADER", "material.shininess");
+        cubeUniforms.lightPosition = programManager.uniform("CUBE_SHADER", "light.position");
+        cubeUniforms.lightAmbient = programManager.uniform("CUBE_SHADER", "light.ambient");
+        cubeUniforms.lightDiffuse = programManager.uniform("CUBE_SHADER", "light.diffuse");
+        cubeUniforms.lightSpecular = programManager.uniform("CUBE_SHADER", "light.specular");
+        cubeUniforms.viewPos = programManager.uniform("CUBE_SHADER", "viewPos");
+        cubeUniforms.view = programManager.uniform("CUBE_SHADER", "view");
+        cubeUniforms.projection = programManager.uniform("CUBE_SHADER", "projection");
+        cubeUniforms.model = programManager.uniform("CUBE_SHADER", "model");
+        cubeUniforms.normalMatrix = programManager.uniform("CUBE_SHADER", "normalMatrix");
+
+        programManager.reflect("LIGHT_SHADER");
+        lightUniforms.lightColor = programManager.uniform("LIGHT_SHADER", "lightColor");
+        lightUniforms.view = programManager.uniform("LIGHT_SHADER", "view");
+        lightUniforms.projection = programManager.uniform("LIGHT_SHADER", "projection");
+        lightUniforms.model = programManager.uniform("LIGHT_SHADER", "model");
+
+        programManager.reflect("GRID_SHADER");
+        gridUniforms.view = programManager.uniform("GRID_SHADER", "view");
+        gridUniforms.projection = programManager.uniform("GRID_SHADER", "projection");
+        gridUniforms.model = programManager.uniform("GRID_SHADER", "model");
     }
 
     void Materials::initBuffer() {
@@ -259,11 +291,7 @@ namespace OpenGLExamples {
         glBindVertexArray(vaoCube.id);
         glBindBuffer(GL_ARRAY_BUFFER, bufferManager("VERTEX"));
 
-        glVertexAttribPointer(semantic::attr::POSITION, 3, GL_FLOAT, GL_FALSE, vaoCube.getVertexSize(), BUFFER_OFFSET(0));
-        glEnableVertexAttribArray(semantic::attr::POSITION);
-
-        glVertexAttribPointer(semantic::attr::NORMAL, 3, GL_FLOAT, GL_FALSE, vaoCube.getVertexSize(), BUFFER_OFFSET(sizeof(glm::vec3)));
-        glEnableVertexAttribArray(semantic::attr::NORMAL);
+        vaoCube.setupAttributes();
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
 
@@ -273,8 +301,7 @@ namespace OpenGLExamples {
         glBindVertexArray(vaoLight.id);
         glBindBuffer(GL_ARRAY_BUFFER, bufferManager("VERTEX"));
 
-        glVertexAttribPointer(semantic::attr::POSITION, 3, GL_FLOAT, GL_FALSE, vaoLight.getVertexSize(), BUFFER_OFFSET(0));
-        glEnableVertexAttribArray(semantic::attr::POSITION);
+        vaoLight.setupAttributes();
 
         /////////////////////////////
 
@@ -283,11 +310,7 @@ namespace OpenGLExamples {
         {
             glBindBuffer(GL_ARRAY_BUFFER, bufferManager("VERTEX_GRID"));
 
-            glVertexAttribPointer(semantic::attr::POSITION, 3, GL_FLOAT, GL_FALSE, vaoGrid.getVertexSize(), BUFFER_OFFSET(0));
-            glEnableVertexAttribArray(semantic::attr::POSITION);
-
-            glVertexAttribPointer(semantic::attr::COLOR, 3, GL_FLOAT, GL_FALSE, vaoGrid.getVertexSize(), BUFFER_OFFSET(sizeof(glm::vec3)));
-            glEnableVertexAttribArray(semantic::attr::COLOR);
+            vaoGrid.setupAttributes();
             glBindBuffer(GL_ARRAY_BUFFER, 0);
 
             // Bin element buffer array to array ob
@@ -305,7 +328,8 @@ namespace OpenGLExamples {
 
         if (handleManager.getHandles().empty())
             initHandles();
-        initProgram();
+        initPrograms();
+        resolveUniforms();
         initBuffer();
         initTexture();
         initVertexArray();
@@ -324,6 +348,14 @@ namespace OpenGLExamples {
         glEnable(GL_DEPTH_TEST);
     }
 
+    bool Materials::reloadShaders(const std::set<std::string> &files) {
+        if (!programManager.reload(shaderManager, files).empty())
+            resolveUniforms();
+        return true;
+    }
+
+    bool Materials::usesShaderFiles(const std::set<std::string> &files) { return shaderManager.dependsOn(files); }
+
     void Materials::clean() {
         glDeleteFramebuffers(framebufferManager.size(), &framebufferManager.framebuffers[0]);
         glDeleteProgram(programManager("CUBE_SHADER"));
@@ -351,52 +383,43 @@ namespace OpenGLExamples {
         view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
 
         glm::mat4 projection;
-        float nearPlane = handleManager("Near Plane")->getValue<float>();
-        float farPlane = handleManager("Far Plane")->getValue<float>();
-
-        projection =
-            glm::perspective(glm::radians(handleManager("FoV")->getValue<float>()), (float)actualRenderWidth / actualRenderHeight, nearPlane, farPlane);
+        projection = glm::perspective(glm::radians(*fov), (float)actualRenderWidth / actualRenderHeight, *nearPlane, *farPlane);
 
-        glm::mat4 model = glm::mat4(1.0f);
+        const glm::vec3 &lightPos = *lightPosition;
 
-        glm::vec3 lightPos = handleManager("Light Position")->getValue<glm::vec3>();
-        glm::vec3 lightAmbientColor = handleManager("Ambient Color##light")->getValue<glm::vec3>();
-        glm::vec3 lightDiffuseColor = handleManager("Diffuse Color##light")->getValue<glm::vec3>();
-        glm::vec3 lightSpecularColor = handleManager("Specular Color##light")->getValue<glm::vec3>();
-        glm::vec3 ambientColor = handleManager("Ambient Color##material")->getValue<glm::vec3>();
-        glm::vec3 diffuseColor = handleManager("Diffuse Color##material")->getValue<glm::vec3>();
-        glm::vec3 specularColor = handleManager("Specular Color##material")->getValue<glm::vec3>();
-        float shininess = handleManager("Shininess##material")->getValue<float>();
+        // The cube and the grid are static, their matrices were computed once
+        if (lightPos != lightNodePosition) {
+            lightNodePosition = lightPos;
+            scene.setLocal(lightNode, glm::scale(glm::translate(glm::mat4(1.0f), lightPos), glm::vec3(0.25f)));
+        }
+        scene.update();
 
         glUseProgram(programManager("CUBE_SHADER"));
 
-        // Bind uniforms to the cube shader program
+        // Bind uniforms to the cube shader program, only the values that changed since the last frame reach the driver
         // Object's material
-        glUniform3f(glGetUniformLocation(programManager("CUBE_SHADER"), "material.ambient"), ambientColor.r, ambientColor.g, ambientColor.b);
-        glUniform3f(glGetUniformLocation(programManager("CUBE_SHADER"), "material.diffuse"), diffuseColor.r, diffuseColor.g, diffuseColor.b);
-        glUniform3f(glGetUniformLocation(programManager("CUBE_SHADER"), "material.specular"), specularColor.r, specularColor.g, specularColor.b);
-        glUniform1f(glGetUniformLocation(programManager("CUBE_SHADER"), "material.shininess"), shininess);
+        cubeUniforms.materialAmbient.set(*ambientColor);
+        cubeUniforms.materialDiffuse.set(*diffuseColor);
+        cubeUniforms.materialSpecular.set(*specularColor);
+        cubeUniforms.materialShininess.set(*shininess);
         // Light properties
-        glUniform3f(glGetUniformLocation(programManager("CUBE_SHADER"), "light.position"), lightPos.x, lightPos.y, lightPos.z);
-        glUniform3f(glGetUniformLocation(programManager("CUBE_SHADER"), "viewPos"), cameraPos.x, cameraPos.y, cameraPos.z);
-        glUniform3f(glGetUniformLocation(programManager("CUBE_SHADER"), "light.ambient"), lightAmbientColor.r, lightAmbientColor.g, lightAmbientColor.b);
-        glUniform3f(glGetUniformLocation(programManager("CUBE_SHADER"), "light.diffuse"), lightDiffuseColor.r, lightDiffuseColor.g, lightDiffuseColor.b);
-        glUniform3f(glGetUniformLocation(programManager("CUBE_SHADER"), "light.specular"), lightSpecularColor.r, lightSpecularColor.g, lightSpecularColor.b);
+        cubeUniforms.lightPosition.set(lightPos);
+        cubeUniforms.lightAmbient.set(*lightAmbientColor);
+        cubeUniforms.lightDiffuse.set(*lightDiffuseColor);
+        cubeUniforms.lightSpecular.set(*lightSpecularColor);
 
         // Eye position
-        glUniform3f(glGetUniformLocation(programManager("CUBE_SHADER"), "viewPos"), cameraPos.x, cameraPos.y, cameraPos.z);
+        cubeUniforms.viewPos.set(cameraPos);
         // VP matrix
-        glUniformMatrix4fv(glGetUniformLocation(programManager("CUBE_SHADER"), "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(programManager("CUBE_SHADER"), "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        cubeUniforms.view.set(view);
+        cubeUniforms.projection.set(projection);
 
         // Draw the Cube
         glBindVertexArray(vaoCube.id);
         {
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, 0));
-            glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
             // Bind the model for the draw call
-            glUniformMatrix4fv(glGetUniformLocation(programManager("CUBE_SHADER"), "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniformMatrix3fv(glGetUniformLocation(programManager("CUBE_SHADER"), "normalMatrix"), 1, GL_FALSE, glm::value_ptr(normalMatrix));
+            cubeUniforms.model.set(scene.getWorld(cubeNode));
+            cubeUniforms.normalMatrix.set(scene.getNormalMatrix(cubeNode));
 
             // Draw a cube using draw arrays without any ebo to avoid having to set unique texture coordinates for each face.
             glDrawArrays(GL_TRIANGLES, 0, vaoCube.getVertexCount());
@@ -405,17 +428,15 @@ namespace OpenGLExamples {
         glUseProgram(programManager("LIGHT_SHADER"));
 
         // Bind uniforms to the light shader program
-        glUniform3f(glGetUniformLocation(programManager("LIGHT_SHADER"), "lightColor"), lightDiffuseColor.r, lightDiffuseColor.g, lightDiffuseColor.b);
-        glUniformMatrix4fv(glGetUniformLocation(programManager("LIGHT_SHADER"), "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(programManager("LIGHT_SHADER"), "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        lightUniforms.lightColor.set(*lightDiffuseColor);
+        lightUniforms.view.set(view);
+        lightUniforms.projection.set(projection);
 
         // Draw the Light
         glBindVertexArray(vaoLight.id);
         {
-            model = glm::translate(glm::mat4(1.0f), lightPos);
-            model = glm::scale(model, glm::vec3(0.25, 0.25, 0.25));
             // Bind the model for the draw call
-            glUniformMatrix4fv(glGetUniformLocation(programManager("LIGHT_SHADER"), "model"), 1, GL_FALSE, glm::value_ptr(model));
+            lightUniforms.model.set(scene.getWorld(lightNode));
             // Draw a cube using draw arrays without any ebo to avoid having to set unique texture coordinates for each face.
             glDrawArrays(GL_TRIANGLES, 0, vaoLight.getVertexCount());
         }
@@ -423,13 +444,12 @@ namespace OpenGLExamples {
         glUseProgram(programManager("GRID_SHADER"));
 
         // Bind uniforms to the cube shader program
-        glUniformMatrix4fv(glGetUniformLocation(programManager("GRID_SHADER"), "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(programManager("GRID_SHADER"), "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        gridUniforms.view.set(view);
+        gridUniforms.projection.set(projection);
 
         glBindVertexArray(vaoGrid.id);
         {
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, 0));
-            glUniformMatrix4fv(glGetUniformLocation(programManager("GRID_SHADER"), "model"), 1, GL_FALSE, glm::value_ptr(model));
+            gridUniforms.model.set(scene.getWorld(gridNode));
 
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferManager("ELEMENT_GRID"));
             // glPointSize(64);
@@ -0,0 +1,281 @@
+#include "examples/opengl/performance/instancing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <string>
+
+#include <GL/gl3w.h>
+#include <GLFW/glfw3.h>
+
+#include "framework/opengl/compiler.h"
+#include "framework/opengl/semantics.h"
+#include "framework/opengl/vertex.h"
+#include "qulkan/logger.h"
+#include "qulkan/profiler.h"
+#include "qulkan/utils.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace OpenGLExamples {
+
+    namespace {
+        // Spacing between the centers of the unit cubes of the lattice
+        const float LATTICE_SPACING = 1.6f;
+
+        // Bounds of the unit cube, for the GPU culling
+        const glm::vec4 CUBE_BOUNDING_SPHERE = glm::vec4(0.0f, 0.0f, 0.0f, 0.8660254f);
+    } // namespace
+
+    Instancing::Instancing(const char *viewName, int initialRenderWidth, int initialRenderHeight, int initialInstanceCount)
+        : Qulkan::RenderView(viewName, initialRenderWidth, initialRenderHeight), initialInstanceCount(std::max(initialInstanceCount, 1)),
+          instanceCount(0) {
+        setContinuousRendering(true);
+        createCube();
+    }
+
+    void Instancing::createCube() {
+        // One quad per face so that each face has its own normal, indexed to exercise glDrawElementsInstanced
+        const glm::vec3 normals[6] = {glm::vec3(0, 0, -1), glm::vec3(0, 0, 1),  glm::vec3(-1, 0, 0),
+                                      glm::vec3(1, 0, 0),  glm::vec3(0, -1, 0), glm::vec3(0, 1, 0)};
+        for (int face = 0; face < 6; ++face) {
+            glm::vec3 normal = normals[face];
+            glm::vec3 u = std::abs(normal.y) > 0.5f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+            glm::vec3 v = glm::cross(normal, u);
+
+            GLuint first = GLuint(vaoCube.getVertexCount());
+            vaoCube.addVertex(glf::vertex_v3fn3f(0.5f * (normal - u - v), normal));
+            vaoCube.addVertex(glf::vertex_v3fn3f(0.5f * (normal + u - v), normal));
+            vaoCube.addVertex(glf::vertex_v3fn3f(0.5f * (normal + u + v), normal));
+            vaoCube.addVertex(glf::vertex_v3fn3f(0.5f * (normal - u + v), normal));
+            // Counter clockwise seen from outside the cube
+            eboCube.addTriangle(first, first + 1, first + 2);
+            eboCube.addTriangle(first, first + 2, first + 3);
+        }
+    }
+
+    void Instancing::initHandles() {
+
+        Handle instances("Instances (log10)", Type::FLOAT_HANDLE, float(std::log10(double(initialInstanceCount))), 3.0f, 6.0f);
+        handleManager.addHandle(instances);
+
+        Handle animate("Animate", Type::BOOL_HANDLE, true);
+        handleManager.addHandle(animate);
+
+        // Off by default so that the headless timings keep measuring the draw of every instance
+        Handle gpuCulling("GPU Culling", Type::BOOL_HANDLE, false);
+        handleManager.addHandle(gpuCulling);
+
+        Handle fov("FoV", Type::FLOAT_HANDLE, 45.0f, 10.0f, 120.0f);
+        handleManager.addHandle(fov);
+
+        Handle cameraSensitivity("Camera Sensitivity", Type::FLOAT_HANDLE, 0.1f, 0.001f, 1.0f);
+        handleManager.addHandle(cameraSensitivity);
+
+        resolveHandles();
+    }
+
+    void Instancing::resolveHandles() {
+        instancesLog10 = handleManager.getRef<float>("Instances (log10)");
+        animate = handleManager.getRef<bool>("Animate");
+        gpuCulling = handleManager.getRef<bool>("GPU Culling");
+        fov = handleManager.getRef<float>("FoV");
+        cameraSensitivity = handleManager.getRef<float>("Camera Sensitivity");
+    }
+
+    void Instancing::createPrograms() {
+        shaderManager.addShader("VERT_INSTANCING", "../data/shaders/examples/performance/instancing.vert", GL_VERTEX_SHADER, compiler);
+        shaderManager.addShader("FRAG_INSTANCING", "../data/shaders/examples/performance/instancing.frag", GL_FRAGMENT_SHADER, compiler);
+
+        programManager.addProgram("INSTANCING_SHADER");
+        programManager.link("INSTANCING_SHADER", {"VERT_INSTANCING", "FRAG_INSTANCING"}, shaderManager, compiler);
+
+        if (GPUCulling::supported())
+            GPUCulling::submitProgram(shaderManager, programManager, compiler);
+    }
+
+    bool Instancing::checkPrograms() { return programManager.check(shaderManager, compiler); }
+
+    void Instancing::resolveUniforms() {
+        programManager.reflect("INSTANCING_SHADER");
+        cubeUniforms.view = programManager.uniform("INSTANCING_SHADER", "view");
+        cubeUniforms.projection = programManager.uniform("INSTANCING_SHADER", "projection");
+        cubeUniforms.viewPos = programManager.uniform("INSTANCING_SHADER", "viewPos");
+        cubeUniforms.lightDirection = programManager.uniform("INSTANCING_SHADER", "lightDirection");
+        cubeUniforms.materials = programManager.uniformLocation("INSTANCING_SHADER", "materials");
+
+        // Specular intensity in rgb and shininess in w, indexed by the material of each instance
+        const glm::vec4 materials[MATERIAL_COUNT] = {glm::vec4(0.05f, 0.05f, 0.05f, 8.0f), glm::vec4(0.5f, 0.5f, 0.5f, 32.0f),
+                                                     glm::vec4(0.9f, 0.85f, 0.7f, 128.0f), glm::vec4(0.3f, 0.3f, 0.35f, 256.0f)};
+        if (cubeUniforms.materials != -1) {
+            glUseProgram(programManager("INSTANCING_SHADER"));
+            glUniform4fv(cubeUniforms.materials, MATERIAL_COUNT, glm::value_ptr(materials[0]));
+            glUseProgram(0);
+        }
+    }
+
+    void Instancing::initBuffer() {
+
+        bufferManager.addBuffer("VERTEX");
+        bufferManager.addBuffer("ELEMENT");
+
+        glGenBuffers(bufferManager.size(), &bufferManager.buffers[0]);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferManager("ELEMENT"));
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, eboCube.getElementSize(), &eboCube.elementData[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, bufferManager("VERTEX"));
+        glBufferData(GL_ARRAY_BUFFER, vaoCube.getVertexDataSize(), &vaoCube.vertexData[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        instanceCount = 0;
+        resizeInstances();
+    }
+
+    void Instancing::initVertexArray() {
+        glGenVertexArrays(1, &vaoCube.id);
+        glBindVertexArray(vaoCube.id);
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, bufferManager("VERTEX"));
+            vaoCube.setupAttributes();
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            // The instance attributes are pointed at the instance buffer by every draw of the InstanceRenderer
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferManager("ELEMENT"));
+        }
+        glBindVertexArray(0);
+    }
+
+    void Instancing::init() {
+        Qulkan::Logger::Info("%s: Initialisation\n", name());
+
+        if (handleManager.getHandles().empty())
+            initHandles();
+        initPrograms();
+        resolveUniforms();
+        initBuffer();
+        initVertexArray();
+        initOpenGLOptions();
+        if (!error) {
+            Qulkan::Logger::Info("%s: Initialisation Done\n", name());
+            initialized = true;
+        } else
+            Qulkan::Logger::Error("%s: An error Occured during initialisation\n", name());
+    }
+
+    void Instancing::initOpenGLOptions() { glEnable(GL_DEPTH_TEST); }
+
+    bool Instancing::reloadShaders(const std::set<std::string> &files) {
+        if (!programManager.reload(shaderManager, files).empty()) {
+            resolveUniforms();
+            culling.resolveUniforms();
+        }
+        return true;
+    }
+
+    bool Instancing::usesShaderFiles(const std::set<std::string> &files) { return shaderManager.dependsOn(files); }
+
+    void Instancing::clean() {
+        instanceRenderer.destroy();
+        culling.destroy();
+        glDeleteProgram(programManager("INSTANCING_SHADER"));
+        if (GPUCulling::supported())
+            glDeleteProgram(programManager(GPUCulling::PROGRAM));
+
+        if (bufferManager.size() > 0)
+            glDeleteBuffers(bufferManager.size(), &bufferManager.buffers[0]);
+        glDeleteVertexArrays(1, &vaoCube.id);
+    }
+
+    /* Follows the instance count handle, the instance buffer only grows */
+    void Instancing::resizeInstances() {
+        GLsizei count = GLsizei(std::lround(std::pow(10.0, double(*instancesLog10))));
+        if (count == instanceCount)
+            return;
+
+        instanceCount = count;
+        if (instanceCount > instanceRenderer.capacity() && !instanceRenderer.create(instanceCount)) {
+            Qulkan::Logger::Error("%s: Could not allocate the buffer of %d instances\n", name(), instanceCount);
+            instanceCount = 0;
+            return;
+        }
+        // Without culling when its buffers can't be allocated, the view still draws every instance
+        if (GPUCulling::supported() && instanceCount > culling.capacity() && !culling.create(programManager, instanceRenderer.capacity()))
+            Qulkan::Logger::Warning("%s: GPU culling unavailable for %d instances\n", name(), instanceCount);
+        Qulkan::Logger::Info("%s: %d instances, %d triangles\n", name(), instanceCount, int(instanceCount * (eboCube.getElementCount() / 3)));
+    }
+
+    /* Cubes of a lattice centered on the origin, each spinning at its own speed */
+    void Instancing::writeInstances(InstanceRenderer::Range const &range, float time) {
+        QULKAN_PROFILE_ZONE("Instancing::writeInstances");
+
+        const Lattice lattice(range.count, LATTICE_SPACING);
+        const glm::vec3 axis = glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f));
+        InstanceRenderer::Instance *instances = range.data;
+
+#pragma omp parallel for schedule(static)
+        for (GLsizei i = 0; i < range.count; ++i) {
+            float phase = Lattice::phase(i);
+            float angle = phase * 6.2831853f + time * (0.5f + phase);
+
+            glm::mat4 transform = glm::translate(glm::mat4(1.0f), lattice.position(i));
+            transform = glm::rotate(transform, angle, axis);
+
+            instances[i] = InstanceRenderer::Instance(transform, Lattice::color(phase), std::uint32_t(i % MATERIAL_COUNT));
+        }
+    }
+
+    void Instancing::render(int actualRenderWidth, int actualRenderHeight) {
+        ASSERT(initialized, std::string(name()) + ": You need to init the view first");
+
+        glViewport(0, 0, actualRenderWidth, actualRenderHeight);
+
+        glClearColor(0.233f, 0.233f, 0.233f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        resizeInstances();
+
+        // Orbit around the lattice
+        camera.update(isMouseDragging(0) ? mouseDelta : glm::vec2(0.0f), mouseWheel, *cameraSensitivity, Qulkan::getDeltaTime());
+
+        float extent = Lattice(instanceCount, LATTICE_SPACING).extent();
+        float distance = camera.distance(extent);
+        glm::vec3 eye = camera.eye(extent);
+
+        glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection =
+            glm::perspective(glm::radians(*fov), (float)actualRenderWidth / actualRenderHeight, 0.1f, distance + extent * 2.0f);
+
+        instanceRenderer.beginFrame();
+
+        InstanceRenderer::Range range = instanceRenderer.allocate(instanceCount);
+        writeInstances(range, *animate ? Qulkan::getTime() : 0.0f);
+
+        // The visible instances and their count stay on the GPU, they are drawn indirectly
+        ArenaMesh cube;
+        cube.indexCount = GLuint(eboCube.getElementCount());
+        cube.vertexCount = GLuint(vaoCube.getVertexCount());
+        bool culled = *gpuCulling && culling.cull(instanceRenderer, range, cube, CUBE_BOUNDING_SPHERE, Frustum::fromMatrix(projection * view));
+
+        glUseProgram(programManager("INSTANCING_SHADER"));
+        cubeUniforms.view.set(view);
+        cubeUniforms.projection.set(projection);
+        cubeUniforms.viewPos.set(eye);
+        cubeUniforms.lightDirection.set(glm::vec3(-0.3f, -1.0f, -0.5f));
+
+        // Back faces are half of the fragments of a million cubes, culling is only enabled for this draw as the context is shared
+        glEnable(GL_CULL_FACE);
+        if (culled)
+            culling.drawElements(vaoCube.id, GL_TRIANGLES);
+        else
+            instanceRenderer.drawElements(vaoCube.id, GL_TRIANGLES, GLsizei(eboCube.getElementCount()), GL_UNSIGNED_INT, 0, range);
+        glDisable(GL_CULL_FACE);
+        glBindVertexArray(0);
+
+        instanceRenderer.endFrame();
+    }
+
+} // namespace OpenGLExamples
@@ -0,0 +1,331 @@
+#include "examples/opengl/performance/multidraw.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <random>
+#include <string>
+
+#include <GL/gl3w.h>
+#include <GLFW/glfw3.h>
+
+#include "framework/opengl/compiler.h"
+#include "framework/opengl/semantics.h"
+#include "framework/opengl/vertex.h"
+#include "qulkan/logger.h"
+#include "qulkan/profiler.h"
+#include "qulkan/utils.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace OpenGLExamples {
+
+    namespace {
+        // Spacing between the centers of the objects, larger than the largest mesh
+        const float LATTICE_SPACING = 2.0f;
+
+        // One object out of MODEL_STRIDE is a model instead of a box
+        const int MODEL_STRIDE = 4;
+        const char *const MODEL_FILES[] = {"../data/models/icosphere.obj", "../data/models/torus.ply"};
+    } // namespace
+
+    MultiDraw::MultiDraw(const char *viewName, int initialRenderWidth, int initialRenderHeight, int objectCount)
+        : Qulkan::RenderView(viewName, initialRenderWidth, initialRenderHeight), objectCount(std::max(objectCount, 1)) {
+        setContinuousRendering(true);
+    }
+
+    /* Imports the models once, a missing file only leaves its objects as boxes */
+    void MultiDraw::loadModels() {
+        if (!models.empty())
+            return;
+
+        for (const char *file : MODEL_FILES) {
+            Mesh model;
+            if (!MeshLoader::load(file, model) || model.vertices.empty())
+                continue;
+
+            glm::vec3 low = model.vertices[0].Position;
+            glm::vec3 high = low;
+            for (const glf::vertex_v3fn3fv2f &vertex : model.vertices) {
+                low = glm::min(low, vertex.Position);
+                high = glm::max(high, vertex.Position);
+            }
+            glm::vec3 center = (low + high) * 0.5f;
+            glm::vec3 halfSize = (high - low) * 0.5f;
+            float scale = 1.0f / std::max(std::max(halfSize.x, halfSize.y), std::max(halfSize.z, 1e-6f));
+            for (glf::vertex_v3fn3fv2f &vertex : model.vertices)
+                vertex.Position = (vertex.Position - center) * scale;
+
+            models.push_back(std::move(model));
+        }
+    }
+
+    /* Rounded boxes, every object gets its own extents, tessellation and roundness. Every MODEL_STRIDE-th object is a model */
+    void MultiDraw::createMeshes() {
+        QULKAN_PROFILE_ZONE("MultiDraw::createMeshes");
+
+        loadModels();
+
+        const glm::vec3 normals[6] = {glm::vec3(0, 0, -1), glm::vec3(0, 0, 1),  glm::vec3(-1, 0, 0),
+                                      glm::vec3(1, 0, 0),  glm::vec3(0, -1, 0), glm::vec3(0, 1, 0)};
+
+        // Sized for the average box plus the models, the arena grows if needed
+        GLsizeiptr modelObjects = models.empty() ? 0 : (objectCount + MODEL_STRIDE - 1) / MODEL_STRIDE;
+        GLsizeiptr modelVertices = 0;
+        GLsizeiptr modelIndices = 0;
+        for (int model = 0; model < int(models.size()); ++model) {
+            GLsizeiptr count = (modelObjects + GLsizeiptr(models.size()) - 1 - model) / GLsizeiptr(models.size());
+            modelVertices += count * GLsizeiptr(models[model].vertices.size());
+            modelIndices += count * GLsizeiptr(models[model].indices.size());
+        }
+        arena.create((objectCount - modelObjects) * 6 * 9 + modelVertices, (objectCount - modelObjects) * 6 * 24 + modelIndices);
+        meshes.clear();
+        meshes.reserve(objectCount);
+        meshBounds.clear();
+        meshBounds.reserve(objectCount);
+        culler.clear();
+
+        std::vector<glf::vertex_v3fn3f> vertices;
+        std::vector<GLuint> indices;
+        for (int object = 0; object < objectCount; ++object) {
+            std::mt19937 random(static_cast<unsigned>(object));
+            std::uniform_real_distribution<float> extentDistribution(0.3f, 0.8f);
+            std::uniform_real_distribution<float> roundnessDistribution(0.0f, 1.0f);
+            glm::vec3 extent = glm::vec3(extentDistribution(random), extentDistribution(random), extentDistribution(random));
+            float roundness = roundnessDistribution(random);
+            int tessellation = 1 + int(random() % 4);
+
+            vertices.clear();
+            indices.clear();
+            if (!models.empty() && object % MODEL_STRIDE == 0) {
+                // Scaled uniformly to the largest extent of the object
+                const Mesh &model = models[(object / MODEL_STRIDE) % models.size()];
+                float scale = std::max(extent.x, std::max(extent.y, extent.z));
+                for (const glf::vertex_v3fn3fv2f &vertex : model.vertices)
+                    vertices.push_back(glf::vertex_v3fn3f(vertex.Position * scale, vertex.Normal));
+                indices = model.indices;
+                extent = glm::vec3(scale);
+            } else {
+                for (int face = 0; face < 6; ++face) {
+                    glm::vec3 normal = normals[face];
+                    glm::vec3 u = std::abs(normal.y) > 0.5f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+                    glm::vec3 v = glm::cross(normal, u);
+
+                    GLuint first = GLuint(vertices.size());
+                    for (int b = 0; b <= tessellation; ++b)
+                        for (int a = 0; a <= tessellation; ++a) {
+                            glm::vec3 p = normal + u * (2.0f * a / tessellation - 1.0f) + v * (2.0f * b / tessellation - 1.0f);
+                            glm::vec3 rounded = glm::normalize(p);
+                            glm::vec3 position = extent * glm::mix(p, rounded, roundness);
+                            glm::vec3 direction = glm::normalize(glm::mix(normal, rounded, roundness) / extent);
+                            vertices.push_back(glf::vertex_v3fn3f(position, direction));
+                        }
+                    // Counter clockwise seen from outside, u x v is the normal of the face
+                    for (int b = 0; b < tessellation; ++b)
+                        for (int a = 0; a < tessellation; ++a) {
+                            GLuint corner = first + GLuint(b * (tessellation + 1) + a);
+                            GLuint above = corner + GLuint(tessellation + 1);
+                            indices.insert(indices.end(), {corner, corner + 1, above + 1, corner, above + 1, above});
+                        }
+                }
+            }
+            meshes.push_back(arena.add(vertices, indices));
+
+            // The rounded positions stay within the extent of the box, the transforms of the objects place their boxes
+            meshBounds.push_back(BoundingBox(-extent, extent));
+            culler.add(meshBounds.back());
+        }
+
+        Qulkan::Logger::Info("%s: %d meshes, %d vertices, %d triangles in the arena\n", name(), int(arena.getMeshCount()), int(arena.getVertexCount()),
+                             int(arena.getIndexCount() / 3));
+    }
+
+    void MultiDraw::initHandles() {
+
+        Handle batched("Batched", Type::BOOL_HANDLE, true);
+        handleManager.addHandle(batched);
+
+        Handle animate("Animate", Type::BOOL_HANDLE, true);
+        handleManager.addHandle(animate);
+
+        // Off by default so that the headless timings keep measuring the draw of every object
+        Handle cpuCulling("CPU Culling", Type::BOOL_HANDLE, false);
+        handleManager.addHandle(cpuCulling);
+
+        Handle fov("FoV", Type::FLOAT_HANDLE, 45.0f, 10.0f, 120.0f);
+        handleManager.addHandle(fov);
+
+        Handle cameraSensitivity("Camera Sensitivity", Type::FLOAT_HANDLE, 0.1f, 0.001f, 1.0f);
+        handleManager.addHandle(cameraSensitivity);
+
+        resolveHandles();
+    }
+
+    void MultiDraw::resolveHandles() {
+        batched = handleManager.getRef<bool>("Batched");
+        animate = handleManager.getRef<bool>("Animate");
+        cpuCulling = handleManager.getRef<bool>("CPU Culling");
+        fov = handleManager.getRef<float>("FoV");
+        cameraSensitivity = handleManager.getRef<float>("Camera Sensitivity");
+    }
+
+    void MultiDraw::createPrograms() {
+        // Same attributes as the instancing stress test
+        shaderManager.addShader("VERT_MULTIDRAW", "../data/shaders/examples/performance/instancing.vert", GL_VERTEX_SHADER, compiler);
+        shaderManager.addShader("FRAG_MULTIDRAW", "../data/shaders/examples/performance/instancing.frag", GL_FRAGMENT_SHADER, compiler);
+
+        programManager.addProgram("MULTIDRAW_SHADER");
+        programManager.link("MULTIDRAW_SHADER", {"VERT_MULTIDRAW", "FRAG_MULTIDRAW"}, shaderManager, compiler);
+    }
+
+    bool MultiDraw::checkPrograms() { return programManager.check(shaderManager, compiler); }
+
+    void MultiDraw::resolveUniforms() {
+        programManager.reflect("MULTIDRAW_SHADER");
+        objectUniforms.view = programManager.uniform("MULTIDRAW_SHADER", "view");
+        objectUniforms.projection = programManager.uniform("MULTIDRAW_SHADER", "projection");
+        objectUniforms.viewPos = programManager.uniform("MULTIDRAW_SHADER", "viewPos");
+        objectUniforms.lightDirection = programManager.uniform("MULTIDRAW_SHADER", "lightDirection");
+        objectUniforms.materials = programManager.uniformLocation("MULTIDRAW_SHADER", "materials");
+
+        // Specular intensity in rgb and shininess in w
+        const glm::vec4 materials[MATERIAL_COUNT] = {glm::vec4(0.05f, 0.05f, 0.05f, 8.0f), glm::vec4(0.5f, 0.5f, 0.5f, 32.0f),
+                                                     glm::vec4(0.9f, 0.85f, 0.7f, 128.0f), glm::vec4(0.3f, 0.3f, 0.35f, 256.0f)};
+        if (objectUniforms.materials != -1) {
+            glUseProgram(programManager("MULTIDRAW_SHADER"));
+            glUniform4fv(objectUniforms.materials, MATERIAL_COUNT, glm::value_ptr(materials[0]));
+            glUseProgram(0);
+        }
+    }
+
+    void MultiDraw::initBuffer() {
+        createMeshes();
+        if (!instanceRenderer.create(objectCount) || !batch.create(objectCount))
+            error = true;
+    }
+
+    void MultiDraw::init() {
+        Qulkan::Logger::Info("%s: Initialisation\n", name());
+
+        if (handleManager.getHandles().empty())
+            initHandles();
+        initPrograms();
+        resolveUniforms();
+        initBuffer();
+        initOpenGLOptions();
+        if (!error) {
+            Qulkan::Logger::Info("%s: Initialisation Done\n", name());
+            initialized = true;
+        } else
+            Qulkan::Logger::Error("%s: An error Occured during initialisation\n", name());
+    }
+
+    void MultiDraw::initOpenGLOptions() { glEnable(GL_DEPTH_TEST); }
+
+    bool MultiDraw::reloadShaders(const std::set<std::string> &files) {
+        if (!programManager.reload(shaderManager, files).empty())
+            resolveUniforms();
+        return true;
+    }
+
+    bool MultiDraw::usesShaderFiles(const std::set<std::string> &files) { return shaderManager.dependsOn(files); }
+
+    void MultiDraw::clean() {
+        batch.destroy();
+        instanceRenderer.destroy();
+        arena.destroy();
+        meshes.clear();
+        meshBounds.clear();
+        culler.clear();
+        glDeleteProgram(programManager("MULTIDRAW_SHADER"));
+    }
+
+    /* One instance per object, in a lattice centered on the origin. The boxes of the culling follow the objects */
+    void MultiDraw::writeInstances(InstanceRenderer::Range const &range, float time) {
+        QULKAN_PROFILE_ZONE("MultiDraw::writeInstances");
+
+        const Lattice lattice(range.count, LATTICE_SPACING);
+        const glm::vec3 axis = glm::normalize(glm::vec3(0.2f, 1.0f, 0.4f));
+        InstanceRenderer::Instance *instances = range.data;
+        const bool updateBounds = *cpuCulling;
+
+#pragma omp parallel for schedule(static)
+        for (GLsizei i = 0; i < range.count; ++i) {
+            float phase = Lattice::phase(i);
+
+            glm::mat4 transform = glm::translate(glm::mat4(1.0f), lattice.position(i));
+            transform = glm::rotate(transform, phase * 6.2831853f + time * (0.25f + phase), axis);
+
+            instances[i] = InstanceRenderer::Instance(transform, Lattice::color(phase), std::uint32_t(i % MATERIAL_COUNT));
+            if (updateBounds)
+                culler.set(std::uint32_t(i), meshBounds[i].transformed(transform));
+        }
+    }
+
+    void MultiDraw::render(int actualRenderWidth, int actualRenderHeight) {
+        ASSERT(initialized, std::string(name()) + ": You need to init the view first");
+
+        glViewport(0, 0, actualRenderWidth, actualRenderHeight);
+
+        glClearColor(0.233f, 0.233f, 0.233f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Orbit around the objects
+        camera.update(isMouseDragging(0) ? mouseDelta : glm::vec2(0.0f), mouseWheel, *cameraSensitivity, Qulkan::getDeltaTime());
+
+        float extent = Lattice(objectCount, LATTICE_SPACING).extent();
+        float distance = camera.distance(extent);
+        glm::vec3 eye = camera.eye(extent);
+
+        glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection =
+            glm::perspective(glm::radians(*fov), (float)actualRenderWidth / actualRenderHeight, 0.1f, distance + extent * 2.0f);
+
+        instanceRenderer.beginFrame();
+        batch.beginFrame();
+
+        InstanceRenderer::Range range = instanceRenderer.allocate(GLsizei(meshes.size()));
+        writeInstances(range, *animate ? Qulkan::getTime() : 0.0f);
+
+        // Objects submitted this frame, all of them without culling
+        if (*cpuCulling)
+            culler.cull(Frustum::fromMatrix(projection * view), visibleObjects);
+        std::size_t drawnCount = *cpuCulling ? visibleObjects.size() : meshes.size();
+
+        glUseProgram(programManager("MULTIDRAW_SHADER"));
+        objectUniforms.view.set(view);
+        objectUniforms.projection.set(projection);
+        objectUniforms.viewPos.set(eye);
+        objectUniforms.lightDirection.set(glm::vec3(-0.3f, -1.0f, -0.5f));
+
+        glEnable(GL_CULL_FACE);
+        if (*batched) {
+            QULKAN_PROFILE_ZONE("MultiDraw::batched");
+            // The material of an object is also the one of its instance, the shader doesn't change between the materials here
+            for (std::size_t i = 0; i < drawnCount; ++i) {
+                std::size_t object = *cpuCulling ? visibleObjects[i] : i;
+                batch.add(unsigned(object % MATERIAL_COUNT), meshes[object], 1, GLuint(object));
+            }
+            for (unsigned material = 0; material < batch.getMaterialCount(); ++material)
+                batch.draw(material, arena.vao(), instanceRenderer, range);
+        } else {
+            QULKAN_PROFILE_ZONE("MultiDraw::perObject");
+            for (std::size_t i = 0; i < drawnCount; ++i) {
+                std::size_t object = *cpuCulling ? visibleObjects[i] : i;
+                if (!instanceRenderer.bindInstances(arena.vao(), range, GLuint(object)))
+                    continue;
+                ArenaMesh const &mesh = meshes[object];
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, GLsizei(mesh.indexCount), GL_UNSIGNED_INT,
+                                                  reinterpret_cast<void const *>(std::size_t(mesh.firstIndex) * sizeof(GLuint)), 1, mesh.baseVertex);
+            }
+        }
+        glDisable(GL_CULL_FACE);
+        glBindVertexArray(0);
+
+        batch.endFrame();
+        instanceRenderer.endFrame();
+    }
+
+} // namespace OpenGLExamples
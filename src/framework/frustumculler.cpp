@@ -0,0 +1,406 @@
+#include "framework/frustumculler.h"
+#include "qulkan/profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FRUSTUMCULLER_AVX 1
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FRUSTUMCULLER_SSE 1
+#endif
+
+namespace {
+    const unsigned ALL_PLANES = (1u << Frustum::PLANE_COUNT) - 1;
+    const unsigned BIN_COUNT = 16;
+
+#if defined(FRUSTUMCULLER_AVX)
+    const std::uint32_t LANE_COUNT = 8;
+#elif defined(FRUSTUMCULLER_SSE)
+    const std::uint32_t LANE_COUNT = 4;
+#else
+    const std::uint32_t LANE_COUNT = 1;
+#endif
+
+    /* Half of the surface area, the factor doesn't change the splits */
+    float halfArea(glm::vec3 const &extent) { return 4.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x); }
+
+    struct Bin {
+        glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+        std::size_t count = 0;
+
+        void grow(glm::vec3 const &boxMin, glm::vec3 const &boxMax) {
+            min = glm::min(min, boxMin);
+            max = glm::max(max, boxMax);
+        }
+        void grow(Bin const &bin) {
+            grow(bin.min, bin.max);
+            count += bin.count;
+        }
+        float area() const { return count == 0 ? 0.0f : halfArea(0.5f * (max - min)); }
+    };
+} // namespace
+
+/* The frustum planes as the box tests read them, a box is outside of a plane when dot(normal, center) + distance is lower than
+ * -dot(|normal|, extent) */
+struct FrustumCuller::Planes {
+    float normalX[Frustum::PLANE_COUNT], normalY[Frustum::PLANE_COUNT], normalZ[Frustum::PLANE_COUNT], distance[Frustum::PLANE_COUNT];
+    float absX[Frustum::PLANE_COUNT], absY[Frustum::PLANE_COUNT], absZ[Frustum::PLANE_COUNT];
+
+    explicit Planes(Frustum const &frustum) {
+        for (int i = 0; i < Frustum::PLANE_COUNT; ++i) {
+            glm::vec4 const &plane = frustum.planes[i];
+            normalX[i] = plane.x;
+            normalY[i] = plane.y;
+            normalZ[i] = plane.z;
+            distance[i] = plane.w;
+            absX[i] = std::abs(plane.x);
+            absY[i] = std::abs(plane.y);
+            absZ[i] = std::abs(plane.z);
+        }
+    }
+};
+
+FrustumCuller::FrustumCuller() : built(false) {}
+
+char const *FrustumCuller::instructionSet() {
+#if defined(FRUSTUMCULLER_AVX)
+    return "AVX";
+#elif defined(FRUSTUMCULLER_SSE)
+    return "SSE";
+#else
+    return "scalar";
+#endif
+}
+
+void FrustumCuller::clear() {
+    resizeSlots(0);
+    slotObjects.clear();
+    objectSlots.clear();
+    nodes.clear();
+    nodeMoved.clear();
+    built = false;
+}
+
+void FrustumCuller::resizeSlots(std::size_t count) {
+    std::size_t padded = count + LANE_COUNT;
+    for (std::vector<float> *array : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ})
+        array->resize(padded, 0.0f);
+    moved.resize(count, 0);
+}
+
+void FrustumCuller::setSlot(std::uint32_t slot, glm::vec3 const &center, glm::vec3 const &extent) {
+    centerX[slot] = center.x;
+    centerY[slot] = center.y;
+    centerZ[slot] = center.z;
+    extentX[slot] = extent.x;
+    extentY[slot] = extent.y;
+    extentZ[slot] = extent.z;
+}
+
+std::uint32_t FrustumCuller::add(BoundingBox const &box) {
+    std::uint32_t object = std::uint32_t(slotObjects.size());
+    resizeSlots(slotObjects.size() + 1);
+    slotObjects.push_back(object);
+    objectSlots.push_back(object);
+    setSlot(object, box.center(), box.extent());
+    built = false;
+    return object;
+}
+
+void FrustumCuller::set(std::uint32_t object, BoundingBox const &box) {
+    std::uint32_t slot = objectSlots[object];
+    setSlot(slot, box.center(), box.extent());
+    moved[slot] = 1;
+}
+
+void FrustumCuller::build() {
+    QULKAN_PROFILE_ZONE("FrustumCuller::build");
+
+    std::size_t count = slotObjects.size();
+    std::vector<BuildItem> items(count);
+    for (std::size_t slot = 0; slot < count; ++slot)
+        items[slot] = BuildItem{glm::vec3(centerX[slot], centerY[slot], centerZ[slot]), glm::vec3(extentX[slot], extentY[slot], extentZ[slot]),
+                                slotObjects[slot]};
+
+    nodes.clear();
+    nodes.reserve(2 * (count / LEAF_SIZE + 1));
+    if (count > 0)
+        buildNode(items, 0, count);
+    nodeMoved.assign(nodes.size(), 0);
+
+    // The boxes are stored in the order of the leaves
+    for (std::size_t slot = 0; slot < count; ++slot) {
+        setSlot(std::uint32_t(slot), items[slot].center, items[slot].extent);
+        slotObjects[slot] = items[slot].object;
+        objectSlots[items[slot].object] = std::uint32_t(slot);
+        moved[slot] = 0;
+    }
+    built = true;
+}
+
+std::uint32_t FrustumCuller::buildNode(std::vector<BuildItem> &items, std::size_t begin, std::size_t end) {
+    std::uint32_t index = std::uint32_t(nodes.size());
+    nodes.push_back(Node());
+
+    Bin bounds, centroids;
+    for (std::size_t i = begin; i < end; ++i) {
+        bounds.grow(items[i].center - items[i].extent, items[i].center + items[i].extent);
+        centroids.grow(items[i].center, items[i].center);
+    }
+
+    Node &node = nodes[index];
+    node.center = 0.5f * (bounds.min + bounds.max);
+    node.extent = 0.5f * (bounds.max - bounds.min);
+    node.rightChild = 0;
+    node.firstSlot = std::uint32_t(begin);
+    node.slotCount = std::uint32_t(end - begin);
+    if (end - begin <= LEAF_SIZE)
+        return index;
+
+    // Binned SAH, the centers are binned along each axis and the cheapest boundary between two bins is kept
+    int bestAxis = -1;
+    unsigned bestSplit = 0;
+    float bestCost = std::numeric_limits<float>::max();
+    for (int axis = 0; axis < 3; ++axis) {
+        float span = centroids.max[axis] - centroids.min[axis];
+        if (span <= 0.0f)
+            continue;
+        float scale = float(BIN_COUNT) / span;
+
+        Bin bins[BIN_COUNT];
+        for (std::size_t i = begin; i < end; ++i) {
+            unsigned bin = std::min(BIN_COUNT - 1, unsigned((items[i].center[axis] - centroids.min[axis]) * scale));
+            bins[bin].grow(items[i].center - items[i].extent, items[i].center + items[i].extent);
+            ++bins[bin].count;
+        }
+
+        float rightCost[BIN_COUNT];
+        Bin right;
+        for (unsigned split = BIN_COUNT - 1; split > 0; --split) {
+            right.grow(bins[split]);
+            rightCost[split] = right.area() * float(right.count);
+        }
+        Bin left;
+        for (unsigned split = 1; split < BIN_COUNT; ++split) {
+            left.grow(bins[split - 1]);
+            float cost = left.area() * float(left.count) + rightCost[split];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    std::size_t middle = begin;
+    if (bestAxis != -1) {
+        float minimum = centroids.min[bestAxis];
+        float scale = float(BIN_COUNT) / (centroids.max[bestAxis] - minimum);
+        middle = std::size_t(std::partition(items.begin() + begin, items.begin() + end,
+                                            [&](BuildItem const &item) {
+                                                return std::min(BIN_COUNT - 1, unsigned((item.center[bestAxis] - minimum) * scale)) < bestSplit;
+                                            }) -
+                             items.begin());
+    }
+    // Every center in the same place or in the same bin, split in the middle
+    if (middle == begin || middle == end)
+        middle = begin + (end - begin) / 2;
+
+    buildNode(items, begin, middle);
+    std::uint32_t rightChild = buildNode(items, middle, end);
+    nodes[index].rightChild = rightChild;
+    return index;
+}
+
+void FrustumCuller::fitLeaf(Node &node) const {
+    glm::vec3 minimum = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 maximum = glm::vec3(-std::numeric_limits<float>::max());
+    for (std::uint32_t slot = node.firstSlot; slot < node.firstSlot + node.slotCount; ++slot) {
+        glm::vec3 center = glm::vec3(centerX[slot], centerY[slot], centerZ[slot]);
+        glm::vec3 extent = glm::vec3(extentX[slot], extentY[slot], extentZ[slot]);
+        minimum = glm::min(minimum, center - extent);
+        maximum = glm::max(maximum, center + extent);
+    }
+    node.center = 0.5f * (minimum + maximum);
+    node.extent = 0.5f * (maximum - minimum);
+}
+
+void FrustumCuller::refit() {
+    if (!built) {
+        build();
+        return;
+    }
+
+    QULKAN_PROFILE_ZONE("FrustumCuller::refit");
+
+    // Children come after their parents, walking the nodes backwards refits the children first
+    for (std::size_t i = nodes.size(); i-- > 0;) {
+        Node &node = nodes[i];
+        bool changed = false;
+        if (node.rightChild == 0) {
+            for (std::uint32_t slot = node.firstSlot; slot < node.firstSlot + node.slotCount; ++slot) {
+                changed = changed || moved[slot] != 0;
+                moved[slot] = 0;
+            }
+            if (changed)
+                fitLeaf(node);
+        } else {
+            changed = nodeMoved[i + 1] != 0 || nodeMoved[node.rightChild] != 0;
+            if (changed) {
+                Node const &left = nodes[i + 1];
+                Node const &right = nodes[node.rightChild];
+                glm::vec3 minimum = glm::min(left.center - left.extent, right.center - right.extent);
+                glm::vec3 maximum = glm::max(left.center + left.extent, right.center + right.extent);
+                node.center = 0.5f * (minimum + maximum);
+                node.extent = 0.5f * (maximum - minimum);
+            }
+        }
+        nodeMoved[i] = changed ? 1 : 0;
+    }
+}
+
+bool FrustumCuller::testNode(Planes const &planes, Node const &node, unsigned &planeMask) {
+    for (int i = 0; i < Frustum::PLANE_COUNT; ++i) {
+        if ((planeMask & (1u << i)) == 0)
+            continue;
+        float distance = planes.normalX[i] * node.center.x + planes.normalY[i] * node.center.y + planes.normalZ[i] * node.center.z + planes.distance[i];
+        float radius = planes.absX[i] * node.extent.x + planes.absY[i] * node.extent.y + planes.absZ[i] * node.extent.z;
+        if (distance < -radius)
+            return false;
+        // Inside of this plane, and so is everything below the node
+        if (distance >= radius)
+            planeMask &= ~(1u << i);
+    }
+    return true;
+}
+
+void FrustumCuller::testLeaf(Planes const &planes, Node const &node, unsigned planeMask, std::vector<std::uint32_t> &visible) const {
+    // The lanes past the end of the leaf read the next boxes (or the padding), they are masked out
+    for (std::uint32_t first = node.firstSlot; first < node.firstSlot + node.slotCount; first += LANE_COUNT) {
+        std::uint32_t lanes = std::min(LANE_COUNT, node.firstSlot + node.slotCount - first);
+        unsigned outside = 0;
+
+#if defined(FRUSTUMCULLER_AVX)
+        __m256 cx = _mm256_loadu_ps(&centerX[first]), cy = _mm256_loadu_ps(&centerY[first]), cz = _mm256_loadu_ps(&centerZ[first]);
+        __m256 ex = _mm256_loadu_ps(&extentX[first]), ey = _mm256_loadu_ps(&extentY[first]), ez = _mm256_loadu_ps(&extentZ[first]);
+        __m256 out = _mm256_setzero_ps();
+        for (int i = 0; i < Frustum::PLANE_COUNT; ++i) {
+            if ((planeMask & (1u << i)) == 0)
+                continue;
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.normalX[i]), cx), _mm256_mul_ps(_mm256_set1_ps(planes.normalY[i]), cy)),
+                                            _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.normalZ[i]), cz), _mm256_set1_ps(planes.distance[i])));
+            __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.absX[i]), ex), _mm256_mul_ps(_mm256_set1_ps(planes.absY[i]), ey)),
+                                          _mm256_mul_ps(_mm256_set1_ps(planes.absZ[i]), ez));
+            out = _mm256_or_ps(out, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+        outside = unsigned(_mm256_movemask_ps(out));
+#elif defined(FRUSTUMCULLER_SSE)
+        __m128 cx = _mm_loadu_ps(&centerX[first]), cy = _mm_loadu_ps(&centerY[first]), cz = _mm_loadu_ps(&centerZ[first]);
+        __m128 ex = _mm_loadu_ps(&extentX[first]), ey = _mm_loadu_ps(&extentY[first]), ez = _mm_loadu_ps(&extentZ[first]);
+        __m128 out = _mm_setzero_ps();
+        for (int i = 0; i < Frustum::PLANE_COUNT; ++i) {
+            if ((planeMask & (1u << i)) == 0)
+                continue;
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.normalX[i]), cx), _mm_mul_ps(_mm_set1_ps(planes.normalY[i]), cy)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.normalZ[i]), cz), _mm_set1_ps(planes.distance[i])));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.absX[i]), ex), _mm_mul_ps(_mm_set1_ps(planes.absY[i]), ey)),
+                                       _mm_mul_ps(_mm_set1_ps(planes.absZ[i]), ez));
+            out = _mm_or_ps(out, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+        outside = unsigned(_mm_movemask_ps(out));
+#else
+        for (int i = 0; i < Frustum::PLANE_COUNT && outside == 0; ++i) {
+            if ((planeMask & (1u << i)) == 0)
+                continue;
+            float distance = planes.normalX[i] * centerX[first] + planes.normalY[i] * centerY[first] + planes.normalZ[i] * centerZ[first] + planes.distance[i];
+            float radius = planes.absX[i] * extentX[first] + planes.absY[i] * extentY[first] + planes.absZ[i] * extentZ[first];
+            outside = distance + radius < 0.0f ? 1u : 0u;
+        }
+#endif
+
+        for (std::uint32_t lane = 0; lane < lanes; ++lane)
+            if ((outside & (1u << lane)) == 0)
+                visible.push_back(slotObjects[first + lane]);
+    }
+}
+
+void FrustumCuller::traverse(Planes const &planes, Task root, std::vector<std::uint32_t> &visible) const {
+    std::vector<Task> stack;
+    stack.reserve(64);
+    stack.push_back(root);
+    while (!stack.empty()) {
+        Task task = stack.back();
+        stack.pop_back();
+
+        Node const &node = nodes[task.node];
+        if (!testNode(planes, node, task.planeMask))
+            continue;
+
+        // Inside of the frustum, every object below is visible without testing its box
+        if (task.planeMask == 0) {
+            visible.insert(visible.end(), slotObjects.begin() + node.firstSlot, slotObjects.begin() + node.firstSlot + node.slotCount);
+            continue;
+        }
+        if (node.rightChild == 0) {
+            testLeaf(planes, node, task.planeMask, visible);
+            continue;
+        }
+        stack.push_back(Task{node.rightChild, task.planeMask});
+        stack.push_back(Task{task.node + 1, task.planeMask});
+    }
+}
+
+std::size_t FrustumCuller::cull(Frustum const &frustum, std::vector<std::uint32_t> &visible) {
+    QULKAN_PROFILE_ZONE("FrustumCuller::cull");
+
+    visible.clear();
+    if (slotObjects.empty())
+        return 0;
+    refit();
+
+    Planes planes(frustum);
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    if (slotObjects.size() < PARALLEL_THRESHOLD || threads == 1) {
+        traverse(planes, Task{0, ALL_PLANES}, visible);
+        return visible.size();
+    }
+
+    // Splits the top of the tree into a few subtrees per thread, breadth first so that they are of similar sizes
+    tasks.assign(1, Task{0, ALL_PLANES});
+    for (bool split = true; split && tasks.size() < threads * 4;) {
+        split = false;
+        std::size_t count = tasks.size();
+        for (std::size_t i = 0; i < count; ++i) {
+            Task task = tasks[i];
+            Node const &node = nodes[task.node];
+            if (node.rightChild == 0)
+                continue;
+            if (!testNode(planes, node, task.planeMask)) {
+                tasks[i].node = std::uint32_t(nodes.size()); // Culled, skipped below
+                continue;
+            }
+            tasks[i] = Task{task.node + 1, task.planeMask};
+            tasks.push_back(Task{node.rightChild, task.planeMask});
+            split = true;
+        }
+        tasks.erase(std::remove_if(tasks.begin(), tasks.end(), [&](Task const &task) { return task.node == nodes.size(); }), tasks.end());
+    }
+
+    taskVisible.resize(std::max(taskVisible.size(), tasks.size()));
+    int taskCount = int(tasks.size());
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < taskCount; ++i) {
+        taskVisible[i].clear();
+        traverse(planes, tasks[i], taskVisible[i]);
+    }
+
+    for (int i = 0; i < taskCount; ++i)
+        visible.insert(visible.end(), taskVisible[i].begin(), taskVisible[i].end());
+    return visible.size();
+}
@@ -0,0 +1,1022 @@
+#include "framework/meshloader.h"
+#include "qulkan/logger.h"
+#include "qulkan/profiler.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MESHLOADER_MMAP
+#else
+#include <fstream>
+#endif
+
+namespace {
+
+    std::string &cacheDirectory() {
+        static std::string Directory("meshcache/");
+        return Directory;
+    }
+
+    // Read only view of a whole file, mapped when the platform allows it
+    class MappedFile {
+      public:
+        explicit MappedFile(std::string const &Filename) : Data(nullptr), Size(0) {
+#if defined(MESHLOADER_MMAP)
+            int Descriptor = open(Filename.c_str(), O_RDONLY);
+            if (Descriptor == -1)
+                return;
+            struct stat Stat;
+            if (fstat(Descriptor, &Stat) == 0 && Stat.st_size > 0) {
+                void *Mapping = mmap(nullptr, std::size_t(Stat.st_size), PROT_READ, MAP_PRIVATE, Descriptor, 0);
+                if (Mapping != MAP_FAILED) {
+                    // Every chunk is read at once by a different thread
+                    madvise(Mapping, std::size_t(Stat.st_size), MADV_WILLNEED);
+                    Data = static_cast<char const *>(Mapping);
+                    Size = std::size_t(Stat.st_size);
+                }
+            }
+            close(Descriptor);
+#else
+            std::ifstream Stream(Filename, std::ios::binary | std::ios::ate);
+            if (!Stream)
+                return;
+            Buffer.resize(std::size_t(Stream.tellg()));
+            Stream.seekg(0, std::ios::beg);
+            if (!Buffer.empty() && Stream.read(&Buffer[0], Buffer.size())) {
+                Data = Buffer.data();
+                Size = Buffer.size();
+            }
+#endif
+        }
+
+        ~MappedFile() {
+#if defined(MESHLOADER_MMAP)
+            if (Data != nullptr)
+                munmap(const_cast<char *>(Data), Size);
+#endif
+        }
+
+        MappedFile(MappedFile const &) = delete;
+        void operator=(MappedFile const &) = delete;
+
+        bool valid() const { return Data != nullptr; }
+
+        char const *Data;
+        std::size_t Size;
+
+      private:
+#if !defined(MESHLOADER_MMAP)
+        std::string Buffer;
+#endif
+    };
+
+    struct Chunk {
+        char const *Begin;
+        char const *End;
+    };
+
+    const std::size_t MIN_CHUNK_BYTES = 1 << 20;
+
+    // Cuts the text into chunks ending on line boundaries, a few per hardware thread to balance uneven lines
+    std::vector<Chunk> splitLines(char const *Data, std::size_t Size) {
+        std::size_t Threads = std::max(1u, std::thread::hardware_concurrency());
+        std::size_t Count = std::max<std::size_t>(1, std::min(Size / MIN_CHUNK_BYTES, Threads * 4));
+
+        std::vector<Chunk> Chunks;
+        char const *End = Data + Size;
+        char const *Begin = Data;
+        for (std::size_t i = 1; i <= Count && Begin < End; ++i) {
+            char const *Split = i == Count ? End : std::max(Begin, Data + Size / Count * i);
+            if (Split < End) {
+                char const *Newline = static_cast<char const *>(std::memchr(Split, '\n', std::size_t(End - Split)));
+                Split = Newline != nullptr ? Newline + 1 : End;
+            }
+            Chunks.push_back({Begin, Split});
+            Begin = Split;
+        }
+        return Chunks;
+    }
+
+    inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    inline void skipSpaces(char const *&Cursor, char const *End) {
+        while (Cursor < End && isSpace(*Cursor))
+            ++Cursor;
+    }
+
+    inline char const *lineEnd(char const *Cursor, char const *End) {
+        char const *Newline = static_cast<char const *>(std::memchr(Cursor, '\n', std::size_t(End - Cursor)));
+        return Newline != nullptr ? Newline : End;
+    }
+
+    inline bool parseInt(char const *&Cursor, char const *End, long long &Value) {
+        char const *Start = Cursor;
+        bool Negative = Cursor < End && *Cursor == '-';
+        if (Cursor < End && (*Cursor == '-' || *Cursor == '+'))
+            ++Cursor;
+        long long Result = 0;
+        char const *Digits = Cursor;
+        while (Cursor < End && unsigned(*Cursor - '0') < 10u)
+            Result = Result * 10 + (*Cursor++ - '0');
+        if (Cursor == Digits) {
+            Cursor = Start;
+            return false;
+        }
+        Value = Negative ? -Result : Result;
+        return true;
+    }
+
+    // Decimal numbers as written by exporters, strtod is several times slower and depends on the locale
+    inline bool parseNumber(char const *&Cursor, char const *End, double &Value) {
+        static const double Powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        char const *Start = Cursor;
+        bool Negative = Cursor < End && *Cursor == '-';
+        if (Cursor < End && (*Cursor == '-' || *Cursor == '+'))
+            ++Cursor;
+
+        unsigned long long Mantissa = 0;
+        int Exponent = 0;
+        int Digits = 0;
+        bool Any = false;
+        for (; Cursor < End && unsigned(*Cursor - '0') < 10u; ++Cursor, Any = true) {
+            if (Digits < 19) {
+                Mantissa = Mantissa * 10 + unsigned(*Cursor - '0');
+                Digits += Mantissa != 0;
+            } else
+                ++Exponent;
+        }
+        if (Cursor < End && *Cursor == '.') {
+            for (++Cursor; Cursor < End && unsigned(*Cursor - '0') < 10u; ++Cursor, Any = true) {
+                if (Digits < 19) {
+                    Mantissa = Mantissa * 10 + unsigned(*Cursor - '0');
+                    Digits += Mantissa != 0;
+                    --Exponent;
+                }
+            }
+        }
+        if (!Any) {
+            Cursor = Start;
+            return false;
+        }
+        if (Cursor < End && (*Cursor == 'e' || *Cursor == 'E')) {
+            char const *Mark = Cursor++;
+            long long Value10;
+            if (parseInt(Cursor, End, Value10))
+                Exponent += int(std::max(-400ll, std::min(400ll, Value10)));
+            else
+                Cursor = Mark;
+        }
+
+        double Result = double(Mantissa);
+        while (Exponent > 22) {
+            Result *= 1e22;
+            Exponent -= 22;
+        }
+        while (Exponent < -22) {
+            Result /= 1e22;
+            Exponent += 22;
+        }
+        Result = Exponent >= 0 ? Result * Powers[Exponent] : Result / Powers[-Exponent];
+        Value = Negative ? -Result : Result;
+        return true;
+    }
+
+    // FNV-1a
+    std::uint64_t hashString(std::string const &String) {
+        std::uint64_t Hash = 14695981039346656037ull;
+        for (char c : String) {
+            Hash ^= static_cast<unsigned char>(c);
+            Hash *= 1099511628211ull;
+        }
+        return Hash;
+    }
+
+    // ---- OBJ ----
+
+    // Indices of a face corner, 0 based, -1 when absent
+    struct ObjCorner {
+        std::int32_t Position;
+        std::int32_t Texcoord;
+        std::int32_t Normal;
+
+        bool operator==(ObjCorner const &Other) const { return Position == Other.Position && Texcoord == Other.Texcoord && Normal == Other.Normal; }
+    };
+
+    enum ObjRelative : std::uint8_t { RELATIVE_POSITION = 1, RELATIVE_TEXCOORD = 2, RELATIVE_NORMAL = 4 };
+
+    struct ObjChunk {
+        std::vector<glm::vec3> Positions;
+        std::vector<glm::vec2> Texcoords;
+        std::vector<glm::vec3> Normals;
+        std::vector<ObjCorner> Corners; // Three per triangle
+        // Negative indices count back from the last attribute read, which may be in an earlier chunk: until the attribute counts of
+        // the previous chunks are known they are kept relative to the first attribute of this chunk
+        std::vector<std::uint8_t> Relative;
+        bool Error = false;
+    };
+
+    // Resolves an index as written in a face, Count is the number of attributes of its kind read so far in the chunk
+    inline bool objIndex(long long Value, std::size_t Count, std::int32_t &Index, std::uint8_t &Relative, std::uint8_t Flag) {
+        if (Value > 0) {
+            Index = std::int32_t(Value - 1);
+            return true;
+        }
+        if (Value < 0) {
+            Index = std::int32_t(std::int64_t(Count) + Value);
+            Relative |= Flag;
+            return true;
+        }
+        return false;
+    }
+
+    void parseOBJChunk(Chunk const &Range, ObjChunk &Result) {
+        std::vector<ObjCorner> Face;
+        std::vector<std::uint8_t> FaceRelative;
+
+        for (char const *Cursor = Range.Begin; Cursor < Range.End;) {
+            char const *End = lineEnd(Cursor, Range.End);
+            skipSpaces(Cursor, End);
+
+            if (End - Cursor >= 2 && Cursor[0] == 'v' && isSpace(Cursor[1])) {
+                double x = 0.0, y = 0.0, z = 0.0;
+                Cursor += 2;
+                skipSpaces(Cursor, End);
+                parseNumber(Cursor, End, x);
+                skipSpaces(Cursor, End);
+                parseNumber(Cursor, End, y);
+                skipSpaces(Cursor, End);
+                parseNumber(Cursor, End, z);
+                Result.Positions.push_back(glm::vec3(float(x), float(y), float(z)));
+            } else if (End - Cursor >= 3 && Cursor[0] == 'v' && Cursor[1] == 't' && isSpace(Cursor[2])) {
+                double u = 0.0, v = 0.0;
+                Cursor += 3;
+                skipSpaces(Cursor, End);
+                parseNumber(Cursor, End, u);
+                skipSpaces(Cursor, End);
+                parseNumber(Cursor, End, v);
+                Result.Texcoords.push_back(glm::vec2(float(u), float(v)));
+            } else if (End - Cursor >= 3 && Cursor[0] == 'v' && Cursor[1] == 'n' && isSpace(Cursor[2])) {
+                double x = 0.0, y = 0.0, z = 0.0;
+                Cursor += 3;
+                skipSpaces(Cursor, End);
+                parseNumber(Cursor, End, x);
+                skipSpaces(Cursor, End);
+                parseNumber(Cursor, End, y);
+                skipSpaces(Cursor, End);
+                parseNumber(Cursor, End, z);
+                Result.Normals.push_back(glm::vec3(float(x), float(y), float(z)));
+            } else if (End - Cursor >= 2 && Cursor[0] == 'f' && isSpace(Cursor[1])) {
+                Cursor += 2;
+                Face.clear();
+                FaceRelative.clear();
+                for (skipSpaces(Cursor, End); Cursor < End; skipSpaces(Cursor, End)) {
+                    // v, v/t, v//n or v/t/n
+                    ObjCorner Corner = {-1, -1, -1};
+                    std::uint8_t Relative = 0;
+                    long long Value;
+                    bool Valid = parseInt(Cursor, End, Value) && objIndex(Value, Result.Positions.size(), Corner.Position, Relative, RELATIVE_POSITION);
+                    if (Valid && Cursor < End && *Cursor == '/') {
+                        ++Cursor;
+                        if (Cursor < End && *Cursor != '/')
+                            Valid = parseInt(Cursor, End, Value) && objIndex(Value, Result.Texcoords.size(), Corner.Texcoord, Relative, RELATIVE_TEXCOORD);
+                        if (Valid && Cursor < End && *Cursor == '/') {
+                            ++Cursor;
+                            Valid = parseInt(Cursor, End, Value) && objIndex(Value, Result.Normals.size(), Corner.Normal, Relative, RELATIVE_NORMAL);
+                        }
+                    }
+                    if (!Valid || (Cursor < End && !isSpace(*Cursor))) {
+                        Result.Error = true;
+                        return;
+                    }
+                    Face.push_back(Corner);
+                    FaceRelative.push_back(Relative);
+                }
+
+                // Polygons are triangulated as fans
+                for (std::size_t i = 2; i < Face.size(); ++i) {
+                    Result.Corners.insert(Result.Corners.end(), {Face[0], Face[i - 1], Face[i]});
+                    Result.Relative.insert(Result.Relative.end(), {FaceRelative[0], FaceRelative[i - 1], FaceRelative[i]});
+                }
+            }
+            // Groups, materials, smoothing groups and comments don't change the geometry
+
+            Cursor = End + 1;
+        }
+    }
+
+    // Open addressing table from a face corner to its vertex
+    class CornerTable {
+      public:
+        explicit CornerTable(std::size_t Expected) : Mask(0) { resize(std::max<std::size_t>(Expected * 2, 1024)); }
+
+        // Returns the vertex of the corner, Inserted tells if it's a new one
+        std::uint32_t insert(ObjCorner const &Corner, std::vector<ObjCorner> &Keys, bool &Inserted) {
+            if ((Keys.size() + 1) * 2 > Slots.size())
+                grow(Keys);
+            for (std::size_t Slot = hash(Corner) & Mask;; Slot = (Slot + 1) & Mask) {
+                std::uint32_t Index = Slots[Slot];
+                if (Index == EMPTY) {
+                    Slots[Slot] = std::uint32_t(Keys.size());
+                    Keys.push_back(Corner);
+                    Inserted = true;
+                    return Slots[Slot];
+                }
+                if (Keys[Index] == Corner) {
+                    Inserted = false;
+                    return Index;
+                }
+            }
+        }
+
+      private:
+        static constexpr std::uint32_t EMPTY = 0xFFFFFFFFu;
+
+        std::vector<std::uint32_t> Slots;
+        std::size_t Mask;
+
+        static std::size_t hash(ObjCorner const &Corner) {
+            std::uint64_t Hash = std::uint64_t(std::uint32_t(Corner.Position)) * 0x9E3779B97F4A7C15ull;
+            Hash ^= std::uint64_t(std::uint32_t(Corner.Texcoord)) * 0xC2B2AE3D27D4EB4Full;
+            Hash ^= std::uint64_t(std::uint32_t(Corner.Normal)) * 0x165667B19E3779F9ull;
+            return std::size_t(Hash ^ (Hash >> 29));
+        }
+
+        void resize(std::size_t Capacity) {
+            std::size_t Size = 1;
+            while (Size < Capacity)
+                Size <<= 1;
+            Slots.assign(Size, EMPTY);
+            Mask = Size - 1;
+        }
+
+        void grow(std::vector<ObjCorner> const &Keys) {
+            resize(Slots.size() * 2);
+            for (std::uint32_t Index = 0; Index < Keys.size(); ++Index) {
+                std::size_t Slot = hash(Keys[Index]) & Mask;
+                while (Slots[Slot] != EMPTY)
+                    Slot = (Slot + 1) & Mask;
+                Slots[Slot] = Index;
+            }
+        }
+    };
+
+    // ---- PLY ----
+
+    enum PlyType { PLY_INVALID, PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64 };
+
+    PlyType plyType(std::string const &Name) {
+        if (Name == "char" || Name == "int8")
+            return PLY_INT8;
+        if (Name == "uchar" || Name == "uint8")
+            return PLY_UINT8;
+        if (Name == "short" || Name == "int16")
+            return PLY_INT16;
+        if (Name == "ushort" || Name == "uint16")
+            return PLY_UINT16;
+        if (Name == "int" || Name == "int32")
+            return PLY_INT32;
+        if (Name == "uint" || Name == "uint32")
+            return PLY_UINT32;
+        if (Name == "float" || Name == "float32")
+            return PLY_FLOAT32;
+        if (Name == "double" || Name == "float64")
+            return PLY_FLOAT64;
+        return PLY_INVALID;
+    }
+
+    std::size_t plyTypeSize(PlyType Type) {
+        static const std::size_t Sizes[] = {0, 1, 1, 2, 2, 4, 4, 4, 8};
+        return Sizes[Type];
+    }
+
+    template <typename T> T readScalar(char const *Data, bool Swap) {
+        unsigned char Bytes[sizeof(T)];
+        std::memcpy(Bytes, Data, sizeof(T));
+        if (Swap)
+            std::reverse(Bytes, Bytes + sizeof(T));
+        T Value;
+        std::memcpy(&Value, Bytes, sizeof(T));
+        return Value;
+    }
+
+    double readBinary(char const *Data, PlyType Type, bool Swap) {
+        switch (Type) {
+        case PLY_INT8:
+            return double(readScalar<std::int8_t>(Data, Swap));
+        case PLY_UINT8:
+            return double(readScalar<std::uint8_t>(Data, Swap));
+        case PLY_INT16:
+            return double(readScalar<std::int16_t>(Data, Swap));
+        case PLY_UINT16:
+            return double(readScalar<std::uint16_t>(Data, Swap));
+        case PLY_INT32:
+            return double(readScalar<std::int32_t>(Data, Swap));
+        case PLY_UINT32:
+            return double(readScalar<std::uint32_t>(Data, Swap));
+        case PLY_FLOAT32:
+            return double(readScalar<float>(Data, Swap));
+        case PLY_FLOAT64:
+            return readScalar<double>(Data, Swap);
+        default:
+            return 0.0;
+        }
+    }
+
+    // Vertex properties stored in the mesh
+    enum PlySlot { SLOT_NONE = -1, SLOT_X, SLOT_Y, SLOT_Z, SLOT_NX, SLOT_NY, SLOT_NZ, SLOT_U, SLOT_V };
+
+    PlySlot plySlot(std::string const &Name) {
+        static const char *Names[][4] = {{"x"}, {"y"}, {"z"}, {"nx"}, {"ny"}, {"nz"}, {"u", "s", "texture_u", "texture_s"}, {"v", "t", "texture_v", "texture_t"}};
+        for (int Slot = 0; Slot < 8; ++Slot)
+            for (char const *Candidate : Names[Slot])
+                if (Candidate != nullptr && Name == Candidate)
+                    return PlySlot(Slot);
+        return SLOT_NONE;
+    }
+
+    struct PlyProperty {
+        std::string Name;
+        PlyType Type = PLY_INVALID;
+        bool List = false;
+        PlyType CountType = PLY_INVALID;
+        PlySlot Slot = SLOT_NONE;
+    };
+
+    struct PlyElement {
+        std::string Name;
+        std::size_t Count = 0;
+        std::vector<PlyProperty> Properties;
+
+        // Size of a binary record, 0 when it holds lists
+        std::size_t stride() const {
+            std::size_t Size = 0;
+            for (PlyProperty const &Property : Properties) {
+                if (Property.List)
+                    return 0;
+                Size += plyTypeSize(Property.Type);
+            }
+            return Size;
+        }
+
+        bool isFaceIndices(PlyProperty const &Property) const {
+            return Name == "face" && Property.List && (Property.Name == "vertex_indices" || Property.Name == "vertex_index");
+        }
+    };
+
+    void storeSlot(glf::vertex_v3fn3fv2f &Vertex, PlySlot Slot, double Value) {
+        switch (Slot) {
+        case SLOT_X:
+        case SLOT_Y:
+        case SLOT_Z:
+            Vertex.Position[Slot - SLOT_X] = float(Value);
+            break;
+        case SLOT_NX:
+        case SLOT_NY:
+        case SLOT_NZ:
+            Vertex.Normal[Slot - SLOT_NX] = float(Value);
+            break;
+        case SLOT_U:
+        case SLOT_V:
+            Vertex.Texcoord[Slot - SLOT_U] = float(Value);
+            break;
+        default:
+            break;
+        }
+    }
+
+    inline void addFan(std::vector<GLuint> &Indices, GLuint const *Face, std::size_t Count) {
+        for (std::size_t i = 2; i < Count; ++i)
+            Indices.insert(Indices.end(), {Face[0], Face[i - 1], Face[i]});
+    }
+
+    const std::uint32_t CACHE_MAGIC = 0x48534d51; // "QMSH"
+    const std::uint32_t CACHE_VERSION = 1;
+
+    struct CacheHeader {
+        std::uint32_t Magic;
+        std::uint32_t Version;
+        std::uint64_t SourceSize;
+        std::int64_t SourceTime;
+        std::uint32_t Flags;
+        std::uint32_t VertexSize;
+        std::uint64_t VertexCount;
+        std::uint64_t IndexCount;
+    };
+
+    // Unique per process and call, instances writing the same cache entry never share a temporary file
+    std::string temporarySuffix() {
+        unsigned long long Process = 0;
+#if defined(MESHLOADER_MMAP)
+        Process = static_cast<unsigned long long>(getpid());
+#endif
+        char Suffix[64];
+        std::snprintf(Suffix, sizeof(Suffix), ".%llx.%llx.tmp", Process,
+                      static_cast<unsigned long long>(std::chrono::steady_clock::now().time_since_epoch().count()));
+        return Suffix;
+    }
+
+    const std::uint32_t CACHE_NORMALS = 1u;
+    const std::uint32_t CACHE_TEXCOORDS = 2u;
+
+} // namespace
+
+void Mesh::computeNormals() {
+    for (glf::vertex_v3fn3fv2f &Vertex : vertices)
+        Vertex.Normal = glm::vec3(0.0f);
+
+    // Unnormalized cross products weight each face by its area
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+        glf::vertex_v3fn3fv2f &a = vertices[indices[i]];
+        glf::vertex_v3fn3fv2f &b = vertices[indices[i + 1]];
+        glf::vertex_v3fn3fv2f &c = vertices[indices[i + 2]];
+        glm::vec3 Normal = glm::cross(b.Position - a.Position, c.Position - a.Position);
+        a.Normal += Normal;
+        b.Normal += Normal;
+        c.Normal += Normal;
+    }
+
+#pragma omp parallel for schedule(static)
+    for (std::int64_t i = 0; i < std::int64_t(vertices.size()); ++i) {
+        float Length = glm::length(vertices[i].Normal);
+        vertices[i].Normal = Length > 0.0f ? vertices[i].Normal / Length : glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+    hasNormals = true;
+}
+
+void MeshLoader::setCacheDirectory(std::string const &Directory) {
+    cacheDirectory() = Directory;
+    if (!Directory.empty() && Directory.back() != '/')
+        cacheDirectory() += '/';
+}
+
+std::string const &MeshLoader::getCacheDirectory() { return cacheDirectory(); }
+
+bool MeshLoader::load(std::string const &Filename, Mesh &Result) {
+    QULKAN_PROFILE_ZONE("MeshLoader::load");
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    Result = Mesh();
+
+    std::error_code Error;
+    std::uint64_t SourceSize = std::filesystem::file_size(Filename, Error);
+    std::int64_t SourceTime = Error ? 0 : std::int64_t(std::filesystem::last_write_time(Filename, Error).time_since_epoch().count());
+    if (Error) {
+        Qulkan::Logger::Error("MeshLoader: Could not open %s\n", Filename.c_str());
+        return false;
+    }
+
+    std::string CacheFilename = cacheFilename(Filename);
+    if (!CacheFilename.empty() && loadCache(CacheFilename, SourceSize, SourceTime, Result)) {
+        Qulkan::Logger::Info("MeshLoader: %s from the cache, %zu vertices, %zu triangles\n", Filename.c_str(), Result.vertices.size(), Result.triangleCount());
+        return true;
+    }
+
+    std::string Extension = std::filesystem::path(Filename).extension().string();
+    std::transform(Extension.begin(), Extension.end(), Extension.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+    if (Extension != ".obj" && Extension != ".ply") {
+        Qulkan::Logger::Error("MeshLoader: Unsupported mesh format %s\n", Filename.c_str());
+        return false;
+    }
+
+    MappedFile File(Filename);
+    if (!File.valid()) {
+        Qulkan::Logger::Error("MeshLoader: Could not read %s\n", Filename.c_str());
+        return false;
+    }
+
+    bool Success = Extension == ".obj" ? loadOBJ(Filename, File.Data, File.Size, Result) : loadPLY(Filename, File.Data, File.Size, Result);
+    if (!Success) {
+        Result = Mesh();
+        return false;
+    }
+    if (!Result.hasNormals)
+        Result.computeNormals();
+
+    double Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+    Qulkan::Logger::Info("MeshLoader: %s, %zu vertices, %zu triangles in %.1f ms\n", Filename.c_str(), Result.vertices.size(), Result.triangleCount(),
+                         Milliseconds);
+
+    if (!CacheFilename.empty()) {
+        std::filesystem::create_directories(cacheDirectory(), Error);
+        if (!saveCache(CacheFilename, SourceSize, SourceTime, Result))
+            Qulkan::Logger::Warning("MeshLoader: Could not write the mesh cache %s\n", CacheFilename.c_str());
+    }
+    return true;
+}
+
+bool MeshLoader::loadOBJ(std::string const &Filename, char const *Data, std::size_t Size, Mesh &Result) {
+    std::vector<Chunk> Chunks = splitLines(Data, Size);
+    std::vector<ObjChunk> Parsed(Chunks.size());
+
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < int(Chunks.size()); ++i)
+        parseOBJChunk(Chunks[i], Parsed[i]);
+
+    // Attribute offsets of each chunk, to make its relative indices absolute
+    std::vector<std::size_t> PositionOffsets(Parsed.size()), TexcoordOffsets(Parsed.size()), NormalOffsets(Parsed.size());
+    std::size_t PositionCount = 0, TexcoordCount = 0, NormalCount = 0, CornerCount = 0;
+    for (std::size_t i = 0; i < Parsed.size(); ++i) {
+        if (Parsed[i].Error) {
+            Qulkan::Logger::Error("MeshLoader: %s: Malformed face\n", Filename.c_str());
+            return false;
+        }
+        PositionOffsets[i] = PositionCount;
+        TexcoordOffsets[i] = TexcoordCount;
+        NormalOffsets[i] = NormalCount;
+        PositionCount += Parsed[i].Positions.size();
+        TexcoordCount += Parsed[i].Texcoords.size();
+        NormalCount += Parsed[i].Normals.size();
+        CornerCount += Parsed[i].Corners.size();
+    }
+    if (PositionCount >= std::size_t(INT32_MAX) || CornerCount >= std::size_t(UINT32_MAX)) {
+        Qulkan::Logger::Error("MeshLoader: %s is too large\n", Filename.c_str());
+        return false;
+    }
+
+    std::vector<glm::vec3> Positions, Normals;
+    std::vector<glm::vec2> Texcoords;
+    Positions.reserve(PositionCount);
+    Texcoords.reserve(TexcoordCount);
+    Normals.reserve(NormalCount);
+    for (ObjChunk &Part : Parsed) {
+        Positions.insert(Positions.end(), Part.Positions.begin(), Part.Positions.end());
+        Texcoords.insert(Texcoords.end(), Part.Texcoords.begin(), Part.Texcoords.end());
+        Normals.insert(Normals.end(), Part.Normals.begin(), Part.Normals.end());
+        std::vector<glm::vec3>().swap(Part.Positions);
+        std::vector<glm::vec2>().swap(Part.Texcoords);
+        std::vector<glm::vec3>().swap(Part.Normals);
+    }
+
+    bool OutOfRange = false;
+#pragma omp parallel for schedule(dynamic) reduction(|| : OutOfRange)
+    for (int i = 0; i < int(Parsed.size()); ++i) {
+        ObjChunk &Part = Parsed[i];
+        for (std::size_t c = 0; c < Part.Corners.size(); ++c) {
+            ObjCorner &Corner = Part.Corners[c];
+            std::uint8_t Relative = Part.Relative[c];
+            if (Relative & RELATIVE_POSITION)
+                Corner.Position += std::int32_t(PositionOffsets[i]);
+            if (Relative & RELATIVE_TEXCOORD)
+                Corner.Texcoord += std::int32_t(TexcoordOffsets[i]);
+            if (Relative & RELATIVE_NORMAL)
+                Corner.Normal += std::int32_t(NormalOffsets[i]);
+            OutOfRange = OutOfRange || Corner.Position < 0 || std::size_t(Corner.Position) >= PositionCount || Corner.Texcoord < -1 ||
+                         (Corner.Texcoord >= 0 && std::size_t(Corner.Texcoord) >= TexcoordCount) || Corner.Normal < -1 ||
+                         (Corner.Normal >= 0 && std::size_t(Corner.Normal) >= NormalCount);
+        }
+        std::vector<std::uint8_t>().swap(Part.Relative);
+    }
+    if (OutOfRange) {
+        Qulkan::Logger::Error("MeshLoader: %s: Face index out of range\n", Filename.c_str());
+        return false;
+    }
+
+    // Corners sharing position, texture coordinates and normal become a single vertex
+    std::vector<ObjCorner> Keys;
+    Keys.reserve(PositionCount);
+    CornerTable Table(PositionCount);
+    Result.indices.reserve(CornerCount);
+    Result.vertices.reserve(PositionCount);
+    Result.hasNormals = CornerCount > 0;
+    Result.hasTexcoords = false;
+    for (ObjChunk &Part : Parsed) {
+        for (ObjCorner const &Corner : Part.Corners) {
+            bool Inserted;
+            std::uint32_t Index = Table.insert(Corner, Keys, Inserted);
+            if (Inserted) {
+                glm::vec3 Normal = Corner.Normal >= 0 ? Normals[Corner.Normal] : glm::vec3(0.0f);
+                glm::vec2 Texcoord = Corner.Texcoord >= 0 ? Texcoords[Corner.Texcoord] : glm::vec2(0.0f);
+                Result.vertices.push_back(glf::vertex_v3fn3fv2f(Positions[Corner.Position], Normal, Texcoord));
+                Result.hasNormals = Result.hasNormals && Corner.Normal >= 0;
+                Result.hasTexcoords = Result.hasTexcoords || Corner.Texcoord >= 0;
+            }
+            Result.indices.push_back(Index);
+        }
+        std::vector<ObjCorner>().swap(Part.Corners);
+    }
+    return true;
+}
+
+bool MeshLoader::loadPLY(std::string const &Filename, char const *Data, std::size_t Size, Mesh &Result) {
+    char const *End = Data + Size;
+
+    // Header
+    char const *HeaderEnd = nullptr;
+    for (char const *Cursor = Data; Cursor < End;) {
+        char const *LineEnd = lineEnd(Cursor, End);
+        if (LineEnd - Cursor >= 10 && std::strncmp(Cursor, "end_header", 10) == 0) {
+            HeaderEnd = LineEnd < End ? LineEnd + 1 : End;
+            break;
+        }
+        Cursor = LineEnd + 1;
+    }
+    if (Size < 4 || std::strncmp(Data, "ply", 3) != 0 || HeaderEnd == nullptr) {
+        Qulkan::Logger::Error("MeshLoader: %s is not a PLY file\n", Filename.c_str());
+        return false;
+    }
+
+    std::string Format;
+    std::vector<PlyElement> Elements;
+    std::istringstream Header(std::string(Data, HeaderEnd));
+    std::string Line;
+    while (std::getline(Header, Line)) {
+        std::istringstream Words(Line);
+        std::string Keyword;
+        Words >> Keyword;
+        if (Keyword == "format") {
+            Words >> Format;
+        } else if (Keyword == "element") {
+            PlyElement Element;
+            Words >> Element.Name >> Element.Count;
+            Elements.push_back(Element);
+        } else if (Keyword == "property" && !Elements.empty()) {
+            PlyProperty Property;
+            std::string Type;
+            Words >> Type;
+            if (Type == "list") {
+                std::string CountType, ItemType;
+                Words >> CountType >> ItemType;
+                Property.List = true;
+                Property.CountType = plyType(CountType);
+                Property.Type = plyType(ItemType);
+            } else
+                Property.Type = plyType(Type);
+            Words >> Property.Name;
+            if (Elements.back().Name == "vertex" && !Property.List)
+                Property.Slot = plySlot(Property.Name);
+            if (Property.Type == PLY_INVALID || (Property.List && Property.CountType == PLY_INVALID)) {
+                Qulkan::Logger::Error("MeshLoader: %s: Unknown property type in \"%s\"\n", Filename.c_str(), Line.c_str());
+                return false;
+            }
+            Elements.back().Properties.push_back(Property);
+        }
+    }
+
+    bool Ascii = Format == "ascii";
+    bool Swap = Format == "binary_big_endian";
+    if (!Ascii && !Swap && Format != "binary_little_endian") {
+        Qulkan::Logger::Error("MeshLoader: %s: Unknown PLY format \"%s\"\n", Filename.c_str(), Format.c_str());
+        return false;
+    }
+
+    std::size_t VertexCount = 0;
+    for (PlyElement const &Element : Elements) {
+        if (Element.Name != "vertex")
+            continue;
+        VertexCount = Element.Count;
+        for (PlyProperty const &Property : Element.Properties) {
+            Result.hasNormals = Result.hasNormals || Property.Slot == SLOT_NX;
+            Result.hasTexcoords = Result.hasTexcoords || Property.Slot == SLOT_U;
+        }
+    }
+    if (VertexCount >= std::size_t(UINT32_MAX)) {
+        Qulkan::Logger::Error("MeshLoader: %s is too large\n", Filename.c_str());
+        return false;
+    }
+    Result.vertices.assign(VertexCount, glf::vertex_v3fn3fv2f(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f)));
+
+    bool Truncated = false;
+    if (Ascii) {
+        // Lines are numbered first so each chunk knows which element its lines belong to
+        std::vector<Chunk> Chunks = splitLines(HeaderEnd, std::size_t(End - HeaderEnd));
+        std::vector<std::size_t> FirstLines(Chunks.size() + 1, 0);
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < int(Chunks.size()); ++i)
+            FirstLines[i + 1] = std::size_t(std::count(Chunks[i].Begin, Chunks[i].End, '\n'));
+        for (std::size_t i = 0; i < Chunks.size(); ++i)
+            FirstLines[i + 1] += FirstLines[i];
+
+        std::vector<std::size_t> ElementLines(Elements.size() + 1, 0);
+        for (std::size_t e = 0; e < Elements.size(); ++e)
+            ElementLines[e + 1] = ElementLines[e] + Elements[e].Count;
+
+        std::vector<std::vector<GLuint>> Triangles(Chunks.size());
+#pragma omp parallel for schedule(dynamic) reduction(|| : Truncated)
+        for (int i = 0; i < int(Chunks.size()); ++i) {
+            std::vector<GLuint> Face;
+            std::size_t LineNumber = FirstLines[i];
+            std::size_t e = 0;
+            for (char const *Cursor = Chunks[i].Begin; Cursor < Chunks[i].End; ++LineNumber) {
+                char const *LineEnd = lineEnd(Cursor, Chunks[i].End);
+                while (e < Elements.size() && LineNumber >= ElementLines[e + 1])
+                    ++e;
+                if (e == Elements.size())
+                    break;
+
+                PlyElement const &Element = Elements[e];
+                std::size_t Record = LineNumber - ElementLines[e];
+                for (PlyProperty const &Property : Element.Properties) {
+                    double Value = 0.0;
+                    skipSpaces(Cursor, LineEnd);
+                    if (!parseNumber(Cursor, LineEnd, Value)) {
+                        Truncated = true;
+                        break;
+                    }
+                    if (!Property.List) {
+                        if (Element.Name == "vertex")
+                            storeSlot(Result.vertices[Record], Property.Slot, Value);
+                        continue;
+                    }
+                    std::size_t Count = std::size_t(std::max(Value, 0.0));
+                    bool Indices = Element.isFaceIndices(Property);
+                    Face.clear();
+                    for (std::size_t Item = 0; Item < Count; ++Item) {
+                        skipSpaces(Cursor, LineEnd);
+                        if (!parseNumber(Cursor, LineEnd, Value)) {
+                            Truncated = true;
+                            break;
+                        }
+                        if (Indices)
+                            Face.push_back(Value >= 0.0 ? GLuint(Value) : GLuint(UINT32_MAX));
+                    }
+                    if (Indices)
+                        addFan(Triangles[i], Face.data(), Face.size());
+                }
+                Cursor = LineEnd + 1;
+            }
+        }
+        if (FirstLines.back() + (End > HeaderEnd && End[-1] != '\n' ? 1 : 0) < ElementLines.back())
+            Truncated = true;
+
+        std::size_t IndexCount = 0;
+        for (std::vector<GLuint> const &Part : Triangles)
+            IndexCount += Part.size();
+        Result.indices.reserve(IndexCount);
+        for (std::vector<GLuint> &Part : Triangles) {
+            Result.indices.insert(Result.indices.end(), Part.begin(), Part.end());
+            std::vector<GLuint>().swap(Part);
+        }
+    } else {
+        std::vector<GLuint> Face;
+        char const *Cursor = HeaderEnd;
+        for (PlyElement const &Element : Elements) {
+            std::size_t Stride = Element.stride();
+            if (Stride != 0) {
+                // Fixed size records, vertices are decoded in parallel straight from the mapping
+                if (std::size_t(End - Cursor) / Stride < Element.Count) {
+                    Truncated = true;
+                    break;
+                }
+                if (Element.Name == "vertex") {
+#pragma omp parallel for schedule(static)
+                    for (std::int64_t Record = 0; Record < std::int64_t(Element.Count); ++Record) {
+                        char const *Field = Cursor + std::size_t(Record) * Stride;
+                        for (PlyProperty const &Property : Element.Properties) {
+                            if (Property.Slot != SLOT_NONE)
+                                storeSlot(Result.vertices[Record], Property.Slot, readBinary(Field, Property.Type, Swap));
+                            Field += plyTypeSize(Property.Type);
+                        }
+                    }
+                }
+                Cursor += Element.Count * Stride;
+                continue;
+            }
+
+            // Records with lists have to be walked one after the other
+            bool Faces = Element.Name == "face";
+            if (Faces)
+                Result.indices.reserve(Element.Count * 3);
+            for (std::size_t Record = 0; Record < Element.Count && !Truncated; ++Record) {
+                for (PlyProperty const &Property : Element.Properties) {
+                    if (!Property.List) {
+                        if (Element.Name == "vertex" && Cursor + plyTypeSize(Property.Type) <= End)
+                            storeSlot(Result.vertices[Record], Property.Slot, readBinary(Cursor, Property.Type, Swap));
+                        Cursor += plyTypeSize(Property.Type);
+                        continue;
+                    }
+                    if (Cursor + plyTypeSize(Property.CountType) > End) {
+                        Truncated = true;
+                        break;
+                    }
+                    double Value = readBinary(Cursor, Property.CountType, Swap);
+                    std::size_t Count = std::size_t(std::max(Value, 0.0));
+                    Cursor += plyTypeSize(Property.CountType);
+                    std::size_t ItemSize = plyTypeSize(Property.Type);
+                    if (std::size_t(End - Cursor) / ItemSize < Count) {
+                        Truncated = true;
+                        break;
+                    }
+                    if (Faces && Element.isFaceIndices(Property)) {
+                        Face.clear();
+                        for (std::size_t Item = 0; Item < Count; ++Item) {
+                            double Index = readBinary(Cursor + Item * ItemSize, Property.Type, Swap);
+                            Face.push_back(Index >= 0.0 ? GLuint(Index) : GLuint(UINT32_MAX));
+                        }
+                        addFan(Result.indices, Face.data(), Face.size());
+                    }
+                    Cursor += Count * ItemSize;
+                }
+                if (Cursor > End)
+                    Truncated = true;
+            }
+            if (Truncated)
+                break;
+        }
+    }
+
+    if (Truncated) {
+        Qulkan::Logger::Error("MeshLoader: %s is truncated or malformed\n", Filename.c_str());
+        return false;
+    }
+
+    bool OutOfRange = false;
+#pragma omp parallel for schedule(static) reduction(|| : OutOfRange)
+    for (std::int64_t i = 0; i < std::int64_t(Result.indices.size()); ++i)
+        OutOfRange = OutOfRange || Result.indices[i] >= VertexCount;
+    if (OutOfRange) {
+        Qulkan::Logger::Error("MeshLoader: %s: Face index out of range\n", Filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string MeshLoader::cacheFilename(std::string const &Filename) {
+    if (cacheDirectory().empty())
+        return std::string();
+    std::error_code Error;
+    std::filesystem::path Path = std::filesystem::absolute(Filename, Error).lexically_normal();
+    char Name[32];
+    std::snprintf(Name, sizeof(Name), "%016llx.mesh", static_cast<unsigned long long>(hashString(Path.generic_string())));
+    return cacheDirectory() + Name;
+}
+
+bool MeshLoader::loadCache(std::string const &CacheFilename, std::uint64_t SourceSize, std::int64_t SourceTime, Mesh &Result) {
+    FILE *File = fopen(CacheFilename.c_str(), "rb");
+    if (!File)
+        return false;
+
+    // No parsing, the arrays are read in place
+    CacheHeader Header;
+    bool Success = fread(&Header, sizeof(Header), 1, File) == 1 && Header.Magic == CACHE_MAGIC && Header.Version == CACHE_VERSION &&
+                   Header.SourceSize == SourceSize && Header.SourceTime == SourceTime && Header.VertexSize == sizeof(glf::vertex_v3fn3fv2f) &&
+                   Header.VertexCount < UINT32_MAX && Header.IndexCount % 3 == 0;
+    if (Success) {
+        // The arrays are only allocated once the file is known to hold exactly them
+        long Start = ftell(File);
+        Success = Start >= 0 && fseek(File, 0, SEEK_END) == 0;
+        std::uint64_t Remaining = Success ? std::uint64_t(ftell(File) - Start) : 0;
+        Success = Success && fseek(File, Start, SEEK_SET) == 0 && Header.VertexCount <= Remaining / sizeof(glf::vertex_v3fn3fv2f) &&
+                  Header.IndexCount <= Remaining / sizeof(GLuint) &&
+                  Remaining - Header.VertexCount * sizeof(glf::vertex_v3fn3fv2f) == Header.IndexCount * sizeof(GLuint);
+    }
+    if (Success) {
+        Result.vertices.resize(Header.VertexCount);
+        Result.indices.resize(Header.IndexCount);
+        Success = (Header.VertexCount == 0 || fread(Result.vertices.data(), sizeof(glf::vertex_v3fn3fv2f), Header.VertexCount, File) == Header.VertexCount) &&
+                  (Header.IndexCount == 0 || fread(Result.indices.data(), sizeof(GLuint), Header.IndexCount, File) == Header.IndexCount);
+        Result.hasNormals = (Header.Flags & CACHE_NORMALS) != 0;
+        Result.hasTexcoords = (Header.Flags & CACHE_TEXCOORDS) != 0;
+    }
+    fclose(File);
+    for (std::size_t i = 0; Success && i < Result.indices.size(); ++i)
+        Success = Result.indices[i] < Result.vertices.size();
+
+    if (!Success)
+        Result = Mesh();
+    return Success;
+}
+
+bool MeshLoader::saveCache(std::string const &CacheFilename, std::uint64_t SourceSize, std::int64_t SourceTime, Mesh const &Result) {
+    CacheHeader Header;
+    std::memset(&Header, 0, sizeof(Header));
+    Header.Magic = CACHE_MAGIC;
+    Header.Version = CACHE_VERSION;
+    Header.SourceSize = SourceSize;
+    Header.SourceTime = SourceTime;
+    Header.Flags = (Result.hasNormals ? CACHE_NORMALS : 0u) | (Result.hasTexcoords ? CACHE_TEXCOORDS : 0u);
+    Header.VertexSize = sizeof(glf::vertex_v3fn3fv2f);
+    Header.VertexCount = Result.vertices.size();
+    Header.IndexCount = Result.indices.size();
+
+    // Written next to the cache and renamed, another instance never reads a partial file
+    std::string Temporary = CacheFilename + temporarySuffix();
+    FILE *File = fopen(Temporary.c_str(), "wb");
+    if (!File)
+        return false;
+    bool Success = fwrite(&Header, sizeof(Header), 1, File) == 1 &&
+                   fwrite(Result.vertices.data(), sizeof(glf::vertex_v3fn3fv2f), Result.vertices.size(), File) == Result.vertices.size() &&
+                   fwrite(Result.indices.data(), sizeof(GLuint), Result.indices.size(), File) == Result.indices.size();
+    Success = fclose(File) == 0 && Success;
+
+    std::error_code Error;
+    if (Success)
+        std::filesystem::rename(Temporary, CacheFilename, Error);
+    if (!Success || Error) {
+        std::filesystem::remove(Temporary, Error);
+        return false;
+    }
+    return true;
+}
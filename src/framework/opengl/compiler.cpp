@@ -14,13 +14,25 @@
 
 #include <glm/gtc/random.hpp>
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <cstdarg>
+#include <deque>
+#include <filesystem>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <string>
 
 #include <iostream>
 
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 std::string getDataDirectory() { return std::string("../data/shaders/"); }
 std::string format(const char *Message, ...) {
     assert(Message);
@@ -36,6 +48,26 @@ std::string format(const char *Message, ...) {
     return Text;
 }
 
+namespace glf {
+    bool versionAtLeast(int Major, int Minor) {
+        GLint ContextMajor = 0, ContextMinor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &ContextMajor);
+        glGetIntegerv(GL_MINOR_VERSION, &ContextMinor);
+        return ContextMajor > Major || (ContextMajor == Major && ContextMinor >= Minor);
+    }
+
+    bool hasExtension(char const *Name) {
+        GLint Count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &Count);
+        for (GLint i = 0; i < Count; ++i) {
+            char const *Extension = reinterpret_cast<char const *>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+            if (Extension != NULL && std::strcmp(Extension, Name) == 0)
+                return true;
+        }
+        return false;
+    }
+} // namespace glf
+
 Compiler::commandline::commandline(std::string const &Filename, std::string const &Arguments) : Profile("core"), Version(-1) {
     std::size_t PathOffset = Filename.find_last_of("/");
     std::string FilePath = Filename.substr(0, PathOffset + 1);
@@ -99,76 +131,238 @@ std::string Compiler::commandline::getDefines() const {
 
 // compiler::parser
 
-std::string Compiler::parser::operator()(commandline const &CommandLine, std::string const &Filename) const {
-    std::string Source = load_file(Filename);
-    assert(!Source.empty());
+namespace {
+    struct cached_source {
+        std::shared_ptr<std::string const> Text;
+        std::filesystem::file_time_type Time;
+        std::uintmax_t Size;
+    };
+
+    std::mutex SourceCacheMutex;
+    std::map<std::string, cached_source> SourceCache;
+
+    std::string normalizePath(std::string const &Filename) { return std::filesystem::path(Filename).lexically_normal().generic_string(); }
+
+    // Content of a file shared by all compilers, read again only when the file changed on disk. Null when the file doesn't exist.
+    std::shared_ptr<std::string const> loadSource(std::string const &Path) {
+        std::error_code Error;
+        std::filesystem::file_time_type Time = std::filesystem::last_write_time(Path, Error);
+        std::uintmax_t Size = Error ? 0 : std::filesystem::file_size(Path, Error);
+        if (Error) {
+            std::lock_guard<std::mutex> Lock(SourceCacheMutex);
+            SourceCache.erase(Path);
+            return nullptr;
+        }
 
-    std::stringstream Stream;
-    Stream << Source;
-    std::string Line, Text;
+        {
+            std::lock_guard<std::mutex> Lock(SourceCacheMutex);
+            std::map<std::string, cached_source>::const_iterator Iterator = SourceCache.find(Path);
+            if (Iterator != SourceCache.end() && Iterator->second.Time == Time && Iterator->second.Size == Size)
+                return Iterator->second.Text;
+        }
 
-    // Handle command line version and profile arguments
-    if (CommandLine.getVersion() != -1)
-        Text += format("#version %d %s\n", CommandLine.getVersion(), CommandLine.getProfile().c_str());
+        std::shared_ptr<std::string const> Text = std::make_shared<std::string const>(load_file(Path));
+        std::lock_guard<std::mutex> Lock(SourceCacheMutex);
+        SourceCache[Path] = {Text, Time, Size};
+        return Text;
+    }
 
-    // Handle command line defines
-    Text += CommandLine.getDefines();
+    char const *skipBlanks(char const *First, char const *Last) {
+        while (First != Last && (*First == ' ' || *First == '\t'))
+            ++First;
+        return First;
+    }
 
-    while (std::getline(Stream, Line)) {
-        std::size_t Offset = 0;
+    // Matches a keyword followed by a blank or the end of the line
+    bool matchKeyword(char const *&First, char const *Last, char const *Keyword) {
+        std::size_t Size = std::strlen(Keyword);
+        if (std::size_t(Last - First) < Size || std::memcmp(First, Keyword, Size) != 0)
+            return false;
+        if (First + Size != Last && First[Size] != ' ' && First[Size] != '\t' && First[Size] != '\r')
+            return false;
+        First += Size;
+        return true;
+    }
 
-        // Version
-        Offset = Line.find("#version");
-        if (Offset != std::string::npos) {
-            std::size_t CommentOffset = Line.find("//");
-            if (CommentOffset != std::string::npos && CommentOffset < Offset)
-                continue;
+    char const Newline[] = "\n";
+    int const MaxIncludeDepth = 32;
+} // namespace
 
-            // Reorder so that the #version line is always the first of a shader text
-            if (CommandLine.getVersion() == -1)
-                Text = Line + std::string("\n") + Text;
-            // else skip is version is only mentionned
-            continue;
-        }
+void Compiler::invalidateSource(std::string const &Filename) {
+    std::lock_guard<std::mutex> Lock(SourceCacheMutex);
+    SourceCache.erase(normalizePath(Filename));
+}
 
-        // Include
-        Offset = Line.find("#include");
-        if (Offset != std::string::npos) {
-            std::size_t CommentOffset = Line.find("//");
-            if (CommentOffset != std::string::npos && CommentOffset < Offset)
-                continue;
+void Compiler::clearSourceCache() {
+    std::lock_guard<std::mutex> Lock(SourceCacheMutex);
+    SourceCache.clear();
+}
 
-            std::string Include = parseInclude(Line, Offset);
+struct Compiler::parser::context {
+    commandline const &CommandLine;
+    std::vector<std::string> &Files;
+    std::vector<std::shared_ptr<std::string const>> Sources; // Keeps the chunked texts alive
+    std::deque<std::string> Directives;                      // Generated lines, a deque doesn't move its elements
+    std::vector<chunk> Chunks;
+    std::vector<std::string> Stack;
+    std::set<std::string> Once;
+    std::string Version;
+
+    context(commandline const &CommandLine, std::vector<std::string> &Files) : CommandLine(CommandLine), Files(Files) {}
+
+    void append(char const *Data, std::size_t Size) {
+        if (Size > 0)
+            this->Chunks.push_back({Data, Size});
+    }
+
+    // GLSL 3.30 semantics, the line following the directive is Line
+    void appendLine(int Line, std::size_t File) {
+        this->Directives.push_back("#line " + std::to_string(Line) + " " + std::to_string(File) + "\n");
+        this->append(this->Directives.back().data(), this->Directives.back().size());
+    }
+
+    std::size_t fileIndex(std::string const &Path) {
+        std::vector<std::string>::iterator Iterator = std::find(this->Files.begin(), this->Files.end(), Path);
+        if (Iterator != this->Files.end())
+            return std::size_t(Iterator - this->Files.begin());
+        this->Files.push_back(Path);
+        return this->Files.size() - 1;
+    }
+};
 
-            std::vector<std::string> Includes = CommandLine.getIncludes();
+std::string Compiler::parser::operator()(commandline const &CommandLine, std::string const &Filename, std::vector<std::string> &Files) const {
+    Files.clear();
+    context Context(CommandLine, Files);
 
-            for (std::size_t i = 0; i < Includes.size(); ++i) {
-                std::string PathName = Includes[i] + Include;
-                std::string IncludeSource = load_file(PathName);
-                if (!IncludeSource.empty()) {
-                    Text += IncludeSource;
-                    break;
+    if (!this->parseFile(Context, normalizePath(Filename), 0))
+        return std::string();
+
+    // The #version line always comes first, from the command line or else reordered from the sources, then the defines
+    std::string Prelude;
+    if (CommandLine.getVersion() != -1)
+        Prelude = format("#version %d %s\n", CommandLine.getVersion(), CommandLine.getProfile().c_str());
+    else if (!Context.Version.empty())
+        Prelude = Context.Version + "\n";
+    Prelude += CommandLine.getDefines();
+    Prelude += "#line 1 0\n";
+
+    std::size_t Size = Prelude.size();
+    for (std::size_t i = 0; i < Context.Chunks.size(); ++i)
+        Size += Context.Chunks[i].Size;
+
+    std::string Text;
+    Text.reserve(Size);
+    Text += Prelude;
+    for (std::size_t i = 0; i < Context.Chunks.size(); ++i)
+        Text.append(Context.Chunks[i].Data, Context.Chunks[i].Size);
+
+    return Text;
+}
+
+bool Compiler::parser::parseFile(context &Context, std::string const &Filename, int Depth) const {
+    std::shared_ptr<std::string const> Source = loadSource(Filename);
+    if (!Source) {
+        Qulkan::Logger::Error("Compiler: Could not open %s\n", Filename.c_str());
+        return false;
+    }
+    Context.Sources.push_back(Source);
+    std::size_t FileIndex = Context.fileIndex(Filename);
+    Context.Stack.push_back(Filename);
+
+    std::string Directory = std::filesystem::path(Filename).parent_path().generic_string();
+    if (!Directory.empty())
+        Directory += '/';
+
+    char const *Begin = Source->data();
+    char const *End = Begin + Source->size();
+    char const *Run = Begin; // Start of the lines copied as is
+    int LineNumber = 1;
+
+    for (char const *Line = Begin; Line < End; ++LineNumber) {
+        char const *LineEnd = static_cast<char const *>(std::memchr(Line, '\n', std::size_t(End - Line)));
+        char const *Next = LineEnd ? LineEnd + 1 : End;
+        if (!LineEnd)
+            LineEnd = End;
+
+        char const *Cursor = skipBlanks(Line, LineEnd);
+        if (Cursor == LineEnd || *Cursor != '#') {
+            Line = Next;
+            continue;
+        }
+        Cursor = skipBlanks(Cursor + 1, LineEnd);
+
+        if (matchKeyword(Cursor, LineEnd, "version")) {
+            if (Context.Version.empty() && Context.CommandLine.getVersion() == -1)
+                Context.Version.assign(Line, LineEnd[-1] == '\r' ? LineEnd - 1 : LineEnd);
+        } else if (matchKeyword(Cursor, LineEnd, "pragma")) {
+            char const *Argument = skipBlanks(Cursor, LineEnd);
+            if (!matchKeyword(Argument, LineEnd, "once")) {
+                Line = Next;
+                continue;
+            }
+            Context.Once.insert(Filename);
+        } else if (matchKeyword(Cursor, LineEnd, "include")) {
+            std::string Include = this->parseInclude(Cursor, std::size_t(LineEnd - Cursor));
+
+            // Next to the including file first, then in the command line include directories
+            std::string Path;
+            if (!Include.empty()) {
+                std::vector<std::string> const &Includes = Context.CommandLine.getIncludes();
+                for (std::size_t i = 0; i <= Includes.size() && Path.empty(); ++i) {
+                    std::string Candidate = normalizePath((i == 0 ? Directory : Includes[i - 1]) + Include);
+                    std::error_code Error;
+                    if (std::filesystem::is_regular_file(Candidate, Error))
+                        Path = Candidate;
                 }
             }
 
+            Context.append(Run, std::size_t(Line - Run));
+            Run = Next;
+
+            if (Path.empty()) {
+                Qulkan::Logger::Error("Compiler: %s:%d: Include \"%s\" not found\n", Filename.c_str(), LineNumber, Include.c_str());
+                Context.append(Newline, 1);
+            } else if (Context.Once.count(Path) > 0) {
+                Context.append(Newline, 1);
+            } else if (std::find(Context.Stack.begin(), Context.Stack.end(), Path) != Context.Stack.end() || Depth + 1 >= MaxIncludeDepth) {
+                Qulkan::Logger::Error("Compiler: %s:%d: Recursive include of \"%s\"\n", Filename.c_str(), LineNumber, Include.c_str());
+                Context.append(Newline, 1);
+            } else {
+                Context.appendLine(1, Context.fileIndex(Path));
+                this->parseFile(Context, Path, Depth + 1);
+                Context.appendLine(LineNumber + 1, FileIndex);
+            }
+            Line = Next;
+            continue;
+        } else {
+            Line = Next;
             continue;
         }
 
-        Text += Line + "\n";
+        // #version and #pragma once are replaced by an empty line to keep the numbering
+        Context.append(Run, std::size_t(Line - Run));
+        Context.append(Newline, 1);
+        Run = Next;
+        Line = Next;
     }
 
-    // Text += glf::format("\nconst float G_TRUC_GNI = %f;\n", glm::linearRand(0.0f, 1.0f));
+    Context.append(Run, std::size_t(End - Run));
+    if (Begin != End && End[-1] != '\n')
+        Context.append(Newline, 1);
 
-    return Text;
+    Context.Stack.pop_back();
+    return true;
 }
 
-std::string Compiler::parser::parseInclude(std::string const &Line, std::size_t const &Offset) const {
-    std::string Result;
-
-    std::string::size_type IncludeFirstQuote = Line.find("\"", Offset);
-    std::string::size_type IncludeSecondQuote = Line.find("\"", IncludeFirstQuote + 1);
-
-    return Line.substr(IncludeFirstQuote + 1, IncludeSecondQuote - IncludeFirstQuote - 1);
+std::string Compiler::parser::parseInclude(char const *Line, std::size_t Size) const {
+    char const *End = Line + Size;
+    char const *FirstQuote = std::find(Line, End, '"');
+    if (FirstQuote == End)
+        return std::string();
+    char const *SecondQuote = std::find(FirstQuote + 1, End, '"');
+    if (SecondQuote == End)
+        return std::string();
+    return std::string(FirstQuote + 1, SecondQuote);
 }
 
 // compiler
@@ -179,26 +373,235 @@ GLuint Compiler::create(GLenum Type, std::string const &Filename, std::string co
 
     commandline CommandLine(Filename, Arguments);
 
-    std::string PreprocessedSource = parser()(CommandLine, Filename);
+    std::vector<std::string> Dependencies;
+    std::string PreprocessedSource = parser()(CommandLine, Filename, Dependencies);
     assert(!PreprocessedSource.empty());
     char const *PreprocessedSourcePointer = PreprocessedSource.c_str();
 
     // Qulkan::Logger::Info("%s\n", PreprocessedSource.c_str());
 
+    if (Type == GL_COMPUTE_SHADER && !computeSupported()) {
+        Qulkan::Logger::Error("Compiler: %s is a compute shader but the context is older than OpenGL 4.3\n", Filename.c_str());
+        return 0;
+    }
+
+    // The compiler threads are set up before the first compile, every shader is created before it is compiled
+    parallelCompileSupported();
+
     GLuint Name = glCreateShader(Type);
     glShaderSource(Name, 1, &PreprocessedSourcePointer, NULL);
-    glCompileShader(Name);
 
     std::pair<files_map::iterator, bool> ResultFiles = this->ShaderFiles.insert(std::make_pair(Name, Filename));
     assert(ResultFiles.second);
     std::pair<names_map::iterator, bool> ResultNames = this->ShaderNames.insert(std::make_pair(Filename, Name));
     assert(ResultNames.second);
-    std::pair<names_map::iterator, bool> ResultChecks = this->PendingChecks.insert(std::make_pair(Filename, Name));
-    assert(ResultChecks.second);
+
+    this->ShaderSources[Name] = std::move(PreprocessedSource);
+    this->ShaderTypes[Name] = Type;
+    this->ShaderDependencies[Name] = std::move(Dependencies);
 
     return Name;
 }
 
+bool Compiler::compile(GLuint const &Name) {
+    files_map::iterator NameIterator = this->ShaderFiles.find(Name);
+    if (NameIterator == this->ShaderFiles.end())
+        return false; // Shader name not found
+
+    // Already compiled
+    if (this->PendingChecks.find(NameIterator->second) != this->PendingChecks.end())
+        return true;
+
+    glCompileShader(Name);
+    std::pair<names_map::iterator, bool> ResultChecks = this->PendingChecks.insert(std::make_pair(NameIterator->second, Name));
+    assert(ResultChecks.second);
+    return true;
+}
+
+void Compiler::compile() {
+    for (files_map::iterator ShaderIterator = this->ShaderFiles.begin(); ShaderIterator != this->ShaderFiles.end(); ++ShaderIterator)
+        this->compile(ShaderIterator->first);
+}
+
+namespace {
+    std::string &binaryCacheDirectory() {
+        static std::string Directory("shadercache/");
+        return Directory;
+    }
+
+    // FNV-1a
+    void hashBytes(glm::uint64 &Hash, void const *Data, std::size_t Size) {
+        unsigned char const *Bytes = static_cast<unsigned char const *>(Data);
+        for (std::size_t i = 0; i < Size; ++i) {
+            Hash ^= Bytes[i];
+            Hash *= 1099511628211ull;
+        }
+    }
+
+    void hashString(glm::uint64 &Hash, char const *String) {
+        if (String != NULL)
+            hashBytes(Hash, String, std::strlen(String) + 1);
+    }
+} // namespace
+
+void Compiler::setBinaryCacheDirectory(std::string const &Directory) {
+    binaryCacheDirectory() = Directory;
+    if (!Directory.empty() && Directory.back() != '/')
+        binaryCacheDirectory() += '/';
+}
+
+std::string const &Compiler::getBinaryCacheDirectory() { return binaryCacheDirectory(); }
+
+bool Compiler::binaryCacheSupported() {
+    // GL_NUM_PROGRAM_BINARY_FORMATS is core in 4.1, an invalid enum on 3.3 drivers without ARB_get_program_binary
+    static int Supported = -1;
+    if (Supported == -1) {
+        GLint Formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &Formats);
+        while (glGetError() != GL_NO_ERROR)
+            ;
+        Supported = Formats > 0 && !binaryCacheDirectory().empty() ? 1 : 0;
+    }
+    return Supported == 1;
+}
+
+std::string Compiler::binaryCacheFilename(std::vector<GLuint> const &Shaders) const {
+    glm::uint64 Hash = 14695981039346656037ull;
+    hashString(Hash, reinterpret_cast<char const *>(glGetString(GL_VENDOR)));
+    hashString(Hash, reinterpret_cast<char const *>(glGetString(GL_RENDERER)));
+    hashString(Hash, reinterpret_cast<char const *>(glGetString(GL_VERSION)));
+    for (std::size_t i = 0; i < Shaders.size(); ++i) {
+        std::map<GLuint, GLenum>::const_iterator TypeIterator = this->ShaderTypes.find(Shaders[i]);
+        std::map<GLuint, std::string>::const_iterator SourceIterator = this->ShaderSources.find(Shaders[i]);
+        if (TypeIterator == this->ShaderTypes.end() || SourceIterator == this->ShaderSources.end())
+            return std::string();
+        hashBytes(Hash, &TypeIterator->second, sizeof(GLenum));
+        hashString(Hash, SourceIterator->second.c_str());
+    }
+    return binaryCacheDirectory() + format("%016llx.bin", static_cast<unsigned long long>(Hash));
+}
+
+bool Compiler::parallelCompileSupported() {
+    static int Supported = -1;
+    if (Supported == -1) {
+        Supported = 0;
+        static char const *const Extensions[][2] = {{"GL_KHR_parallel_shader_compile", "glMaxShaderCompilerThreadsKHR"},
+                                                    {"GL_ARB_parallel_shader_compile", "glMaxShaderCompilerThreadsARB"}};
+        for (std::size_t i = 0; i < sizeof(Extensions) / sizeof(Extensions[0]) && Supported == 0; ++i) {
+            if (!glf::hasExtension(Extensions[i][0]))
+                continue;
+
+            typedef void(APIENTRYP max_threads_proc)(GLuint Count);
+            max_threads_proc MaxShaderCompilerThreads = reinterpret_cast<max_threads_proc>(gl3wGetProcAddress(Extensions[i][1]));
+            if (MaxShaderCompilerThreads == NULL)
+                continue;
+
+            // As many threads as the implementation wants
+            MaxShaderCompilerThreads(0xFFFFFFFF);
+            Supported = 1;
+            Qulkan::Logger::Info("Compiler: Using %s\n", Extensions[i][0]);
+        }
+    }
+    return Supported == 1;
+}
+
+bool Compiler::computeSupported() {
+    static int Supported = -1;
+    if (Supported == -1)
+        Supported = glf::versionAtLeast(4, 3) ? 1 : 0;
+    return Supported == 1;
+}
+
+void Compiler::link(GLuint ProgramName, std::vector<GLuint> const &Shaders) {
+    // A shader create() refused, the program stays unlinked and check_program() reports it
+    if (std::find(Shaders.begin(), Shaders.end(), GLuint(0)) != Shaders.end()) {
+        Qulkan::Logger::Error("Compiler: Program %d not linked, one of its shaders couldn't be created\n", ProgramName);
+        return;
+    }
+
+    pending_link Link = {ProgramName, Shaders, binaryCacheSupported() ? this->binaryCacheFilename(Shaders) : std::string(), false};
+
+    if (!Link.CacheFilename.empty()) {
+        GLenum Format = 0;
+        GLint Size = 0;
+        std::vector<glm::uint8> Data;
+        if (load_binary(Link.CacheFilename, Format, Data, Size)) {
+            glProgramBinary(ProgramName, Format, &Data[0], Size);
+            Link.FromBinary = true;
+        }
+    }
+
+    if (!Link.FromBinary)
+        this->linkShaders(Link);
+    this->PendingLinks.push_back(std::move(Link));
+}
+
+void Compiler::linkShaders(pending_link const &Link) {
+    if (!Link.CacheFilename.empty())
+        glProgramParameteri(Link.Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    for (std::size_t i = 0; i < Link.Shaders.size(); ++i) {
+        this->compile(Link.Shaders[i]);
+        glAttachShader(Link.Program, Link.Shaders[i]);
+    }
+    glLinkProgram(Link.Program);
+}
+
+void Compiler::finishLink(pending_link &Link) {
+    GLint Result = GL_FALSE;
+    glGetProgramiv(Link.Program, GL_LINK_STATUS, &Result);
+
+    if (Result != GL_TRUE && Link.FromBinary) {
+        // Rejected by the driver (e.g. after a driver update)
+        Qulkan::Logger::Info("Compiler: Stale program binary %s, recompiling\n", Link.CacheFilename.c_str());
+        Link.FromBinary = false;
+        this->linkShaders(Link);
+        glGetProgramiv(Link.Program, GL_LINK_STATUS, &Result);
+    }
+
+    if (Result != GL_TRUE || Link.FromBinary || Link.CacheFilename.empty())
+        return;
+
+    GLint Size = 0;
+    glGetProgramiv(Link.Program, GL_PROGRAM_BINARY_LENGTH, &Size);
+    if (Size > 0) {
+        std::vector<glm::uint8> Data(Size);
+        GLenum Format = 0;
+        glGetProgramBinary(Link.Program, Size, &Size, &Format, &Data[0]);
+
+        std::error_code Error;
+        std::filesystem::create_directories(binaryCacheDirectory(), Error);
+        if (!save_binary(Link.CacheFilename, Format, Data, Size))
+            Qulkan::Logger::Warning("Compiler: Could not write the program binary %s\n", Link.CacheFilename.c_str());
+    }
+}
+
+void Compiler::finishLinks() {
+    bool Parallel = parallelCompileSupported();
+    while (!this->PendingLinks.empty()) {
+        // The links already completed first, the others keep going meanwhile. When none is done, wait on the oldest.
+        std::size_t Next = 0;
+        for (std::size_t i = 0; Parallel && i < this->PendingLinks.size(); ++i) {
+            GLint Completed = GL_FALSE;
+            glGetProgramiv(this->PendingLinks[i].Program, GL_COMPLETION_STATUS_KHR, &Completed);
+            if (Completed == GL_TRUE) {
+                Next = i;
+                break;
+            }
+        }
+
+        pending_link Link = std::move(this->PendingLinks[Next]);
+        this->PendingLinks.erase(this->PendingLinks.begin() + Next);
+        this->finishLink(Link);
+    }
+}
+
+std::vector<std::string> const &Compiler::dependencies(GLuint const &Name) const {
+    static std::vector<std::string> const None;
+    std::map<GLuint, std::vector<std::string>>::const_iterator Iterator = this->ShaderDependencies.find(Name);
+    return Iterator != this->ShaderDependencies.end() ? Iterator->second : None;
+}
+
 bool Compiler::destroy(GLuint const &Name) {
     files_map::iterator NameIterator = this->ShaderFiles.find(Name);
     if (NameIterator == this->ShaderFiles.end())
@@ -211,6 +614,10 @@ bool Compiler::destroy(GLuint const &Name) {
     if (PendingIterator != this->PendingChecks.end())
         this->PendingChecks.erase(PendingIterator);
 
+    this->ShaderSources.erase(Name);
+    this->ShaderTypes.erase(Name);
+    this->ShaderDependencies.erase(Name);
+
     // Remove from the pending checks list
     names_map::iterator FileIterator = this->ShaderNames.find(File);
     assert(FileIterator != this->ShaderNames.end());
@@ -265,8 +672,41 @@ bool Compiler::check_program(GLuint ProgramName) const {
     return Result == GL_TRUE;
 }
 
+std::string Compiler::translateLog(GLuint const &Name, std::string const &Log) const {
+    std::vector<std::string> const &Files = this->dependencies(Name);
+    if (Files.empty())
+        return Log;
+
+    // Locations start with the source string number: "0:12(3)" (Mesa), "0(12)" (NVIDIA), "ERROR: 0:12" (AMD, Intel)
+    std::string Result;
+    Result.reserve(Log.size());
+    std::stringstream Stream(Log);
+    std::string Line;
+    while (std::getline(Stream, Line)) {
+        std::size_t Offset = 0;
+        if (Line.compare(0, 7, "ERROR: ") == 0)
+            Offset = 7;
+        else if (Line.compare(0, 9, "WARNING: ") == 0)
+            Offset = 9;
+
+        std::size_t Digits = Offset;
+        while (Digits < Line.size() && std::isdigit(static_cast<unsigned char>(Line[Digits])))
+            ++Digits;
+        if (Digits > Offset && Digits < Line.size() && (Line[Digits] == ':' || Line[Digits] == '(')) {
+            std::size_t File = std::stoul(Line.substr(Offset, Digits - Offset));
+            if (File < Files.size())
+                Line.replace(Offset, Digits - Offset, Files[File]);
+        }
+        Result += Line;
+        Result += '\n';
+    }
+    return Result;
+}
+
 // TODO Interaction with KHR_debug
 bool Compiler::check() {
+    this->finishLinks();
+
     bool Success(true);
 
     for (names_map::iterator ShaderIterator = PendingChecks.begin(); ShaderIterator != PendingChecks.end(); ++ShaderIterator) {
@@ -282,7 +722,7 @@ bool Compiler::check() {
         if (InfoLogLength > 0) {
             std::vector<char> Buffer(InfoLogLength);
             glGetShaderInfoLog(ShaderName, InfoLogLength, NULL, &Buffer[0]);
-            Qulkan::Logger::Error("%s\n", &Buffer[0]);
+            Qulkan::Logger::Error("%s\n", this->translateLog(ShaderName, &Buffer[0]).c_str());
         }
 
         Success = Success && Result == GL_TRUE;
@@ -298,6 +738,10 @@ void Compiler::clear() {
     this->ShaderNames.clear();
     this->ShaderFiles.clear();
     this->PendingChecks.clear();
+    this->ShaderSources.clear();
+    this->ShaderTypes.clear();
+    this->ShaderDependencies.clear();
+    this->PendingLinks.clear();
 }
 
 std::string load_file(std::string const &Filename) {
@@ -318,29 +762,40 @@ std::string load_file(std::string const &Filename) {
 
 bool load_binary(std::string const &Filename, GLenum &Format, std::vector<glm::uint8> &Data, GLint &Size) {
     FILE *File = fopen(Filename.c_str(), "rb");
+    if (!File)
+        return false;
 
-    if (File) {
-        fread(&Format, sizeof(GLenum), 1, File);
-        fread(&Size, sizeof(Size), 1, File);
-        if (Size > 0) {
-            Data.resize(Size);
-            fread(&Data[0], Size, 1, File);
-            return true;
-        }
-        fclose(File);
+    bool Success = fread(&Format, sizeof(GLenum), 1, File) == 1 && fread(&Size, sizeof(Size), 1, File) == 1 && Size > 0;
+    if (Success) {
+        // A file cut short or overwritten by another tool is not handed to the driver
+        long Header = ftell(File);
+        Success = Header >= 0 && fseek(File, 0, SEEK_END) == 0 && ftell(File) - Header == long(Size) && fseek(File, Header, SEEK_SET) == 0;
+    }
+    if (Success) {
+        Data.resize(Size);
+        Success = fread(&Data[0], Size, 1, File) == 1;
     }
-    return false;
+    fclose(File);
+    if (!Success)
+        Qulkan::Logger::Warning("Compiler: Ignoring the invalid program binary %s\n", Filename.c_str());
+    return Success;
 }
 
 bool save_binary(std::string const &Filename, GLenum const &Format, std::vector<glm::uint8> const &Data, GLint const &Size) {
-    FILE *File = fopen(Filename.c_str(), "wb");
-
-    if (File) {
-        fwrite(&Format, sizeof(GLenum), 1, File);
-        fwrite(&Size, sizeof(Size), 1, File);
-        fwrite(&Data[0], Size, 1, File);
-        fclose(File);
-        return true;
+    // Written next to the cache and renamed, a crash or another instance never leaves a partial binary under the cache name
+    std::string Temporary = Filename + format(".%llx.tmp", static_cast<unsigned long long>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    FILE *File = fopen(Temporary.c_str(), "wb");
+    if (!File)
+        return false;
+    bool Success = fwrite(&Format, sizeof(GLenum), 1, File) == 1 && fwrite(&Size, sizeof(Size), 1, File) == 1 && fwrite(&Data[0], Size, 1, File) == 1;
+    Success = fclose(File) == 0 && Success;
+
+    std::error_code Error;
+    if (Success)
+        std::filesystem::rename(Temporary, Filename, Error);
+    if (!Success || Error) {
+        std::filesystem::remove(Temporary, Error);
+        return false;
     }
-    return false;
+    return true;
 }
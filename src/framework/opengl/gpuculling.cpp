@@ -0,0 +1,181 @@
+#include "framework/opengl/gpuculling.h"
+#include "framework/opengl/multidrawbatch.h"
+#include "framework/opengl/vaomanager.h"
+#include "qulkan/logger.h"
+#include "qulkan/profiler.h"
+
+#include <algorithm>
+#include <glm/gtc/type_ptr.hpp>
+
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#endif
+#ifndef GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS
+#define GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS 0x90DB
+#endif
+#ifndef GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#endif
+#ifndef GL_COMMAND_BARRIER_BIT
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+namespace {
+    typedef void(APIENTRYP dispatch_compute_proc)(GLuint groupsX, GLuint groupsY, GLuint groupsZ);
+    typedef void(APIENTRYP memory_barrier_proc)(GLbitfield barriers);
+    typedef void(APIENTRYP draw_elements_indirect_proc)(GLenum mode, GLenum type, void const *indirect);
+
+    // OpenGL 4.3, GPUCulling::supported() checks the context before they are called
+    dispatch_compute_proc dispatchCompute() {
+        static dispatch_compute_proc proc = reinterpret_cast<dispatch_compute_proc>(gl3wGetProcAddress("glDispatchCompute"));
+        return proc;
+    }
+
+    memory_barrier_proc memoryBarrier() {
+        static memory_barrier_proc proc = reinterpret_cast<memory_barrier_proc>(gl3wGetProcAddress("glMemoryBarrier"));
+        return proc;
+    }
+
+    draw_elements_indirect_proc drawElementsIndirect() {
+        static draw_elements_indirect_proc proc = reinterpret_cast<draw_elements_indirect_proc>(gl3wGetProcAddress("glDrawElementsIndirect"));
+        return proc;
+    }
+
+    // The shader copies the instances word by word, 21 words per instance
+    static_assert(sizeof(glf::instance_m4fc4fu1) == 21 * sizeof(GLuint), "INSTANCE_WORDS of frustumcull.comp has to match the instances");
+} // namespace
+
+GPUCulling::GPUCulling() : programManager(nullptr), outputBuffer(0), indirectBuffer(0), maxInstances(0), storageAlignment(1), uniforms() {}
+
+bool GPUCulling::supported() {
+    static int supported = -1;
+    if (supported == -1) {
+        // The input instances, the output instances and the draw command
+        GLint storageBlocks = 0;
+        if (Compiler::computeSupported())
+            glGetIntegerv(GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS, &storageBlocks);
+        supported = storageBlocks >= 3 && dispatchCompute() != nullptr && memoryBarrier() != nullptr && drawElementsIndirect() != nullptr ? 1 : 0;
+        Qulkan::Logger::Info("GPUCulling: %s\n", supported == 1 ? "compute shader culling" : "no compute shaders, culling disabled");
+    }
+    return supported == 1;
+}
+
+void GPUCulling::submitProgram(ShaderManager &shaderManager, ProgramManager &programManager, Compiler &compiler) {
+    shaderManager.addShader("COMP_GPU_CULLING", "../data/shaders/culling/frustumcull.comp", GL_COMPUTE_SHADER, compiler, "--version 430 --profile core");
+
+    programManager.addProgram(PROGRAM);
+    programManager.link(PROGRAM, {"COMP_GPU_CULLING"}, shaderManager, compiler);
+}
+
+bool GPUCulling::create(ProgramManager &manager, GLsizei instances) {
+    destroy();
+    if (!supported())
+        return false;
+
+    programManager = &manager;
+    resolveUniforms();
+
+    glm::ivec3 workGroupSize = programManager->workGroupSize(PROGRAM);
+    if (GLuint(workGroupSize.x) != WORK_GROUP_SIZE) {
+        Qulkan::Logger::Error("GPUCulling: %s is not linked or its work groups are not of %u invocations\n", PROGRAM, WORK_GROUP_SIZE);
+        return false;
+    }
+
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+    storageAlignment = std::max(storageAlignment, GLint(1));
+
+    // Written and read by the GPU only
+    glGenBuffers(1, &outputBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, outputBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(instances) * GLsizeiptr(sizeof(Instance)), nullptr, GL_DYNAMIC_COPY);
+
+    glGenBuffers(1, &indirectBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, indirectBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(sizeof(DrawElementsIndirectCommand)), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    maxInstances = instances;
+    return true;
+}
+
+void GPUCulling::destroy() {
+    if (outputBuffer != 0)
+        glDeleteBuffers(1, &outputBuffer);
+    if (indirectBuffer != 0)
+        glDeleteBuffers(1, &indirectBuffer);
+    outputBuffer = indirectBuffer = 0;
+    maxInstances = 0;
+}
+
+void GPUCulling::resolveUniforms() {
+    if (programManager == nullptr)
+        return;
+    programManager->reflect(PROGRAM);
+    uniforms.instanceCount = programManager->uniform(PROGRAM, "instanceCount");
+    uniforms.firstWord = programManager->uniform(PROGRAM, "firstWord");
+    uniforms.boundingSphere = programManager->uniform(PROGRAM, "boundingSphere");
+    uniforms.planes = programManager->uniformLocation(PROGRAM, "planes");
+}
+
+bool GPUCulling::cull(InstanceRenderer &instanceRenderer, InstanceRenderer::Range const &range, ArenaMesh const &mesh, glm::vec4 const &boundingSphere,
+                      Frustum const &frustum) {
+    QULKAN_PROFILE_ZONE("GPUCulling::cull");
+
+    if (maxInstances == 0 || !range.valid() || !mesh.valid())
+        return false;
+    if (range.count > maxInstances) {
+        Qulkan::Logger::Error("GPUCulling: %d instances to cull, the buffers hold %d\n", range.count, maxInstances);
+        return false;
+    }
+
+    // The draw arguments of the mesh, with no instance until the shader counts them
+    DrawElementsIndirectCommand command = {mesh.indexCount, 0, mesh.firstIndex, mesh.baseVertex, 0};
+    glBindBuffer(GL_COPY_WRITE_BUFFER, indirectBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, GLsizeiptr(sizeof(command)), &command);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    // The instances are only 16 bytes aligned in the stream buffer, the binding starts at the previous aligned offset
+    instanceRenderer.flush();
+    GLintptr bindingOffset = range.offset / storageAlignment * storageAlignment;
+    GLsizeiptr bindingSize = range.offset - bindingOffset + GLsizeiptr(range.count) * GLsizeiptr(sizeof(Instance));
+
+    glUseProgram(programManager->programID(PROGRAM));
+    uniforms.instanceCount.set(int(range.count));
+    uniforms.firstWord.set(int((range.offset - bindingOffset) / GLintptr(sizeof(GLuint))));
+    uniforms.boundingSphere.set(boundingSphere);
+    if (uniforms.planes != -1)
+        glUniform4fv(uniforms.planes, Frustum::PLANE_COUNT, glm::value_ptr(frustum.planes[0]));
+
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, instanceRenderer.getStreamBuffer().id(), bindingOffset, bindingSize);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, outputBuffer, 0, GLsizeiptr(range.count) * GLsizeiptr(sizeof(Instance)));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, indirectBuffer);
+
+    dispatchCompute()((GLuint(range.count) + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE, 1, 1);
+    // The compacted instances are read as vertex attributes and the count as a draw argument
+    memoryBarrier()(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    for (GLuint binding = 0; binding < 3; ++binding)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+    glUseProgram(0);
+    return true;
+}
+
+void GPUCulling::drawElements(GLuint vao, GLenum mode) {
+    if (maxInstances == 0)
+        return;
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, outputBuffer);
+    glf::setupVertexAttributes<Instance>(1, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+    drawElementsIndirect()(mode, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
@@ -0,0 +1,82 @@
+#include "framework/opengl/instancerenderer.h"
+#include "framework/opengl/vaomanager.h"
+
+#include <cstring>
+
+InstanceRenderer::InstanceRenderer() : maxInstances(0), instanceCount(0), drawCount(0) {}
+
+bool InstanceRenderer::create(GLsizei instances, int frames) {
+    // Room for the padding between the allocations of several submits
+    GLsizeiptr regionSize = GLsizeiptr(instances) * GLsizeiptr(sizeof(Instance)) + 4096;
+    if (!streamBuffer.create(regionSize, frames)) {
+        maxInstances = 0;
+        return false;
+    }
+    maxInstances = instances;
+    return true;
+}
+
+void InstanceRenderer::destroy() {
+    streamBuffer.destroy();
+    maxInstances = 0;
+}
+
+void InstanceRenderer::beginFrame() {
+    streamBuffer.beginFrame();
+    instanceCount = 0;
+    drawCount = 0;
+}
+
+InstanceRenderer::Range InstanceRenderer::allocate(GLsizei count) {
+    Range range;
+    if (count <= 0)
+        return range;
+
+    StreamBuffer::Allocation allocation = streamBuffer.allocate(GLsizeiptr(count) * GLsizeiptr(sizeof(Instance)), 16);
+    if (!allocation.valid())
+        return range;
+
+    range.data = static_cast<Instance *>(allocation.data);
+    range.offset = allocation.offset;
+    range.count = count;
+    return range;
+}
+
+InstanceRenderer::Range InstanceRenderer::submit(Instance const *instances, GLsizei count) {
+    Range range = allocate(count);
+    if (range.valid())
+        std::memcpy(range.data, instances, std::size_t(count) * sizeof(Instance));
+    return range;
+}
+
+bool InstanceRenderer::bindInstances(GLuint vao, Range const &range, GLuint firstInstance) {
+    if (!range.valid() || GLsizei(firstInstance) >= range.count)
+        return false;
+
+    // The writes have to reach the buffer before the draw reading them
+    flush();
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, streamBuffer.id());
+    glf::setupVertexAttributes<Instance>(1, range.offset + GLintptr(firstInstance) * GLintptr(sizeof(Instance)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void InstanceRenderer::drawArrays(GLuint vao, GLenum mode, GLint first, GLsizei vertexCount, Range const &range) {
+    if (!bindInstances(vao, range))
+        return;
+    glDrawArraysInstanced(mode, first, vertexCount, range.count);
+    instanceCount += range.count;
+    ++drawCount;
+}
+
+void InstanceRenderer::drawElements(GLuint vao, GLenum mode, GLsizei indexCount, GLenum type, GLintptr indexOffset, Range const &range) {
+    if (!bindInstances(vao, range))
+        return;
+    glDrawElementsInstanced(mode, indexCount, type, reinterpret_cast<void const *>(indexOffset), range.count);
+    instanceCount += range.count;
+    ++drawCount;
+}
+
+void InstanceRenderer::endFrame() { streamBuffer.endFrame(); }
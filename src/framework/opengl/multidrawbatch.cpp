@@ -0,0 +1,136 @@
+#include "framework/opengl/multidrawbatch.h"
+#include "framework/opengl/compiler.h"
+#include "qulkan/logger.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+namespace {
+    typedef void(APIENTRYP multi_draw_elements_indirect_proc)(GLenum mode, GLenum type, void const *indirect, GLsizei drawcount, GLsizei stride);
+
+    // OpenGL 4.3 or GL_ARB_multi_draw_indirect
+    multi_draw_elements_indirect_proc multiDrawElementsIndirect() {
+        static multi_draw_elements_indirect_proc proc =
+            reinterpret_cast<multi_draw_elements_indirect_proc>(gl3wGetProcAddress("glMultiDrawElementsIndirect"));
+        return proc;
+    }
+} // namespace
+
+MultiDrawBatch::MultiDrawBatch() : materialCount(0), drawCalls(0) {}
+
+bool MultiDrawBatch::indirectSupported() {
+    static int supported = -1;
+    if (supported == -1) {
+        bool available = glf::versionAtLeast(4, 3) || glf::hasExtension("GL_ARB_multi_draw_indirect");
+        supported = available && multiDrawElementsIndirect() != nullptr ? 1 : 0;
+        Qulkan::Logger::Info("MultiDrawBatch: %s\n", supported == 1 ? "glMultiDrawElementsIndirect" : "no indirect draws, glMultiDrawElementsBaseVertex");
+    }
+    return supported == 1;
+}
+
+bool MultiDrawBatch::create(GLsizei maxCommands, int frames) {
+    // Only the indirect draws read the commands from a buffer
+    if (!indirectSupported())
+        return true;
+    // Room for the alignment padding between the materials
+    return streamBuffer.create(GLsizeiptr(maxCommands) * GLsizeiptr(sizeof(DrawElementsIndirectCommand)) + 4096, frames);
+}
+
+void MultiDrawBatch::destroy() {
+    streamBuffer.destroy();
+    commands.clear();
+    materialCount = 0;
+}
+
+void MultiDrawBatch::beginFrame() {
+    streamBuffer.beginFrame();
+    for (unsigned material = 0; material < materialCount; ++material)
+        commands[material].clear();
+    materialCount = 0;
+    drawCalls = 0;
+}
+
+void MultiDrawBatch::add(unsigned material, ArenaMesh const &mesh, GLuint instanceCount, GLuint baseInstance) {
+    if (!mesh.valid() || instanceCount == 0)
+        return;
+
+    if (material >= commands.size())
+        commands.resize(material + 1);
+    materialCount = std::max(materialCount, material + 1);
+    commands[material].push_back(DrawElementsIndirectCommand{mesh.indexCount, instanceCount, mesh.firstIndex, mesh.baseVertex, baseInstance});
+}
+
+GLsizei MultiDrawBatch::getCommandCount(unsigned material) const { return material < materialCount ? GLsizei(commands[material].size()) : 0; }
+
+void MultiDrawBatch::draw(unsigned material, GLuint vao, GLenum mode) { drawCommands(material, vao, mode, nullptr, nullptr); }
+
+void MultiDrawBatch::draw(unsigned material, GLuint vao, InstanceRenderer &instanceRenderer, InstanceRenderer::Range const &range, GLenum mode) {
+    drawCommands(material, vao, mode, &instanceRenderer, &range);
+}
+
+void MultiDrawBatch::drawCommands(unsigned material, GLuint vao, GLenum mode, InstanceRenderer *instanceRenderer, InstanceRenderer::Range const *range) {
+    if (material >= materialCount || commands[material].empty())
+        return;
+    if (range != nullptr && !range->valid())
+        return;
+
+    std::vector<DrawElementsIndirectCommand> const &list = commands[material];
+    GLsizei drawCount = GLsizei(list.size());
+
+    if (indirectSupported()) {
+        StreamBuffer::Allocation allocation = streamBuffer.allocate(GLsizeiptr(list.size() * sizeof(DrawElementsIndirectCommand)), 16);
+        if (allocation.valid()) {
+            std::memcpy(allocation.data, list.data(), list.size() * sizeof(DrawElementsIndirectCommand));
+            streamBuffer.flush();
+
+            // The baseInstance of the commands offsets the instance attributes
+            if (instanceRenderer != nullptr)
+                instanceRenderer->bindInstances(vao, *range);
+            else
+                glBindVertexArray(vao);
+
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, streamBuffer.id());
+            multiDrawElementsIndirect()(mode, GL_UNSIGNED_INT, reinterpret_cast<void const *>(allocation.offset), drawCount, 0);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            ++drawCalls;
+            return;
+        }
+        // Out of room for the commands of this frame, drawn directly below
+    }
+
+    bool singleInstances = instanceRenderer == nullptr && std::all_of(list.begin(), list.end(), [](DrawElementsIndirectCommand const &command) {
+                               return command.instanceCount == 1;
+                           });
+    if (singleInstances) {
+        counts.resize(list.size());
+        offsets.resize(list.size());
+        baseVertices.resize(list.size());
+        for (std::size_t i = 0; i < list.size(); ++i) {
+            counts[i] = GLsizei(list[i].count);
+            offsets[i] = reinterpret_cast<void const *>(std::size_t(list[i].firstIndex) * sizeof(GLuint));
+            baseVertices[i] = list[i].baseVertex;
+        }
+        glBindVertexArray(vao);
+        glMultiDrawElementsBaseVertex(mode, counts.data(), GL_UNSIGNED_INT, offsets.data(), drawCount, baseVertices.data());
+        ++drawCalls;
+        return;
+    }
+
+    // No base instance before 4.2, the instance attributes are offset before each draw instead
+    if (instanceRenderer == nullptr)
+        glBindVertexArray(vao);
+    for (DrawElementsIndirectCommand const &command : list) {
+        if (instanceRenderer != nullptr && !instanceRenderer->bindInstances(vao, *range, command.baseInstance))
+            continue;
+        glDrawElementsInstancedBaseVertex(mode, GLsizei(command.count), GL_UNSIGNED_INT,
+                                          reinterpret_cast<void const *>(std::size_t(command.firstIndex) * sizeof(GLuint)), GLsizei(command.instanceCount),
+                                          command.baseVertex);
+        ++drawCalls;
+    }
+}
+
+void MultiDrawBatch::endFrame() { streamBuffer.endFrame(); }
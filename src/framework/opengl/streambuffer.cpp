@@ -0,0 +1,205 @@
+#include "framework/opengl/streambuffer.h"
+#include "framework/opengl/compiler.h"
+#include "qulkan/logger.h"
+#include "qulkan/profiler.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace {
+    typedef void(APIENTRYP buffer_storage_proc)(GLenum target, GLsizeiptr size, void const *data, GLbitfield flags);
+
+    // OpenGL 4.4 or GL_ARB_buffer_storage
+    buffer_storage_proc bufferStorage() {
+        static buffer_storage_proc proc = reinterpret_cast<buffer_storage_proc>(gl3wGetProcAddress("glBufferStorage"));
+        return proc;
+    }
+
+    GLsizeiptr alignUp(GLsizeiptr value, GLsizeiptr alignment) { return (value + alignment - 1) / alignment * alignment; }
+} // namespace
+
+StreamBuffer::StreamBuffer()
+    : buffer(0), persistent(false), persistentData(nullptr), regionSize(0), regionCount(0), region(0), head(0), mappedData(nullptr), mappedOffset(0),
+      stalls(0), full(false) {
+    std::fill(fences, fences + MAX_REGIONS, GLsync(0));
+}
+
+StreamBuffer::~StreamBuffer() {
+    if (buffer != 0)
+        Qulkan::Logger::Warning("StreamBuffer: Destroyed without destroy(), the buffer is leaked\n");
+}
+
+bool StreamBuffer::persistentMappingSupported() {
+    static int supported = -1;
+    if (supported == -1) {
+        bool available = glf::versionAtLeast(4, 4) || glf::hasExtension("GL_ARB_buffer_storage");
+        supported = available && bufferStorage() != nullptr ? 1 : 0;
+    }
+    return supported == 1;
+}
+
+bool StreamBuffer::create(GLsizeiptr size, int count) {
+    destroy();
+
+    // Every region starts on the largest alignment a sub-allocation can ask for
+    GLint uniformAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    regionSize = alignUp(std::max<GLsizeiptr>(size, 1), std::max<GLsizeiptr>(uniformAlignment, 256));
+    regionCount = std::clamp(count, 1, MAX_REGIONS);
+    GLsizeiptr total = regionSize * regionCount;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    persistent = persistentMappingSupported();
+    if (persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage()(GL_COPY_WRITE_BUFFER, total, nullptr, flags);
+        persistentData = static_cast<char *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags));
+        if (persistentData == nullptr) {
+            Qulkan::Logger::Error("StreamBuffer: Could not map the buffer persistently\n");
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            destroy();
+            return false;
+        }
+    } else {
+        glBufferData(GL_COPY_WRITE_BUFFER, total, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    region = regionCount - 1;
+    head = 0;
+    Qulkan::Logger::Info("StreamBuffer: %d x %lld bytes, %s\n", regionCount, static_cast<long long>(regionSize),
+                         persistent ? "persistently mapped" : "mapped unsynchronized");
+    return true;
+}
+
+void StreamBuffer::destroy() {
+    if (buffer == 0)
+        return;
+
+    for (int i = 0; i < MAX_REGIONS; ++i) {
+        if (fences[i] != 0)
+            glDeleteSync(fences[i]);
+        fences[i] = 0;
+    }
+
+    if (persistentData != nullptr || mappedData != nullptr) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &buffer);
+
+    buffer = 0;
+    persistentData = nullptr;
+    mappedData = nullptr;
+    head = 0;
+}
+
+void StreamBuffer::beginFrame() {
+    if (buffer == 0)
+        return;
+
+    flush();
+    region = (region + 1) % regionCount;
+    head = 0;
+    full = false;
+
+    GLsync &fence = fences[region];
+    if (fence == 0)
+        return;
+
+    // Signaled in the common case, the region was submitted regionCount frames ago
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        QULKAN_PROFILE_ZONE("StreamBuffer::wait");
+        ++stalls;
+        do
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        while (status == GL_TIMEOUT_EXPIRED);
+    }
+    if (status == GL_WAIT_FAILED)
+        Qulkan::Logger::Error("StreamBuffer: Waiting for region %d failed\n", region);
+    glDeleteSync(fence);
+    fence = 0;
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment) {
+    Allocation allocation;
+    if (buffer == 0 || size <= 0)
+        return allocation;
+
+    GLsizeiptr offset = alignUp(head, std::max<GLsizeiptr>(alignment, 1));
+    if (offset + size > regionSize) {
+        if (!full)
+            Qulkan::Logger::Warning("StreamBuffer: Region of %lld bytes full, %lld more requested\n", static_cast<long long>(regionSize),
+                                    static_cast<long long>(size));
+        full = true;
+        return allocation;
+    }
+
+    char *data = nullptr;
+    if (persistent) {
+        data = persistentData + regionOffset() + offset;
+    } else {
+        // The GPU is done with the region (its fence was waited on), the driver must not synchronize
+        if (mappedData == nullptr) {
+            mappedOffset = offset;
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            mappedData = static_cast<char *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, regionOffset() + mappedOffset, regionSize - mappedOffset,
+                                                              GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                                                                  GL_MAP_FLUSH_EXPLICIT_BIT));
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            if (mappedData == nullptr) {
+                Qulkan::Logger::Error("StreamBuffer: Could not map region %d\n", region);
+                return allocation;
+            }
+        }
+        data = mappedData + (offset - mappedOffset);
+    }
+
+    head = offset + size;
+    allocation.data = data;
+    allocation.offset = regionOffset() + offset;
+    allocation.size = size;
+    return allocation;
+}
+
+StreamBuffer::Allocation StreamBuffer::allocateUniform(GLsizeiptr size) {
+    static GLint alignment = 0;
+    if (alignment == 0)
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    return allocate(size, std::max<GLsizeiptr>(alignment, 1));
+}
+
+void StreamBuffer::flush() {
+    if (mappedData == nullptr)
+        return;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, 0, head - mappedOffset);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    mappedData = nullptr;
+}
+
+void StreamBuffer::endFrame() {
+    if (buffer == 0)
+        return;
+
+    flush();
+    if (fences[region] != 0)
+        glDeleteSync(fences[region]);
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::bindRange(GLenum target, GLuint index, Allocation const &allocation) const {
+    glBindBufferRange(target, index, buffer, allocation.offset, allocation.size);
+}
@@ -0,0 +1,359 @@
+#include "framework/opengl/texturestreamer.h"
+#include "qulkan/logger.h"
+#include "qulkan/profiler.h"
+#include "utils/stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+#include <glm/gtc/type_ptr.hpp>
+
+namespace {
+    // A 4k RGBA image is uploaded over 4 frames
+    const std::size_t DEFAULT_UPLOAD_BUDGET = 8 * 1024 * 1024;
+
+    const GLenum FORMATS[4] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+    const GLint INTERNAL_FORMATS[4] = {GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
+    // Grey and grey alpha images are sampled as such rather than red and red green
+    const GLint SWIZZLES[4][4] = {{GL_RED, GL_RED, GL_RED, GL_ONE}, {GL_RED, GL_RED, GL_RED, GL_GREEN}, {GL_RED, GL_GREEN, GL_BLUE, GL_ONE},
+                                  {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA}};
+
+    std::string textureKey(std::string const &path, TextureParameters const &parameters) {
+        std::ostringstream key;
+        key << path << '|' << parameters.wrapS << ' ' << parameters.wrapT << ' ' << parameters.minFilter << ' ' << parameters.magFilter << ' '
+            << parameters.borderColor.x << ' ' << parameters.borderColor.y << ' ' << parameters.borderColor.z << ' ' << parameters.borderColor.w
+            << ' ' << parameters.mipmaps;
+        return key.str();
+    }
+} // namespace
+
+TextureStreamer::Image::~Image() {
+    if (pixels != nullptr)
+        stbi_image_free(pixels);
+}
+
+TextureStreamer::TextureStreamer() : placeholder(0), uploadBudget(DEFAULT_UPLOAD_BUDGET), nextSlot(0), stopWorkers(false), decoding(0) {}
+
+TextureStreamer::~TextureStreamer() {
+    // GL objects are released in shutdown(), the context is already gone at static destruction
+    stopWorkersAndJoin();
+}
+
+void TextureStreamer::startWorkers() {
+    // Decoding is bound by the memory and the disk, a few threads are enough and leave the others to the views
+    unsigned count = std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 2));
+    for (unsigned i = 0; i < count; ++i)
+        workers.emplace_back(&TextureStreamer::workerLoop, this);
+}
+
+void TextureStreamer::stopWorkersAndJoin() {
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        stopWorkers = true;
+    }
+    jobsCondition.notify_all();
+    for (std::thread &worker : workers)
+        if (worker.joinable())
+            worker.join();
+    workers.clear();
+    stopWorkers = false;
+}
+
+void TextureStreamer::workerLoop() {
+    QULKAN_PROFILE_THREAD("TextureStreamer");
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobsMutex);
+            jobsCondition.wait(lock, [this]() { return stopWorkers || !jobs.empty(); });
+            if (stopWorkers)
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        auto image = std::make_shared<Image>();
+        {
+            QULKAN_PROFILE_ZONE("TextureStreamer::decode");
+            image->pixels = stbi_load(job.path.c_str(), &image->width, &image->height, &image->channels, 0);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(decodedMutex);
+            decoded.push_back({job.handle, std::move(image)});
+            --decoding;
+        }
+        decodedCondition.notify_one();
+    }
+}
+
+TextureStreamer::Handle TextureStreamer::acquire(std::string const &path, TextureParameters const &parameters) {
+    std::string key = textureKey(path, parameters);
+    auto found = entriesByKey.find(key);
+    if (found != entriesByKey.end()) {
+        ++entries[found->second].references;
+        return found->second;
+    }
+
+    Handle handle;
+    if (!freeEntries.empty()) {
+        handle = freeEntries.back();
+        freeEntries.pop_back();
+    } else {
+        handle = Handle(entries.size());
+        entries.emplace_back();
+    }
+
+    Entry &entry = entries[handle];
+    entry.key = key;
+    entry.path = path;
+    entry.parameters = parameters;
+    entry.references = 1;
+    entry.state = DECODING;
+    entry.texture = 0;
+    entry.image.reset();
+    entry.uploadedRows = 0;
+    entriesByKey[key] = handle;
+
+    if (workers.empty())
+        startWorkers();
+    {
+        std::lock_guard<std::mutex> lock(decodedMutex);
+        ++decoding;
+    }
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        jobs.push_back({handle, path});
+    }
+    jobsCondition.notify_one();
+    return handle;
+}
+
+void TextureStreamer::release(Handle handle) {
+    // Views may release their textures after shutdown(), from their destructors
+    if (handle >= entries.size() || entries[handle].references <= 0)
+        return;
+    --entries[handle].references;
+}
+
+GLuint TextureStreamer::texture(Handle handle) {
+    if (handle < entries.size() && entries[handle].state == RESIDENT)
+        return entries[handle].texture;
+    return getPlaceholder();
+}
+
+bool TextureStreamer::isResident(Handle handle) const { return handle < entries.size() && entries[handle].state == RESIDENT; }
+
+bool TextureStreamer::isLoading(Handle handle) const {
+    return handle < entries.size() && (entries[handle].state == DECODING || entries[handle].state == DECODED);
+}
+
+GLuint TextureStreamer::getPlaceholder() {
+    if (placeholder == 0) {
+        const unsigned char grey[4] = {128, 128, 128, 255};
+        glGenTextures(1, &placeholder);
+        glBindTexture(GL_TEXTURE_2D, placeholder);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    return placeholder;
+}
+
+std::size_t TextureStreamer::pending() const {
+    std::lock_guard<std::mutex> lock(decodedMutex);
+    return decoding + decoded.size() + uploads.size();
+}
+
+void TextureStreamer::collectDecoded(bool wait) {
+    std::deque<Decoded> results;
+    {
+        std::unique_lock<std::mutex> lock(decodedMutex);
+        if (wait)
+            decodedCondition.wait(lock, [this]() { return !decoded.empty() || decoding == 0; });
+        results.swap(decoded);
+    }
+
+    // Entries are not freed while decoding, the handle is still the one of the job
+    for (Decoded &result : results) {
+        Entry &entry = entries[result.handle];
+        if (result.image->pixels == nullptr || result.image->channels < 1 || result.image->channels > 4) {
+            // stbi_failure_reason() is shared by the workers, it may tell about another image
+            Qulkan::Logger::Error("TextureStreamer: Could not load %s\n", entry.path.c_str());
+            entry.state = FAILED;
+            continue;
+        }
+        entry.image = std::move(result.image);
+        entry.state = DECODED;
+        uploads.push_back(result.handle);
+    }
+}
+
+void TextureStreamer::deleteReleased() {
+    for (Handle handle = 0; handle < entries.size(); ++handle) {
+        Entry &entry = entries[handle];
+        if (entry.key.empty() || entry.references > 0 || entry.state == DECODING)
+            continue;
+
+        if (entry.texture != 0)
+            glDeleteTextures(1, &entry.texture);
+        entry.texture = 0;
+        entry.image.reset();
+        uploads.erase(std::remove(uploads.begin(), uploads.end(), handle), uploads.end());
+        entriesByKey.erase(entry.key);
+        entry.key.clear();
+        freeEntries.push_back(handle);
+    }
+}
+
+bool TextureStreamer::upload(Entry &entry, std::size_t &budget, bool wait) {
+    Image const &image = *entry.image;
+    GLenum format = FORMATS[image.channels - 1];
+    std::size_t rowBytes = std::size_t(image.width) * image.channels;
+
+    // At least one row per frame, however small the budget
+    std::size_t rows = budget / rowBytes;
+    if (rows == 0 && budget == uploadBudget)
+        rows = 1;
+    rows = std::min(rows, std::size_t(image.height - entry.uploadedRows));
+    if (rows == 0)
+        return false;
+
+    Slot &slot = ring[nextSlot];
+    if (slot.fence != nullptr) {
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? GLuint64(1000000000) : 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+            return false;
+        if (status == GL_WAIT_FAILED)
+            Qulkan::Logger::Error("TextureStreamer: Waiting on the upload fence failed\n");
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+    nextSlot = (nextSlot + 1) % RING_SIZE;
+
+    // Storage is allocated with the first rows, while no unpack buffer is bound
+    if (entry.texture == 0) {
+        TextureParameters const &parameters = entry.parameters;
+        glGenTextures(1, &entry.texture);
+        glBindTexture(GL_TEXTURE_2D, entry.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, parameters.wrapS);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, parameters.wrapT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, parameters.minFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, parameters.magFilter);
+        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, glm::value_ptr(parameters.borderColor));
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, SWIZZLES[image.channels - 1]);
+        glTexImage2D(GL_TEXTURE_2D, 0, INTERNAL_FORMATS[image.channels - 1], image.width, image.height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+    } else
+        glBindTexture(GL_TEXTURE_2D, entry.texture);
+
+    GLsizeiptr bytes = GLsizeiptr(rows * rowBytes);
+    if (slot.pbo == 0)
+        glGenBuffers(1, &slot.pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+    if (slot.capacity < bytes) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        slot.capacity = bytes;
+    }
+
+    // The fence of the slot has signalled, the previous copy out of the buffer is done
+    void *data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (data == nullptr) {
+        Qulkan::Logger::Error("TextureStreamer: Could not map the upload buffer of %s\n", entry.path.c_str());
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        entry.state = FAILED;
+        entry.image.reset();
+        return true;
+    }
+    std::memcpy(data, image.pixels + std::size_t(entry.uploadedRows) * rowBytes, std::size_t(bytes));
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // Returns once the copy is recorded, the driver reads the buffer later
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, entry.uploadedRows, image.width, GLsizei(rows), format, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    entry.uploadedRows += int(rows);
+    budget -= std::min(budget, std::size_t(bytes));
+    if (entry.uploadedRows < image.height)
+        return false;
+
+    if (entry.parameters.mipmaps)
+        glGenerateMipmap(GL_TEXTURE_2D);
+    entry.state = RESIDENT;
+    entry.image.reset();
+    return true;
+}
+
+void TextureStreamer::update() {
+    QULKAN_PROFILE_ZONE("TextureStreamer::update");
+
+    collectDecoded(false);
+    deleteReleased();
+    if (uploads.empty())
+        return;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    std::size_t budget = uploadBudget;
+    while (!uploads.empty() && upload(entries[uploads.front()], budget, false))
+        uploads.pop_front();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TextureStreamer::finish() {
+    QULKAN_PROFILE_ZONE("TextureStreamer::finish");
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (;;) {
+        collectDecoded(uploads.empty());
+        deleteReleased();
+        if (pending() == 0)
+            break;
+
+        // Whole images at once, waiting on the ring when it is full
+        while (!uploads.empty()) {
+            std::size_t budget = std::numeric_limits<std::size_t>::max();
+            if (upload(entries[uploads.front()], budget, true))
+                uploads.pop_front();
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TextureStreamer::shutdown() {
+    // The queued decodes are dropped, the ones in progress finish
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        std::lock_guard<std::mutex> decodedLock(decodedMutex);
+        decoding -= jobs.size();
+        jobs.clear();
+    }
+    stopWorkersAndJoin();
+
+    for (Entry &entry : entries)
+        if (entry.texture != 0)
+            glDeleteTextures(1, &entry.texture);
+    entries.clear();
+    freeEntries.clear();
+    entriesByKey.clear();
+    uploads.clear();
+    decoded.clear();
+    decoding = 0;
+
+    for (Slot &slot : ring) {
+        if (slot.fence != nullptr)
+            glDeleteSync(slot.fence);
+        if (slot.pbo != 0)
+            glDeleteBuffers(1, &slot.pbo);
+        slot = Slot();
+    }
+    nextSlot = 0;
+
+    if (placeholder != 0)
+        glDeleteTextures(1, &placeholder);
+    placeholder = 0;
+}
@@ -0,0 +1,230 @@
+#include "framework/scenegraph.h"
+#include "qulkan/logger.h"
+#include "qulkan/profiler.h"
+
+#include <algorithm>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SCENEGRAPH_AVX 1
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SCENEGRAPH_SSE 1
+#endif
+
+namespace {
+    // Levels with fewer dirty nodes are not worth the threads
+    const std::size_t PARALLEL_THRESHOLD = 4096;
+
+    /* result = a * b for column major 4x4 matrices, result doesn't alias b */
+    inline void multiply(float const *a, float const *b, float *result) {
+#if defined(SCENEGRAPH_AVX)
+        // Two columns of the result at once, each half of the registers holds one column
+        __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(a));
+        __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(a + 4));
+        __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(a + 8));
+        __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(a + 12));
+        for (int column = 0; column < 4; column += 2) {
+            __m256 columns = _mm256_loadu_ps(b + 4 * column);
+            __m256 sum = _mm256_mul_ps(a0, _mm256_shuffle_ps(columns, columns, 0x00));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(a1, _mm256_shuffle_ps(columns, columns, 0x55)));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(a2, _mm256_shuffle_ps(columns, columns, 0xAA)));
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(a3, _mm256_shuffle_ps(columns, columns, 0xFF)));
+            _mm256_storeu_ps(result + 4 * column, sum);
+        }
+#elif defined(SCENEGRAPH_SSE)
+        __m128 a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a + 4), a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+        for (int column = 0; column < 4; ++column) {
+            float const *c = b + 4 * column;
+            __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(c[0]));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(c[1])));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(c[2])));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(c[3])));
+            _mm_storeu_ps(result + 4 * column, sum);
+        }
+#else
+        for (int column = 0; column < 4; ++column)
+            for (int row = 0; row < 4; ++row)
+                result[4 * column + row] =
+                    a[row] * b[4 * column] + a[4 + row] * b[4 * column + 1] + a[8 + row] * b[4 * column + 2] + a[12 + row] * b[4 * column + 3];
+#endif
+    }
+
+    /* Inverse transpose of the upper 3x3, from the cross products of its columns (the cofactors) */
+    inline glm::mat3 normalMatrix(glm::mat4 const &world) {
+        glm::vec3 c0 = glm::vec3(world[0]), c1 = glm::vec3(world[1]), c2 = glm::vec3(world[2]);
+        glm::vec3 cofactor0 = glm::cross(c1, c2), cofactor1 = glm::cross(c2, c0), cofactor2 = glm::cross(c0, c1);
+        float determinant = glm::dot(c0, cofactor0);
+        // A degenerate scale, the normals of the node don't matter
+        float inverse = determinant != 0.0f ? 1.0f / determinant : 0.0f;
+        return glm::mat3(cofactor0 * inverse, cofactor1 * inverse, cofactor2 * inverse);
+    }
+} // namespace
+
+SceneGraph::SceneGraph() : reorder(false), updatedCount(0) { levels.push_back(0); }
+
+void SceneGraph::clear() {
+    locals.clear();
+    worlds.clear();
+    normals.clear();
+    parents.clear();
+    depths.clear();
+    dirty.clear();
+    removed.clear();
+    nodes.clear();
+    indices.clear();
+    freeNodes.clear();
+    levels.assign(1, 0);
+    reorder = false;
+    updatedCount = 0;
+}
+
+SceneGraph::Node SceneGraph::create(Node parent, glm::mat4 const &local) {
+    std::uint32_t parentIndex = NONE;
+    if (parent != NONE) {
+        if (parent >= indices.size() || indices[parent] == NONE) {
+            Qulkan::Logger::Error("SceneGraph: Node %u has no parent %u, created as a root\n", unsigned(indices.size()), unsigned(parent));
+        } else
+            parentIndex = indices[parent];
+    }
+
+    Node node;
+    if (!freeNodes.empty()) {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    } else {
+        node = Node(indices.size());
+        indices.push_back(NONE);
+    }
+
+    // Appended after its parent, sorted by depth by the next update()
+    indices[node] = std::uint32_t(nodes.size());
+    locals.push_back(local);
+    worlds.push_back(local);
+    normals.push_back(glm::mat3(1.0f));
+    parents.push_back(parentIndex);
+    depths.push_back(parentIndex == NONE ? 0 : depths[parentIndex] + 1);
+    dirty.push_back(1);
+    removed.push_back(0);
+    nodes.push_back(node);
+    reorder = true;
+    return node;
+}
+
+void SceneGraph::remove(Node node) {
+    if (node >= indices.size() || indices[node] == NONE)
+        return;
+    // The descendants follow once the arrays are sorted again
+    removed[indices[node]] = 1;
+    reorder = true;
+}
+
+void SceneGraph::setLocal(Node node, glm::mat4 const &local) {
+    std::uint32_t index = indices[node];
+    locals[index] = local;
+    dirty[index] = 1;
+}
+
+SceneGraph::Node SceneGraph::getParent(Node node) const {
+    std::uint32_t parent = parents[indices[node]];
+    return parent == NONE ? NONE : nodes[parent];
+}
+
+/* Stable counting sort of the nodes by depth, which drops the removed nodes and their descendants */
+void SceneGraph::sortByDepth() {
+    QULKAN_PROFILE_ZONE("SceneGraph::sortByDepth");
+
+    // Parents always come before their children, in the sorted arrays as well as after the appended nodes
+    std::size_t count = nodes.size();
+    std::uint32_t maxDepth = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (parents[i] != NONE && removed[parents[i]])
+            removed[i] = 1;
+        if (!removed[i])
+            maxDepth = std::max(maxDepth, depths[i]);
+    }
+
+    levels.assign(maxDepth + 2, 0);
+    for (std::size_t i = 0; i < count; ++i)
+        if (!removed[i])
+            ++levels[depths[i] + 1];
+    for (std::size_t depth = 1; depth < levels.size(); ++depth)
+        levels[depth] += levels[depth - 1];
+
+    std::vector<std::uint32_t> order(count, NONE); // New index of each index
+    std::vector<std::size_t> next(levels.begin(), levels.end() - 1);
+    for (std::size_t i = 0; i < count; ++i)
+        if (!removed[i])
+            order[i] = std::uint32_t(next[depths[i]]++);
+
+    std::size_t kept = levels.back();
+    std::vector<glm::mat4> sortedLocals(kept), sortedWorlds(kept);
+    std::vector<glm::mat3> sortedNormals(kept);
+    std::vector<std::uint32_t> sortedParents(kept), sortedDepths(kept);
+    std::vector<std::uint8_t> sortedDirty(kept);
+    std::vector<Node> sortedNodes(kept);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (removed[i]) {
+            indices[nodes[i]] = NONE;
+            freeNodes.push_back(nodes[i]);
+            continue;
+        }
+        std::uint32_t index = order[i];
+        sortedLocals[index] = locals[i];
+        sortedWorlds[index] = worlds[i];
+        sortedNormals[index] = normals[i];
+        sortedParents[index] = parents[i] == NONE ? NONE : order[parents[i]];
+        sortedDepths[index] = depths[i];
+        sortedDirty[index] = dirty[i];
+        sortedNodes[index] = nodes[i];
+        indices[nodes[i]] = index;
+    }
+
+    locals.swap(sortedLocals);
+    worlds.swap(sortedWorlds);
+    normals.swap(sortedNormals);
+    parents.swap(sortedParents);
+    depths.swap(sortedDepths);
+    dirty.swap(sortedDirty);
+    nodes.swap(sortedNodes);
+    removed.assign(kept, 0);
+    reorder = false;
+}
+
+void SceneGraph::update() {
+    QULKAN_PROFILE_ZONE("SceneGraph::update");
+
+    if (reorder)
+        sortByDepth();
+
+    updated.clear();
+    for (std::size_t level = 0; level + 1 < levels.size(); ++level) {
+        // The parents are one level up, their flags are final
+        std::size_t first = updated.size();
+        for (std::size_t i = levels[level]; i < levels[level + 1]; ++i) {
+            if (parents[i] != NONE && dirty[parents[i]])
+                dirty[i] = 1;
+            if (dirty[i])
+                updated.push_back(std::uint32_t(i));
+        }
+
+        // The nodes of a level only read the matrices of the levels above
+        int count = int(updated.size() - first);
+        std::uint32_t const *levelNodes = updated.data() + first;
+#pragma omp parallel for schedule(static) if (count >= int(PARALLEL_THRESHOLD))
+        for (int n = 0; n < count; ++n) {
+            std::uint32_t i = levelNodes[n];
+            if (parents[i] == NONE)
+                worlds[i] = locals[i];
+            else
+                multiply(glm::value_ptr(worlds[parents[i]]), glm::value_ptr(locals[i]), glm::value_ptr(worlds[i]));
+            normals[i] = normalMatrix(worlds[i]);
+        }
+    }
+
+    for (std::uint32_t i : updated)
+        dirty[i] = 0;
+    updatedCount = updated.size();
+}
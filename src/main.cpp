@@ -2,12 +2,15 @@
 #include <iostream>
 
 int main_opengl3();
+int main_headless(int argc, char* argv[]);
 #if defined(QULKAN_ENABLE_VULKAN)
 int main_vulkan();
 #endif
 
 int main(int argc, char* argv[]) {
-    if (argc == 2 && strcmp(argv[1], "--vulkan") == 0) {
+    if (argc >= 2 && strcmp(argv[1], "--headless") == 0) {
+        return main_headless(argc - 2, argv + 2);
+    } else if (argc == 2 && strcmp(argv[1], "--vulkan") == 0) {
         #if defined(QULKAN_ENABLE_VULKAN)
         std::cout << "Using Vulkan" << std::endl;
         return main_vulkan();
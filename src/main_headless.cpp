@@ -0,0 +1,354 @@
+// Headless batch mode: renders a selection of views offscreen at a fixed resolution and timestep, without any window or user interface.
+// Usage: Qulkan --headless [--views camera,materials] [--frames 100] [--warmup 10] [--width 1920] [--height 1080] [--fps 60]
+//                          [--output headless] [--save none|last|all] [--context egl|glfw] [--profile trace.json]
+#include <GL/gl3w.h>
+
+#include <GLFW/glfw3.h>
+
+#if defined(QULKAN_ENABLE_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+// Local includes
+#include "qulkan/framebufferpool.h"
+#include "qulkan/framecapture.h"
+#include "qulkan/logger.h"
+#include "qulkan/profiler.h"
+#include "qulkan/render_view.h"
+#include "qulkan/utils.h"
+
+// Basic Examples
+#include "examples/opengl/basic/camera.h"
+#include "examples/opengl/basic/coordinatesystems.h"
+#include "examples/opengl/basic/hellotriangle.h"
+#include "examples/opengl/basic/textures.h"
+#include "examples/opengl/basic/transformations.h"
+
+// Lighting Examples
+#include "examples/opengl/lighting/colors.h"
+#include "examples/opengl/lighting/materials.h"
+
+// Performance Examples
+#include "examples/opengl/performance/instancing.h"
+#include "examples/opengl/performance/multidraw.h"
+
+#include "framework/opengl/texturestreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct HeadlessSettings {
+        std::vector<std::string> views;
+        int frames = 100;
+        int warmup = 10;
+        int width = 1920;
+        int height = 1080;
+        int framesPerSecond = 60;
+        std::string output = "headless";
+        std::string save = "last";
+        std::string context = "egl";
+        std::string profile;
+    };
+
+    typedef std::function<std::unique_ptr<Qulkan::RenderView>(int, int)> ViewFactory;
+
+    const std::map<std::string, ViewFactory> &viewFactories() {
+        static const std::map<std::string, ViewFactory> factories = {
+            {"hellotriangle", [](int w, int h) { return std::make_unique<OpenGLExamples::HelloTriangle>("hellotriangle", w, h); }},
+            {"textures", [](int w, int h) { return std::make_unique<OpenGLExamples::Textures>("textures", w, h); }},
+            {"transformations", [](int w, int h) { return std::make_unique<OpenGLExamples::Transformations>("transformations", w, h); }},
+            {"coordinatesystems", [](int w, int h) { return std::make_unique<OpenGLExamples::CoordinateSystems>("coordinatesystems", w, h); }},
+            {"camera", [](int w, int h) { return std::make_unique<OpenGLExamples::Camera>("camera", w, h); }},
+            {"colors", [](int w, int h) { return std::make_unique<OpenGLExamples::Colors>("colors", w, h); }},
+            {"materials", [](int w, int h) { return std::make_unique<OpenGLExamples::Materials>("materials", w, h); }},
+            // Instancing stress test, one view per instance count to follow the scaling
+            {"instancing1k", [](int w, int h) { return std::make_unique<OpenGLExamples::Instancing>("instancing1k", w, h, 1000); }},
+            {"instancing10k", [](int w, int h) { return std::make_unique<OpenGLExamples::Instancing>("instancing10k", w, h, 10000); }},
+            {"instancing100k", [](int w, int h) { return std::make_unique<OpenGLExamples::Instancing>("instancing100k", w, h, 100000); }},
+            {"instancing1m", [](int w, int h) { return std::make_unique<OpenGLExamples::Instancing>("instancing1m", w, h, 1000000); }},
+            // Distinct meshes of a geometry arena, one multi-draw per material
+            {"multidraw4k", [](int w, int h) { return std::make_unique<OpenGLExamples::MultiDraw>("multidraw4k", w, h, 4096); }},
+            {"multidraw16k", [](int w, int h) { return std::make_unique<OpenGLExamples::MultiDraw>("multidraw16k", w, h, 16384); }},
+        };
+        return factories;
+    }
+
+    bool parseSettings(int argc, char *argv[], HeadlessSettings &settings) {
+        for (int i = 0; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Missing value for %s\n", arg.c_str());
+                return false;
+            }
+            std::string value = argv[++i];
+            if (arg == "--views") {
+                std::stringstream list(value);
+                std::string view;
+                while (std::getline(list, view, ','))
+                    settings.views.push_back(view);
+            } else if (arg == "--frames")
+                settings.frames = std::max(std::stoi(value), 1);
+            else if (arg == "--warmup")
+                settings.warmup = std::max(std::stoi(value), 0);
+            else if (arg == "--width")
+                settings.width = std::max(std::stoi(value), 1);
+            else if (arg == "--height")
+                settings.height = std::max(std::stoi(value), 1);
+            else if (arg == "--fps")
+                settings.framesPerSecond = std::max(std::stoi(value), 1);
+            else if (arg == "--output")
+                settings.output = value;
+            else if (arg == "--save")
+                settings.save = value;
+            else if (arg == "--context")
+                settings.context = value;
+            else if (arg == "--profile")
+                settings.profile = value;
+            else {
+                fprintf(stderr, "Unknown option %s\n", arg.c_str());
+                return false;
+            }
+        }
+        if (settings.views.empty())
+            for (auto &factory : viewFactories())
+                settings.views.push_back(factory.first);
+        return true;
+    }
+
+    /* Offscreen OpenGL 3.3 core context, EGL surfaceless when available or an invisible GLFW window */
+    class HeadlessContext {
+      private:
+        GLFWwindow *window = nullptr;
+#if defined(QULKAN_ENABLE_EGL)
+        EGLDisplay display = EGL_NO_DISPLAY;
+        EGLContext context = EGL_NO_CONTEXT;
+#endif
+
+      public:
+        ~HeadlessContext() {
+#if defined(QULKAN_ENABLE_EGL)
+            if (display != EGL_NO_DISPLAY) {
+                eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+                if (context != EGL_NO_CONTEXT)
+                    eglDestroyContext(display, context);
+                eglTerminate(display);
+            }
+#endif
+            if (window != nullptr) {
+                glfwDestroyWindow(window);
+                glfwTerminate();
+            }
+        }
+
+        bool create(const std::string &api) {
+#if defined(QULKAN_ENABLE_EGL)
+            if (api == "egl") {
+                if (createEGL())
+                    return true;
+                Qulkan::Logger::Warning("Headless: EGL surfaceless context unavailable, falling back to an invisible GLFW window\n");
+            }
+#endif
+            return createGLFW();
+        }
+
+      private:
+#if defined(QULKAN_ENABLE_EGL)
+        bool createEGL() {
+            const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+            PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+            if (clientExtensions != nullptr && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != nullptr && getPlatformDisplay != nullptr)
+                display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            else
+                display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+            EGLint major, minor;
+            if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+                return false;
+
+            const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+            if (extensions == nullptr || strstr(extensions, "EGL_KHR_surfaceless_context") == nullptr || !eglBindAPI(EGL_OPENGL_API))
+                return false;
+
+            const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+            EGLConfig config = nullptr;
+            EGLint configCount = 0;
+            eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+
+            const EGLint contextAttributes[] = {EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3, EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                                EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE};
+            context = eglCreateContext(display, configCount > 0 ? config : nullptr, EGL_NO_CONTEXT, contextAttributes);
+            if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+                return false;
+
+            if (gl3wInit2((GL3WGetProcAddressProc)eglGetProcAddress) != 0)
+                return false;
+
+            Qulkan::Logger::Info("Headless: EGL %d.%d surfaceless context\n", major, minor);
+            return true;
+        }
+#endif
+
+        bool createGLFW() {
+            if (!glfwInit())
+                return false;
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+            glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+            window = glfwCreateWindow(1, 1, "Qulkan", NULL, NULL);
+            if (window == nullptr)
+                return false;
+            glfwMakeContextCurrent(window);
+            if (gl3wInit() != 0)
+                return false;
+            Qulkan::Logger::Info("Headless: Invisible GLFW context\n");
+            return true;
+        }
+    };
+
+    struct ViewTimings {
+        std::vector<double> cpu; // time spent in render() on the CPU, in ms
+        std::vector<double> frame; // time until the GPU finished the frame, in ms
+        std::vector<double> gpu;   // GPU time of render() measured with GL_TIME_ELAPSED, in ms
+    };
+
+} // namespace
+
+int main_headless(int argc, char *argv[]) {
+    Qulkan::Logger::SetConsoleOutput(true);
+
+    HeadlessSettings settings;
+    if (!parseSettings(argc, argv, settings))
+        return 1;
+
+    QULKAN_PROFILE_THREAD("Main");
+    Qulkan::Profiler::setEnabled(!settings.profile.empty());
+
+    HeadlessContext context;
+    if (!context.create(settings.context)) {
+        fprintf(stderr, "Failed to create an OpenGL 3.3 core context\n");
+        return 1;
+    }
+    Qulkan::Logger::Info("Headless: %s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+    std::vector<std::unique_ptr<Qulkan::RenderView>> renderViews;
+    for (const std::string &name : settings.views) {
+        auto factory = viewFactories().find(name);
+        if (factory == viewFactories().end()) {
+            fprintf(stderr, "Unknown view %s\n", name.c_str());
+            return 1;
+        }
+        renderViews.push_back(factory->second(settings.width, settings.height));
+        QULKAN_PROFILE_ZONE_DETAIL("RenderView::submitPrograms", renderViews.back()->name());
+        renderViews.back()->submitPrograms();
+    }
+    for (auto &renderView : renderViews) {
+        QULKAN_PROFILE_ZONE_DETAIL("RenderView::init", renderView->name());
+        renderView->init();
+        if (!renderView->isInitialized())
+            return 1;
+    }
+    // Every frame is rendered with the final textures, none with their placeholders
+    TextureStreamer::Instance().finish();
+
+    std::error_code error;
+    std::filesystem::create_directories(settings.output, error);
+
+    // Deterministic animations, every frame advances the simulated time by the same step
+    Qulkan::setFixedDeltaTime(1.0f / float(settings.framesPerSecond));
+
+    typedef std::chrono::high_resolution_clock Clock;
+    std::vector<ViewTimings> timings(renderViews.size());
+    for (int frame = -settings.warmup; frame < settings.frames; ++frame) {
+        Qulkan::Profiler::Instance().newFrame();
+        QULKAN_PROFILE_ZONE("Frame");
+        Qulkan::updateDeltaTime(0.0f);
+
+        for (std::size_t v = 0; v < renderViews.size(); ++v) {
+            Qulkan::RenderView &renderView = *renderViews[v];
+
+            Clock::time_point start = Clock::now();
+            renderView.requestRedraw();
+            renderView.renderToTexture();
+            Clock::time_point submitted = Clock::now();
+            glFinish();
+            Clock::time_point finished = Clock::now();
+
+            if (frame < 0)
+                continue;
+            timings[v].cpu.push_back(std::chrono::duration<double, std::milli>(submitted - start).count());
+            timings[v].frame.push_back(std::chrono::duration<double, std::milli>(finished - start).count());
+
+            // The query is complete after glFinish
+            Qulkan::GPUTimer &gpuTimer = renderView.getGPUTimer();
+            gpuTimer.collect();
+            timings[v].gpu.push_back(gpuTimer.history().empty() ? 0.0 : gpuTimer.history().back().milliseconds);
+
+            if (settings.save == "all" || (settings.save == "last" && frame == settings.frames - 1)) {
+                char filename[1024];
+                snprintf(filename, sizeof(filename), "%s/%s_%05d.png", settings.output.c_str(), renderView.name(), frame);
+                Qulkan::FrameCapture &frameCapture = Qulkan::FrameCapture::Instance();
+                if (!frameCapture.available())
+                    frameCapture.waitOldest();
+                frameCapture.savePNG(renderView, filename);
+            }
+        }
+
+        TextureStreamer::Instance().update();
+        Qulkan::FrameCapture::Instance().update();
+        Qulkan::FramebufferPool::Instance().update();
+        Qulkan::updateFrameNumber();
+    }
+
+    // Timings, one row per view and frame, and a summary per view
+    std::string csvFilename = settings.output + "/timings.csv";
+    FILE *csv = fopen(csvFilename.c_str(), "w");
+    if (csv != nullptr)
+        fprintf(csv, "view,frame,cpu_ms,gpu_ms,frame_ms\n");
+    for (std::size_t v = 0; v < renderViews.size(); ++v) {
+        const ViewTimings &viewTimings = timings[v];
+        for (std::size_t f = 0; csv != nullptr && f < viewTimings.cpu.size(); ++f)
+            fprintf(csv, "%s,%zu,%.4f,%.4f,%.4f\n", renderViews[v]->name(), f, viewTimings.cpu[f], viewTimings.gpu[f], viewTimings.frame[f]);
+
+        double sum = 0.0, gpuSum = 0.0;
+        for (std::size_t f = 0; f < viewTimings.frame.size(); ++f) {
+            sum += viewTimings.frame[f];
+            gpuSum += viewTimings.gpu[f];
+        }
+        double average = sum / double(viewTimings.frame.size());
+        auto range = std::minmax_element(viewTimings.frame.begin(), viewTimings.frame.end());
+        Qulkan::Logger::Info("Headless: %s %dx%d, %d frames, avg %.3f ms (gpu %.3f ms), min %.3f ms, max %.3f ms, %.1f fps\n", renderViews[v]->name(),
+                             settings.width, settings.height, settings.frames, average, gpuSum / double(viewTimings.gpu.size()), *range.first, *range.second,
+                             1000.0 / average);
+    }
+    if (csv != nullptr) {
+        fclose(csv);
+        Qulkan::Logger::Info("Headless: Wrote timings to %s\n", csvFilename.c_str());
+    } else
+        Qulkan::Logger::Error("Headless: File %s could not be opened for writing\n", csvFilename.c_str());
+
+    Qulkan::FrameCapture::Instance().shutdown();
+    renderViews.clear();
+    TextureStreamer::Instance().shutdown();
+    Qulkan::FramebufferPool::Instance().shutdown();
+
+    if (!settings.profile.empty()) {
+        Qulkan::Profiler::Instance().newFrame();
+        Qulkan::Profiler::Instance().exportChromeTrace(settings.profile.c_str());
+    }
+
+    return 0;
+}
@@ -14,9 +14,14 @@
 #include <GLFW/glfw3.h>
 
 // Local includes
+#include "qulkan/framebufferpool.h"
+#include "qulkan/framecapture.h"
 #include "qulkan/inputshandler.h"
 #include "qulkan/logger.h"
+#include "qulkan/profiler.h"
+#include "qulkan/recorder.h"
 #include "qulkan/render_view.h"
+#include "qulkan/shaderwatcher.h"
 #include "qulkan/utils.h"
 #include "qulkan/windows.h"
 
@@ -30,12 +35,17 @@
 // Lighting Examples
 #include "examples/opengl/lighting/colors.h"
 #include "examples/opengl/lighting/materials.h"
+#include "examples/opengl/performance/instancing.h"
+#include "examples/opengl/performance/multidraw.h"
 
+#include "framework/opengl/compiler.h"
+#include "framework/opengl/texturestreamer.h"
 #include "utils/pngwriter.h"
 
 #include <algorithm>
 #include <functional>
 #include <iostream>
+#include <set>
 #include <stdio.h>
 #include <vector>
 
@@ -131,6 +141,8 @@ int main_opengl3() {
     // OpenGLExamples::Camera cameraExample = OpenGLExamples::Camera("OpenGL Example: Camera", 512, 512);
     // OpenGLExamples::Colors colorsExample = OpenGLExamples::Colors("OpenGL Example: Colors", 512, 512);
     OpenGLExamples::Materials materialsExample = OpenGLExamples::Materials("OpenGL Example: Materials", 1920, 1080);
+    // OpenGLExamples::Instancing instancingExample = OpenGLExamples::Instancing("OpenGL Example: Instancing", 1920, 1080, 100000);
+    // OpenGLExamples::MultiDraw multiDrawExample = OpenGLExamples::MultiDraw("OpenGL Example: MultiDraw", 1920, 1080, 4096);
 
     // renderViews.push_back(helloTriangleExample);
     // renderViews.push_back(textureExample);
@@ -139,24 +151,46 @@ int main_opengl3() {
     // renderViews.push_back(cameraExample);
     // renderViews.push_back(colorsExample);
     renderViews.push_back(materialsExample);
+    // renderViews.push_back(instancingExample);
+    // renderViews.push_back(multiDrawExample);
 
     // renderViews.push_back(&gtReflectionAniso);
     // renderViews.push_back(&gtReflectionAnisoTwoBounces);
     // renderViews.push_back(&approxReflectionAniso);
     // renderViews.push_back(&approxReflectionAnisoTwoBounces);
 
+    QULKAN_PROFILE_THREAD("Main");
+
     Qulkan::initViews(renderViews);
 
     // Main loop
     while (!glfwWindowShouldClose(window)) {
+        Qulkan::Profiler::Instance().newFrame();
+        QULKAN_PROFILE_ZONE("Frame");
+
         // Poll and handle events (inputs, window resize, etc.)
         // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
         // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
         // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
         // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
-        glfwPollEvents();
+        {
+            QULKAN_PROFILE_ZONE("glfwPollEvents");
+            glfwPollEvents();
+        }
         Qulkan::updateDeltaTime(glfwGetTime());
 
+        // Hot reload of the modified shader files, only the programs built from them are relinked
+        {
+            QULKAN_PROFILE_ZONE("ShaderWatcher::poll");
+            std::set<std::string> modifiedShaders = Qulkan::ShaderWatcher::Instance().poll();
+            if (!modifiedShaders.empty()) {
+                for (const std::string &file : modifiedShaders)
+                    Compiler::invalidateSource(file);
+                for (Qulkan::RenderView &renderView : renderViews)
+                    renderView.shaderFilesChanged(modifiedShaders);
+            }
+        }
+
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -171,6 +205,8 @@ int main_opengl3() {
         // Create Simple log window (see function for how to use it)
         Qulkan::Logger::Instance().Window();
 
+        Qulkan::Profiler::Instance().Window();
+
         // Close on escape
         if (noViewActive && ImGui::IsKeyPressed(GLFW_KEY_ESCAPE))
             glfwSetWindowShouldClose(window, true);
@@ -180,14 +216,31 @@ int main_opengl3() {
         if (show_demo_window)
             ImGui::ShowDemoWindow(&show_demo_window);
 
-        Qulkan::viewConfigurations(renderViews);
+        {
+            QULKAN_PROFILE_ZONE("viewConfigurations");
+            Qulkan::viewConfigurations(renderViews);
+        }
+
+        {
+            QULKAN_PROFILE_ZONE("Recorder::update");
+            Qulkan::Recorder::Instance().update();
+        }
 
-        Qulkan::renderWindows(renderViews);
+        {
+            QULKAN_PROFILE_ZONE("renderWindows");
+            Qulkan::renderWindows(renderViews);
+        }
 
-        Qulkan::handleInputs(renderViews);
+        {
+            QULKAN_PROFILE_ZONE("handleInputs");
+            Qulkan::handleInputs(renderViews);
+        }
 
         // Rendering
-        ImGui::Render();
+        {
+            QULKAN_PROFILE_ZONE("ImGui::Render");
+            ImGui::Render();
+        }
 
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
@@ -195,7 +248,10 @@ int main_opengl3() {
         glClearColor(clear_color.x, clear_color.y, clear_color.z, clear_color.w);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            QULKAN_PROFILE_ZONE("ImGui_ImplOpenGL3_RenderDrawData");
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
         // Update and Render additional Platform Windows
         // (Platform functions may change the current OpenGL context, so we save/restore it to make it easier to paste this code elsewhere.
@@ -207,11 +263,23 @@ int main_opengl3() {
         //     glfwMakeContextCurrent(backup_current_context);
         // }
 
-        glfwSwapBuffers(window);
+        {
+            QULKAN_PROFILE_ZONE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+        {
+            QULKAN_PROFILE_ZONE("FrameCapture::update");
+            Qulkan::FrameCapture::Instance().update();
+        }
+        TextureStreamer::Instance().update();
+        Qulkan::FramebufferPool::Instance().update();
         Qulkan::updateFrameNumber();
     }
 
     // Cleanup
+    Qulkan::FrameCapture::Instance().shutdown();
+    TextureStreamer::Instance().shutdown();
+    Qulkan::FramebufferPool::Instance().shutdown();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -0,0 +1,332 @@
+#include "qulkan/framebufferpool.h"
+
+#include <algorithm>
+
+#include "qulkan/logger.h"
+#include "qulkan/utils.h"
+
+namespace Qulkan {
+
+    namespace {
+        int sizeClass(int size) { return ((std::max(size, 1) + FramebufferPool::SIZE_CLASS - 1) / FramebufferPool::SIZE_CLASS) * FramebufferPool::SIZE_CLASS; }
+
+        // Pixel transfer format and type accepted by glTexImage2D for an internal format, nothing is uploaded
+        void transferFormat(GLenum internalFormat, GLenum &format, GLenum &type) {
+            switch (internalFormat) {
+            case GL_RGBA16F:
+                format = GL_RGBA;
+                type = GL_HALF_FLOAT;
+                break;
+            case GL_RGBA32F:
+                format = GL_RGBA;
+                type = GL_FLOAT;
+                break;
+            case GL_RGB16F:
+            case GL_R11F_G11F_B10F:
+                format = GL_RGB;
+                type = GL_FLOAT;
+                break;
+            case GL_RG16F:
+            case GL_RG32F:
+                format = GL_RG;
+                type = GL_FLOAT;
+                break;
+            case GL_R16F:
+            case GL_R32F:
+                format = GL_RED;
+                type = GL_FLOAT;
+                break;
+            case GL_RG8:
+                format = GL_RG;
+                type = GL_UNSIGNED_BYTE;
+                break;
+            case GL_R8:
+                format = GL_RED;
+                type = GL_UNSIGNED_BYTE;
+                break;
+            case GL_RGB10_A2:
+                format = GL_RGBA;
+                type = GL_UNSIGNED_INT_2_10_10_10_REV;
+                break;
+            case GL_DEPTH24_STENCIL8:
+                format = GL_DEPTH_STENCIL;
+                type = GL_UNSIGNED_INT_24_8;
+                break;
+            case GL_DEPTH32F_STENCIL8:
+                format = GL_DEPTH_STENCIL;
+                type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+                break;
+            case GL_DEPTH_COMPONENT16:
+            case GL_DEPTH_COMPONENT24:
+                format = GL_DEPTH_COMPONENT;
+                type = GL_UNSIGNED_INT;
+                break;
+            case GL_DEPTH_COMPONENT32F:
+                format = GL_DEPTH_COMPONENT;
+                type = GL_FLOAT;
+                break;
+            default:
+                format = GL_RGBA;
+                type = GL_UNSIGNED_BYTE;
+                break;
+            }
+        }
+
+        std::size_t bytesPerPixel(GLenum internalFormat) {
+            switch (internalFormat) {
+            case GL_R8:
+                return 1;
+            case GL_RG8:
+            case GL_R16F:
+            case GL_DEPTH_COMPONENT16:
+                return 2;
+            case GL_RGB16F:
+                return 6;
+            case GL_RGBA16F:
+            case GL_RG32F:
+            case GL_DEPTH32F_STENCIL8:
+                return 8;
+            case GL_RGBA32F:
+                return 16;
+            default:
+                return 4;
+            }
+        }
+
+        bool hasStencil(GLenum depthFormat) { return depthFormat == GL_DEPTH24_STENCIL8 || depthFormat == GL_DEPTH32F_STENCIL8; }
+
+        GLenum depthAttachment(GLenum depthFormat) { return hasStencil(depthFormat) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT; }
+
+        // Every color attachment is written by the fragment outputs 0..count-1
+        void setDrawBuffers(int colorCount) {
+            if (colorCount == 0) {
+                glDrawBuffer(GL_NONE);
+                glReadBuffer(GL_NONE);
+                return;
+            }
+            std::vector<GLenum> buffers(colorCount);
+            for (int i = 0; i < colorCount; ++i)
+                buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+            glDrawBuffers(colorCount, buffers.data());
+            glReadBuffer(GL_COLOR_ATTACHMENT0);
+        }
+
+        GLuint createTexture(GLenum internalFormat, int width, int height, GLint filter) {
+            GLenum format, type;
+            transferFormat(internalFormat, format, type);
+
+            GLuint texture;
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            return texture;
+        }
+
+        GLuint createRenderbuffer(GLenum internalFormat, int width, int height, int samples) {
+            GLuint renderbuffer;
+            glGenRenderbuffers(1, &renderbuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+            if (samples > 1)
+                glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, internalFormat, width, height);
+            else
+                glRenderbufferStorage(GL_RENDERBUFFER, internalFormat, width, height);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+            return renderbuffer;
+        }
+
+        bool checkComplete(int width, int height) {
+            GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+            if (status == GL_FRAMEBUFFER_COMPLETE)
+                return true;
+            Logger::Error("FramebufferPool: Framebuffer %d x %d is not complete (0x%x)\n", width, height, status);
+            return false;
+        }
+    } // namespace
+
+    void RenderTarget::resolve() const {
+        if (multisampleFramebuffer == 0)
+            return;
+        blitAttachments(multisampleFramebuffer, width, height, framebuffer, width, height, int(colors.size()), spec.depthTexture && depth != 0, GL_NEAREST);
+    }
+
+    void blitAttachments(GLuint readFramebuffer, int readWidth, int readHeight, GLuint drawFramebuffer, int drawWidth, int drawHeight, int colorCount,
+                         bool depth, GLenum filter) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+
+        // A blit copies the read buffer into every draw buffer, so one attachment at a time
+        for (int i = 0; i < colorCount; ++i) {
+            GLenum buffer = GL_COLOR_ATTACHMENT0 + i;
+            glReadBuffer(buffer);
+            glDrawBuffers(1, &buffer);
+            glBlitFramebuffer(0, 0, readWidth, readHeight, 0, 0, drawWidth, drawHeight, GL_COLOR_BUFFER_BIT, filter);
+        }
+        if (depth)
+            glBlitFramebuffer(0, 0, readWidth, readHeight, 0, 0, drawWidth, drawHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+        if (colorCount > 0) {
+            glReadBuffer(GL_COLOR_ATTACHMENT0);
+            glBindFramebuffer(GL_FRAMEBUFFER, drawFramebuffer);
+            setDrawBuffers(colorCount);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    int FramebufferPool::supportedSamples(int samples) {
+        static GLint maxSamples = 0;
+        if (maxSamples == 0)
+            glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+        return std::clamp(samples, 1, std::max(int(maxSamples), 1));
+    }
+
+    RenderTarget FramebufferPool::acquire(int width, int height, const AttachmentSpec &requested) {
+        int allocatedWidth = sizeClass(width);
+        int allocatedHeight = sizeClass(height);
+
+        AttachmentSpec spec = requested;
+        spec.samples = supportedSamples(spec.samples);
+        if (spec.depthFormat == GL_NONE)
+            spec.depthTexture = false;
+
+        RenderTarget target;
+        auto match = std::find_if(available.begin(), available.end(), [&](const Entry &entry) {
+            return entry.target.allocatedWidth == allocatedWidth && entry.target.allocatedHeight == allocatedHeight && entry.target.spec == spec;
+        });
+        if (match != available.end()) {
+            target = match->target;
+            available.erase(match);
+        } else {
+            target = create(allocatedWidth, allocatedHeight, spec);
+        }
+
+        target.width = width;
+        target.height = height;
+        return target;
+    }
+
+    void FramebufferPool::release(RenderTarget &target) {
+        if (!target.valid())
+            return;
+        if (!stopped)
+            retired.push_back({target, getFrameNumber()});
+        target = RenderTarget();
+    }
+
+    void FramebufferPool::update() {
+        uint64_t frame = getFrameNumber();
+
+        // Released during an earlier frame, no draw data refers to them anymore
+        for (auto it = retired.begin(); it != retired.end();) {
+            if (it->frame < frame) {
+                available.push_back(*it);
+                it = retired.erase(it);
+            } else
+                ++it;
+        }
+
+        for (auto it = available.begin(); it != available.end();) {
+            if (frame - it->frame > uint64_t(IDLE_FRAMES)) {
+                destroy(it->target);
+                it = available.erase(it);
+            } else
+                ++it;
+        }
+    }
+
+    void FramebufferPool::trim() {
+        for (Entry &entry : available)
+            destroy(entry.target);
+        available.clear();
+    }
+
+    void FramebufferPool::shutdown() {
+        trim();
+        for (Entry &entry : retired)
+            destroy(entry.target);
+        retired.clear();
+        stopped = true;
+    }
+
+    RenderTarget FramebufferPool::create(int allocatedWidth, int allocatedHeight, const AttachmentSpec &spec) {
+        RenderTarget target;
+        target.spec = spec;
+        target.allocatedWidth = allocatedWidth;
+        target.allocatedHeight = allocatedHeight;
+        int colorCount = int(spec.colorFormats.size());
+
+        // Textures sampled by ImGui and the views, the resolve destination of multisampled targets
+        glGenFramebuffers(1, &target.framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+        for (int i = 0; i < colorCount; ++i) {
+            target.colors.push_back(createTexture(spec.colorFormats[i], allocatedWidth, allocatedHeight, GL_LINEAR));
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, target.colors[i], 0);
+        }
+        if (spec.depthFormat != GL_NONE && spec.depthTexture) {
+            target.depth = createTexture(spec.depthFormat, allocatedWidth, allocatedHeight, GL_NEAREST);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, depthAttachment(spec.depthFormat), GL_TEXTURE_2D, target.depth, 0);
+        } else if (spec.depthFormat != GL_NONE && !spec.multisampled()) {
+            // Renderbuffer for depth/stencil operations, a multisampled target only needs it on the multisampled side
+            target.depth = createRenderbuffer(spec.depthFormat, allocatedWidth, allocatedHeight, 1);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, depthAttachment(spec.depthFormat), GL_RENDERBUFFER, target.depth);
+        }
+        setDrawBuffers(colorCount);
+        checkComplete(allocatedWidth, allocatedHeight);
+
+        if (spec.multisampled()) {
+            glGenFramebuffers(1, &target.multisampleFramebuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, target.multisampleFramebuffer);
+            for (int i = 0; i < colorCount; ++i) {
+                target.multisampleColors.push_back(createRenderbuffer(spec.colorFormats[i], allocatedWidth, allocatedHeight, spec.samples));
+                glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_RENDERBUFFER, target.multisampleColors[i]);
+            }
+            if (spec.depthFormat != GL_NONE) {
+                target.multisampleDepth = createRenderbuffer(spec.depthFormat, allocatedWidth, allocatedHeight, spec.samples);
+                glFramebufferRenderbuffer(GL_FRAMEBUFFER, depthAttachment(spec.depthFormat), GL_RENDERBUFFER, target.multisampleDepth);
+            }
+            setDrawBuffers(colorCount);
+            checkComplete(allocatedWidth, allocatedHeight);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        ++allocatedCount;
+        allocatedMemory += targetBytes(target);
+        return target;
+    }
+
+    void FramebufferPool::destroy(RenderTarget &target) {
+        glDeleteFramebuffers(1, &target.framebuffer);
+        glDeleteTextures(GLsizei(target.colors.size()), target.colors.data());
+        if (target.spec.depthTexture)
+            glDeleteTextures(1, &target.depth);
+        else
+            glDeleteRenderbuffers(1, &target.depth);
+
+        if (target.multisampleFramebuffer != 0) {
+            glDeleteFramebuffers(1, &target.multisampleFramebuffer);
+            glDeleteRenderbuffers(GLsizei(target.multisampleColors.size()), target.multisampleColors.data());
+            glDeleteRenderbuffers(1, &target.multisampleDepth);
+        }
+
+        --allocatedCount;
+        allocatedMemory -= targetBytes(target);
+        target = RenderTarget();
+    }
+
+    std::size_t FramebufferPool::targetBytes(const RenderTarget &target) {
+        const AttachmentSpec &spec = target.spec;
+        std::size_t samples = spec.multisampled() ? std::size_t(spec.samples) : 0;
+
+        std::size_t pixelBytes = 0;
+        for (GLenum format : spec.colorFormats)
+            pixelBytes += bytesPerPixel(format) * (1 + samples);
+        if (spec.depthFormat != GL_NONE)
+            pixelBytes += bytesPerPixel(spec.depthFormat) * (spec.depthTexture ? 1 + samples : std::max<std::size_t>(samples, 1));
+        return std::size_t(target.allocatedWidth) * std::size_t(target.allocatedHeight) * pixelBytes;
+    }
+
+} // namespace Qulkan
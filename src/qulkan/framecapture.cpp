@@ -0,0 +1,182 @@
+#include "qulkan/framecapture.h"
+
+#include <cstring>
+#include <memory>
+
+#include "qulkan/logger.h"
+#include "qulkan/profiler.h"
+#include "utils/pngwriter.h"
+
+namespace Qulkan {
+
+    FrameCapture::FrameCapture() : nextSlot(0), stopWorker(false) { worker = std::thread(&FrameCapture::workerLoop, this); }
+
+    FrameCapture::~FrameCapture() {
+        // GL objects are released in shutdown(), the context is already gone at static destruction
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            stopWorker = true;
+        }
+        jobsCondition.notify_one();
+        if (worker.joinable())
+            worker.join();
+    }
+
+    bool FrameCapture::capture(const RenderView &renderView, Callback callback) {
+        Slot &slot = ring[nextSlot];
+        if (slot.fence != nullptr) {
+            Logger::Warning("FrameCapture: %d captures already in flight, capture of %s skipped\n", RING_SIZE, renderView.name());
+            return false;
+        }
+        nextSlot = (nextSlot + 1) % RING_SIZE;
+
+        slot.width = renderView.width();
+        slot.height = renderView.height();
+        slot.callback = std::move(callback);
+
+        GLsizeiptr bytes = GLsizeiptr(slot.width) * slot.height * 4;
+        if (slot.pbo == 0)
+            glGenBuffers(1, &slot.pbo);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        if (slot.capacity < bytes) {
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+            slot.capacity = bytes;
+        }
+
+        // The copy is only recorded here, glReadPixels returns immediately when a pack buffer is bound
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, renderView.getRenderFramebuffer());
+        glReadBuffer(GL_COLOR_ATTACHMENT0 + renderView.getDisplayedAttachment());
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, slot.width, slot.height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        return true;
+    }
+
+    bool FrameCapture::savePNG(const RenderView &renderView, const std::string &filename) {
+        return capture(renderView, [this, filename](CapturedImage &&image) {
+            auto shared = std::make_shared<CapturedImage>(std::move(image));
+            enqueueJob([shared, filename]() {
+                QULKAN_PROFILE_ZONE("PNGWriter::writePNG");
+                PNGWriter pngWriter(shared->width, shared->height, shared->channels, shared->pixels.data());
+                pngWriter.writePNG(filename.c_str(), const_cast<char *>("framebufferImage"));
+            });
+        });
+    }
+
+    void FrameCapture::enqueueJob(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            jobs.push_back(std::move(job));
+        }
+        jobsCondition.notify_one();
+    }
+
+    void FrameCapture::update() {
+        // Oldest captures first so that callbacks are called in capture order
+        for (int i = 0; i < RING_SIZE; ++i) {
+            Slot &slot = ring[(nextSlot + i) % RING_SIZE];
+            if (slot.fence == nullptr)
+                continue;
+            GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            if (status == GL_TIMEOUT_EXPIRED)
+                break;
+            if (status == GL_WAIT_FAILED)
+                Logger::Error("FrameCapture: Waiting on the readback fence failed\n");
+            readback(slot);
+        }
+    }
+
+    int FrameCapture::pending() const {
+        int count = 0;
+        for (const Slot &slot : ring)
+            if (slot.fence != nullptr)
+                ++count;
+        return count;
+    }
+
+    bool FrameCapture::available() const { return ring[nextSlot].fence == nullptr; }
+
+    void FrameCapture::waitOldest() {
+        for (int i = 0; i < RING_SIZE; ++i) {
+            Slot &slot = ring[(nextSlot + i) % RING_SIZE];
+            if (slot.fence == nullptr)
+                continue;
+            if (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000)) == GL_WAIT_FAILED)
+                Logger::Error("FrameCapture: Waiting on the readback fence failed\n");
+            readback(slot);
+            return;
+        }
+    }
+
+    void FrameCapture::readback(Slot &slot) {
+        QULKAN_PROFILE_ZONE("FrameCapture::readback");
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        CapturedImage image;
+        image.width = slot.width;
+        image.height = slot.height;
+        image.channels = 4;
+        image.pixels.resize(std::size_t(slot.width) * slot.height * 4);
+
+        const GLsizeiptr bytes = GLsizeiptr(image.pixels.size());
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        void *data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+        if (data != nullptr) {
+            std::memcpy(image.pixels.data(), data, bytes);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        Callback callback = std::move(slot.callback);
+        slot.callback = nullptr;
+        if (data == nullptr)
+            Logger::Error("FrameCapture: Could not map the readback buffer\n");
+        else if (callback)
+            callback(std::move(image));
+    }
+
+    void FrameCapture::shutdown() {
+        for (int i = 0; i < RING_SIZE; ++i) {
+            Slot &slot = ring[(nextSlot + i) % RING_SIZE];
+            if (slot.fence != nullptr) {
+                glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+                readback(slot);
+            }
+            if (slot.pbo != 0)
+                glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+            slot.capacity = 0;
+        }
+
+        // Let the pending encodes finish
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            stopWorker = true;
+        }
+        jobsCondition.notify_one();
+        if (worker.joinable())
+            worker.join();
+    }
+
+    void FrameCapture::workerLoop() {
+        QULKAN_PROFILE_THREAD("FrameCapture");
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(jobsMutex);
+                jobsCondition.wait(lock, [this]() { return stopWorker || !jobs.empty(); });
+                if (jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+} // namespace Qulkan
@@ -0,0 +1,85 @@
+#include "qulkan/gputimer.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <GL/gl3w.h>
+
+#include "qulkan/utils.h"
+
+namespace Qulkan {
+
+    GPUTimer::GPUTimer() : nextQuery(0), oldestQuery(0), running(false), minMs(0.0f), averageMs(0.0f), maxMs(0.0f) {
+        queries.fill(0);
+        queryFrames.fill(0);
+        pending.fill(false);
+        windowMs.reserve(WINDOW_SIZE);
+    }
+
+    GPUTimer::~GPUTimer() {
+        if (queries[0] != 0)
+            glDeleteQueries(RING_SIZE, queries.data());
+    }
+
+    void GPUTimer::begin() {
+        if (queries[0] == 0)
+            glGenQueries(RING_SIZE, queries.data());
+
+        // Every query still in flight, skip this measurement rather than waiting for one
+        if (pending[nextQuery])
+            return;
+
+        glBeginQuery(GL_TIME_ELAPSED, queries[nextQuery]);
+        running = true;
+    }
+
+    void GPUTimer::end() {
+        if (!running)
+            return;
+        glEndQuery(GL_TIME_ELAPSED);
+        running = false;
+
+        pending[nextQuery] = true;
+        queryFrames[nextQuery] = getFrameNumber();
+        nextQuery = (nextQuery + 1) % RING_SIZE;
+    }
+
+    void GPUTimer::collect() {
+        // Queries complete in order, stop at the first one that is not available yet
+        while (pending[oldestQuery]) {
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(queries[oldestQuery], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available == GL_FALSE)
+                break;
+
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(queries[oldestQuery], GL_QUERY_RESULT, &nanoseconds);
+            addSample(queryFrames[oldestQuery], float(double(nanoseconds) * 1e-6));
+
+            pending[oldestQuery] = false;
+            oldestQuery = (oldestQuery + 1) % RING_SIZE;
+        }
+    }
+
+    void GPUTimer::addSample(uint64_t frame, float milliseconds) {
+        samples.push_back({frame, milliseconds});
+        if (samples.size() > HISTORY_SIZE)
+            samples.pop_front();
+
+        if (windowMs.size() == WINDOW_SIZE)
+            windowMs.erase(windowMs.begin());
+        windowMs.push_back(milliseconds);
+
+        auto range = std::minmax_element(windowMs.begin(), windowMs.end());
+        minMs = *range.first;
+        maxMs = *range.second;
+        averageMs = std::accumulate(windowMs.begin(), windowMs.end(), 0.0f) / float(windowMs.size());
+    }
+
+    void GPUTimer::reset() {
+        samples.clear();
+        windowMs.clear();
+        minMs = averageMs = maxMs = 0.0f;
+    }
+
+} // namespace Qulkan
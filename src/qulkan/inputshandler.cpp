@@ -17,11 +17,22 @@ namespace Qulkan {
                 renderView.setMousePos(renderView.getInRectPos() / renderRectSize); // set normalized coordinates
                 renderView.setMouseDelta(ImGui::GetMouseDragDelta());
                 renderView.setMouseWheel(io.MouseWheel);
+
+                // Held buttons keep driving the view (e.g. a camera rotating while dragging) even if the mouse does not move
+                for (int button = 0; button < IM_ARRAYSIZE(io.MouseDown); ++button)
+                    if (io.MouseDown[button])
+                        renderView.requestRedraw();
             } else {
                 renderView.setCaptureMouse(false);
             }
             if (renderView.isActive()) {
                 renderView.setCaptureKeyboard(true);
+
+                for (int key = 0; key < IM_ARRAYSIZE(io.KeysDown); ++key)
+                    if (io.KeysDown[key]) {
+                        renderView.requestRedraw();
+                        break;
+                    }
             } else {
                 renderView.setCaptureKeyboard(false);
             }
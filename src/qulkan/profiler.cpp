@@ -0,0 +1,277 @@
+#include "qulkan/profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+#include "imgui.h"
+#include "qulkan/logger.h"
+
+namespace Qulkan {
+
+    std::atomic<bool> Profiler::enabled(false);
+    std::atomic<bool> Profiler::destroyed(false);
+    thread_local Profiler::ThreadSlot Profiler::threadSlot;
+    thread_local uint32_t Profiler::zoneDepth = 0;
+
+    namespace {
+        const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+        void writeEscaped(FILE *fp, const char *text) {
+            for (; *text != '\0'; ++text) {
+                if (*text == '"' || *text == '\\')
+                    fputc('\\', fp);
+                fputc(*text, fp);
+            }
+        }
+
+        unsigned zoneColor(const char *name) {
+            static const unsigned palette[] = {IM_COL32(86, 140, 196, 255), IM_COL32(196, 120, 86, 255), IM_COL32(110, 170, 100, 255), IM_COL32(170, 110, 170, 255),
+                                               IM_COL32(200, 170, 80, 255), IM_COL32(90, 170, 170, 255),  IM_COL32(180, 90, 110, 255),  IM_COL32(130, 130, 200, 255)};
+            std::size_t hash = std::hash<std::string>()(name);
+            return palette[hash % IM_ARRAYSIZE(palette)];
+        }
+    } // namespace
+
+    Profiler::Profiler() : nextThreadId(0), paused(false), dropped(0) {}
+
+    Profiler::~Profiler() { destroyed = true; }
+
+    Profiler::ThreadSlot::~ThreadSlot() {
+        // Threads still running at static destruction may outlive the profiler
+        if (buffer != nullptr && !destroyed)
+            Instance().releaseThread(buffer);
+    }
+
+    uint64_t Profiler::now() { return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count()); }
+
+    Profiler::ThreadBuffer *Profiler::registerThread(const std::string &name) {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        std::unique_ptr<Event[]> ring;
+        if (!freeRings.empty()) {
+            ring = std::move(freeRings.back());
+            freeRings.pop_back();
+        } else
+            ring.reset(new Event[RING_SIZE]);
+        threads.push_back(std::make_unique<ThreadBuffer>(nextThreadId++, std::move(ring)));
+        threads.back()->name = name.empty() ? "Thread " + std::to_string(threads.back()->id) : name;
+        return threads.back().get();
+    }
+
+    void Profiler::releaseThread(ThreadBuffer *buffer) {
+        // The zones recorded since the last frame are drained by the next newFrame()
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        buffer->exited = true;
+        if (!isEnabled())
+            recycleExitedThreads();
+    }
+
+    void Profiler::recycleExitedThreads() {
+        // While disabled nothing is drained anymore, the zones left in the rings of the exited threads are dropped
+        bool disabled = !isEnabled();
+        for (std::size_t i = 0; i < threads.size();) {
+            ThreadBuffer &buffer = *threads[i];
+            if (!buffer.exited) {
+                ++i;
+                continue;
+            }
+            if (buffer.ring != nullptr && (disabled || buffer.tail == buffer.head.load(std::memory_order_acquire)))
+                freeRings.push_back(std::move(buffer.ring));
+            if (buffer.ring == nullptr && (disabled || buffer.history.empty()))
+                threads.erase(threads.begin() + i);
+            else
+                ++i;
+        }
+    }
+
+    void Profiler::setThreadName(const char *name) {
+        threadSlot.name = name;
+        if (threadSlot.buffer != nullptr) {
+            Profiler &profiler = Instance();
+            std::lock_guard<std::mutex> lock(profiler.threadsMutex);
+            threadSlot.buffer->name = name;
+        }
+    }
+
+    void Profiler::record(const char *name, const char *detail, uint64_t start, uint64_t end, uint32_t depth) {
+        ThreadBuffer *buffer = threadSlot.buffer;
+        if (buffer == nullptr)
+            buffer = threadSlot.buffer = Instance().registerThread(threadSlot.name);
+
+        uint64_t head = buffer->head.load(std::memory_order_relaxed);
+        buffer->ring[head & (RING_SIZE - 1)] = {name, detail, start, end, depth};
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    void Profiler::drain(ThreadBuffer &buffer) {
+        uint64_t head = buffer.head.load(std::memory_order_acquire);
+        if (head - buffer.tail > RING_SIZE) {
+            dropped += head - buffer.tail - RING_SIZE;
+            buffer.tail = head - RING_SIZE;
+        }
+        if (paused) {
+            buffer.tail = head;
+            return;
+        }
+
+        std::size_t first = buffer.history.size();
+        for (uint64_t i = buffer.tail; i < head; ++i)
+            buffer.history.push_back(buffer.ring[i & (RING_SIZE - 1)]);
+
+        // The owning thread may have lapped the copy, the oldest entries could be torn
+        uint64_t after = buffer.head.load(std::memory_order_acquire);
+        if (after - buffer.tail > RING_SIZE) {
+            uint64_t overwritten = std::min(after - buffer.tail - RING_SIZE, head - buffer.tail);
+            buffer.history.erase(buffer.history.begin() + first, buffer.history.begin() + first + overwritten);
+            dropped += overwritten;
+        }
+        buffer.tail = head;
+    }
+
+    void Profiler::newFrame() {
+        if (!isEnabled())
+            return;
+
+        if (!paused) {
+            frameStarts.push_back(now());
+            while (frameStarts.size() > HISTORY_FRAMES + 1)
+                frameStarts.pop_front();
+        }
+        if (frameStarts.empty())
+            return;
+
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        for (auto &buffer : threads) {
+            drain(*buffer);
+            while (!buffer->history.empty() && buffer->history.front().end < frameStarts.front())
+                buffer->history.pop_front();
+        }
+        recycleExitedThreads();
+    }
+
+    bool Profiler::exportChromeTrace(const char *filename) {
+        FILE *fp = fopen(filename, "w");
+        if (!fp) {
+            Logger::Error("Profiler: File %s could not be opened for writing\n", filename);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        bool first = true;
+        for (auto &buffer : threads) {
+            fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"", first ? "" : ",\n", buffer->id);
+            writeEscaped(fp, buffer->name.c_str());
+            fprintf(fp, "\"}}");
+            first = false;
+            for (const Event &event : buffer->history) {
+                fprintf(fp, ",\n{\"name\":\"");
+                writeEscaped(fp, event.name);
+                fprintf(fp, "\",\"cat\":\"qulkan\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u", double(event.start) * 1e-3,
+                        double(event.end - event.start) * 1e-3, buffer->id);
+                if (event.detail != nullptr) {
+                    fprintf(fp, ",\"args\":{\"detail\":\"");
+                    writeEscaped(fp, event.detail);
+                    fprintf(fp, "\"}");
+                }
+                fprintf(fp, "}");
+            }
+        }
+        fprintf(fp, "\n]}\n");
+        fclose(fp);
+
+        Logger::Info("Profiler: Wrote trace to %s\n", filename);
+        return true;
+    }
+
+    void Profiler::Window(bool *p_open) {
+        if (!ImGui::Begin("Profiler", p_open)) {
+            ImGui::End();
+            return;
+        }
+
+#if !defined(QULKAN_ENABLE_PROFILER)
+        ImGui::Text("Qulkan was compiled without QULKAN_ENABLE_PROFILER");
+#endif
+
+        bool enable = isEnabled();
+        if (ImGui::Checkbox("Enabled", &enable))
+            setEnabled(enable);
+        ImGui::SameLine();
+        ImGui::Checkbox("Paused", &paused);
+        ImGui::SameLine();
+        ImGui::Text("Dropped zones: %llu", (unsigned long long)dropped);
+
+        static char filename[512] = "trace.json";
+        ImGui::PushItemWidth(-140);
+        ImGui::InputText("Trace Path", filename, IM_ARRAYSIZE(filename));
+        ImGui::PopItemWidth();
+        if (ImGui::Button("Export Chrome Trace"))
+            exportChromeTrace(filename);
+
+        int frames = int(frameStarts.size()) - 1;
+        if (frames < 1) {
+            ImGui::End();
+            return;
+        }
+
+        // 0 is the last complete frame
+        static int frameOffset = 0;
+        frameOffset = std::min(frameOffset, frames - 1);
+        ImGui::PushItemWidth(-140);
+        ImGui::SliderInt("Frames ago", &frameOffset, 0, frames - 1);
+        ImGui::PopItemWidth();
+
+        uint64_t frameBegin = frameStarts[frames - 1 - frameOffset];
+        uint64_t frameEnd = frameStarts[frames - frameOffset];
+        double frameLength = double(frameEnd - frameBegin);
+        ImGui::Text("Frame: %.3f ms", frameLength * 1e-6);
+        ImGui::Separator();
+
+        const float rowHeight = 18.0f;
+        ImDrawList *drawList = ImGui::GetWindowDrawList();
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        for (auto &buffer : threads) {
+            ImGui::Text("%s", buffer->name.c_str());
+
+            uint32_t maxDepth = 0;
+            for (const Event &event : buffer->history)
+                if (event.end >= frameBegin && event.start <= frameEnd)
+                    maxDepth = std::max(maxDepth, event.depth + 1);
+
+            ImVec2 origin = ImGui::GetCursorScreenPos();
+            float width = ImGui::GetContentRegionAvail().x;
+            ImVec2 canvasEnd(origin.x + width, origin.y + rowHeight * std::max(maxDepth, 1u));
+            drawList->PushClipRect(origin, canvasEnd, true);
+
+            for (const Event &event : buffer->history) {
+                if (event.end < frameBegin || event.start > frameEnd)
+                    continue;
+                float x0 = origin.x + float((double(event.start) - double(frameBegin)) / frameLength) * width;
+                float x1 = origin.x + float((double(event.end) - double(frameBegin)) / frameLength) * width;
+                x1 = std::max(x1, x0 + 1.0f);
+                ImVec2 min(x0, origin.y + rowHeight * event.depth);
+                ImVec2 max(x1, min.y + rowHeight - 1.0f);
+                drawList->AddRectFilled(min, max, zoneColor(event.name));
+
+                const char *label = event.detail != nullptr ? event.detail : event.name;
+                if (ImGui::CalcTextSize(label).x < x1 - x0 - 4.0f)
+                    drawList->AddText(ImVec2(x0 + 2.0f, min.y + 2.0f), IM_COL32(255, 255, 255, 255), label);
+
+                if (ImGui::IsMouseHoveringRect(min, max)) {
+                    if (event.detail != nullptr)
+                        ImGui::SetTooltip("%s (%s)\n%.3f ms", event.name, event.detail, double(event.end - event.start) * 1e-6);
+                    else
+                        ImGui::SetTooltip("%s\n%.3f ms", event.name, double(event.end - event.start) * 1e-6);
+                }
+            }
+
+            drawList->PopClipRect();
+            ImGui::Dummy(ImVec2(width, canvasEnd.y - origin.y));
+        }
+
+        ImGui::End();
+    }
+
+} // namespace Qulkan
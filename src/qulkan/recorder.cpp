@@ -0,0 +1,249 @@
+#include "qulkan/recorder.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "qulkan/logger.h"
+#include "qulkan/profiler.h"
+#include "qulkan/utils.h"
+
+namespace Qulkan {
+
+    Recorder::Recorder()
+        : state(IDLE), recordedView(nullptr), viewWasContinuous(false), viewHadDynamicResolution(false), previousFixedDeltaTime(0.0f), captured(0), written(0), inFlight(0),
+          stopWorkers(false), stream(nullptr), streamWidth(0), streamHeight(0), nextStreamFrame(0) {}
+
+    Recorder::~Recorder() {
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            stopWorkers = true;
+        }
+        jobsCondition.notify_all();
+        for (std::thread &worker : workers)
+            if (worker.joinable())
+                worker.join();
+        if (stream != nullptr)
+            fclose(stream);
+    }
+
+    bool Recorder::start(RenderView &renderView, const Settings &recordSettings) {
+        if (state != IDLE) {
+            Logger::Warning("Recorder: A recording of %s is already running\n", recordedView->name());
+            return false;
+        }
+        if (!renderView.isInitialized()) {
+            Logger::Error("Recorder: %s is not initialized\n", renderView.name());
+            return false;
+        }
+
+        settings = recordSettings;
+        settings.frameCount = std::max(settings.frameCount, 1);
+        settings.framesPerSecond = std::max(settings.framesPerSecond, 1);
+        settings.workerCount = std::max(settings.workerCount, 1);
+        settings.queueCapacity = std::max(settings.queueCapacity, 1);
+
+        streamWidth = renderView.width();
+        streamHeight = renderView.height();
+        if (settings.format == Y4M) {
+            std::string filename = settings.output + ".y4m";
+            stream = fopen(filename.c_str(), "wb");
+            if (stream == nullptr) {
+                Logger::Error("Recorder: File %s could not be opened for writing\n", filename.c_str());
+                return false;
+            }
+            fprintf(stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", streamWidth, streamHeight, settings.framesPerSecond);
+        }
+
+        recordedView = &renderView;
+        captured = 0;
+        written = 0;
+        inFlight = 0;
+        encodedFrames.clear();
+        nextStreamFrame = 0;
+
+        // The view is rendered by update(), once per recorded frame
+        viewWasContinuous = renderView.isContinuousRendering();
+        renderView.setContinuousRendering(false);
+        // Every frame at full resolution
+        viewHadDynamicResolution = renderView.getDynamicResolution().enabled;
+        renderView.getDynamicResolution().enabled = false;
+        previousFixedDeltaTime = getFixedDeltaTime();
+        setFixedDeltaTime(1.0f / float(settings.framesPerSecond));
+
+        stopWorkers = false;
+        for (int i = 0; i < settings.workerCount; ++i)
+            workers.emplace_back(&Recorder::workerLoop, this);
+
+        state = RECORDING;
+        Logger::Info("Recorder: Recording %d frames of %s (%dx%d)\n", settings.frameCount, renderView.name(), streamWidth, streamHeight);
+        return true;
+    }
+
+    void Recorder::stop() {
+        if (state == RECORDING)
+            endCapture();
+    }
+
+    bool Recorder::isRecording() const { return state != IDLE; }
+
+    bool Recorder::isRecording(const RenderView &renderView) const { return state != IDLE && recordedView == &renderView; }
+
+    void Recorder::update() {
+        if (state == RECORDING) {
+            waitForSlot();
+
+            recordedView->requestRedraw();
+            recordedView->renderToTexture();
+
+            FrameCapture &frameCapture = FrameCapture::Instance();
+            if (!frameCapture.available())
+                frameCapture.waitOldest();
+
+            int frameIndex = captured++;
+            bool queued = frameCapture.capture(*recordedView, [this, frameIndex](CapturedImage &&image) {
+                auto shared = std::make_shared<CapturedImage>(std::move(image));
+                {
+                    std::lock_guard<std::mutex> lock(jobsMutex);
+                    jobs.push_back([this, frameIndex, shared]() { encode(frameIndex, *shared); });
+                }
+                jobsCondition.notify_one();
+            });
+            // Keeps the frame numbering and the stream order intact, the frame is dropped
+            if (!queued)
+                encode(frameIndex, CapturedImage());
+
+            if (captured == settings.frameCount)
+                endCapture();
+        }
+
+        if (state == FINISHING && written == captured)
+            finish();
+    }
+
+    void Recorder::waitForSlot() {
+        QULKAN_PROFILE_ZONE("Recorder::waitForSlot");
+        FrameCapture &frameCapture = FrameCapture::Instance();
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(inFlightMutex);
+                if (inFlight < settings.queueCapacity) {
+                    ++inFlight;
+                    return;
+                }
+            }
+            // Readbacks are handed to the encoders on this thread, drain them before blocking on the encoders
+            if (frameCapture.pending() > 0) {
+                frameCapture.waitOldest();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(inFlightMutex);
+            inFlightCondition.wait(lock, [this]() { return inFlight < settings.queueCapacity; });
+        }
+    }
+
+    void Recorder::releaseSlot() {
+        ++written;
+        {
+            std::lock_guard<std::mutex> lock(inFlightMutex);
+            --inFlight;
+        }
+        inFlightCondition.notify_one();
+    }
+
+    void Recorder::encode(int frameIndex, const CapturedImage &image) {
+        QULKAN_PROFILE_ZONE("Recorder::encode");
+        if (settings.format == PNG_SEQUENCE) {
+            char filename[1024];
+            snprintf(filename, sizeof(filename), "%s_%05d.png", settings.output.c_str(), frameIndex);
+            if (!image.pixels.empty()) {
+                PNGWriter pngWriter(image.width, image.height, image.channels, image.pixels.data(), settings.pngOptions);
+                pngWriter.writePNG(filename, nullptr);
+            }
+            releaseSlot();
+            return;
+        }
+
+        // Y4M: planar BT.601 studio range 4:4:4, top row first
+        std::vector<unsigned char> frame;
+        if (image.width == streamWidth && image.height == streamHeight) {
+            const char frameHeader[] = "FRAME\n";
+            const std::size_t headerSize = sizeof(frameHeader) - 1;
+            const std::size_t planeSize = std::size_t(image.width) * image.height;
+            frame.resize(headerSize + 3 * planeSize);
+            std::copy(frameHeader, frameHeader + headerSize, frame.begin());
+
+            unsigned char *yPlane = frame.data() + headerSize;
+            unsigned char *uPlane = yPlane + planeSize;
+            unsigned char *vPlane = uPlane + planeSize;
+            for (int y = 0; y < image.height; ++y) {
+                const unsigned char *src = image.pixels.data() + std::size_t(image.height - 1 - y) * image.width * image.channels;
+                const std::size_t row = std::size_t(y) * image.width;
+                for (int x = 0; x < image.width; ++x, src += image.channels) {
+                    int r = src[0], g = src[1], b = src[2];
+                    yPlane[row + x] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                    uPlane[row + x] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                    vPlane[row + x] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+                }
+            }
+        } else {
+            Logger::Error("Recorder: Frame %d is %dx%d, the stream is %dx%d, frame dropped\n", frameIndex, image.width, image.height, streamWidth, streamHeight);
+        }
+
+        // Write every frame that is next in line, dropped frames are kept empty to preserve the order
+        std::lock_guard<std::mutex> lock(streamMutex);
+        encodedFrames[frameIndex] = std::move(frame);
+        while (!encodedFrames.empty() && encodedFrames.begin()->first == nextStreamFrame) {
+            std::vector<unsigned char> &next = encodedFrames.begin()->second;
+            if (!next.empty() && fwrite(next.data(), 1, next.size(), stream) != next.size())
+                Logger::Error("Recorder: Could not write frame %d\n", nextStreamFrame);
+            encodedFrames.erase(encodedFrames.begin());
+            ++nextStreamFrame;
+            releaseSlot();
+        }
+    }
+
+    void Recorder::endCapture() {
+        state = FINISHING;
+        setFixedDeltaTime(previousFixedDeltaTime);
+        recordedView->setContinuousRendering(viewWasContinuous);
+        recordedView->getDynamicResolution().enabled = viewHadDynamicResolution;
+        recordedView->requestRedraw();
+    }
+
+    void Recorder::finish() {
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            stopWorkers = true;
+        }
+        jobsCondition.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+        workers.clear();
+
+        if (stream != nullptr) {
+            fclose(stream);
+            stream = nullptr;
+        }
+
+        Logger::Info("Recorder: Recorded %d frames of %s\n", captured, recordedView->name());
+        recordedView = nullptr;
+        state = IDLE;
+    }
+
+    void Recorder::workerLoop() {
+        QULKAN_PROFILE_THREAD("Recorder");
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(jobsMutex);
+                jobsCondition.wait(lock, [this]() { return stopWorkers || !jobs.empty(); });
+                if (jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+} // namespace Qulkan
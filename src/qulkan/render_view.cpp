@@ -1,7 +1,10 @@
 #include "qulkan/render_view.h"
 #include "imgui.h"
 #include "qulkan/logger.h"
+#include "qulkan/profiler.h"
 #include "qulkan/utils.h"
+#include <algorithm>
+#include <cmath>
 #include <memory>
 
 #include <GL/gl3w.h>
@@ -10,9 +13,11 @@
 namespace Qulkan {
 
     RenderView::RenderView(const char *viewName, int initialRenderWidth, int initialRenderHeight, ViewType viewType)
-        : m_id(Qulkan::getNextUniqueID()), m_isActive(false), screenMousePos(glm::vec2(0.5f, 0.5f)), actualRenderWidth(initialRenderWidth),
-          actualRenderHeight(initialRenderHeight), initialRenderWidth(initialRenderWidth), initialRenderHeight(initialRenderHeight), m_viewName(viewName),
-          initialized(false), error(false), preferenceManager(false, 0, 0, false), viewType(viewType) {
+        : m_viewName(viewName), m_id(Qulkan::getNextUniqueID()), m_isActive(false), captureKeyboard(false), captureMouse(false), viewType(viewType),
+          displayedAttachment(0), resizePending(false), pendingWidth(0), pendingHeight(0), actualRenderWidth(initialRenderWidth),
+          actualRenderHeight(initialRenderHeight), dirty(true), continuousRendering(false), programsSubmitted(false), renderScale(1.0f), renderedScale(1.0f),
+          lastTimedFrame(0), screenMousePos(glm::vec2(0.5f, 0.5f)), mouseDelta(glm::vec2(0.0f)), mouseWheel(0.0f), initialRenderWidth(initialRenderWidth),
+          initialRenderHeight(initialRenderHeight), preferenceManager(false, 0, 0, false), initialized(false), error(false) {
 
         if (viewType == ViewType::OPENGL) {
 
@@ -23,76 +28,223 @@ namespace Qulkan {
         }
     }
 
+    RenderView::~RenderView() {
+        FramebufferPool::Instance().release(renderTarget);
+        FramebufferPool::Instance().release(scaledTarget);
+    }
+
     void RenderView::recreateFramebuffer(int newRenderWidth, int newRenderHeight) {
 
         actualRenderWidth = newRenderWidth;
         actualRenderHeight = newRenderHeight;
+        resizePending = false;
+        dirty = true;
 
-        GLuint texture;
-
-        glGenTextures(1, &texture);
-
-        // Render texture
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, actualRenderWidth, actualRenderHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glBindTexture(GL_TEXTURE_2D, 0);
-
-        // Create framebuffer and attach color texture
-        glGenFramebuffers(1, &renderFramebuffer);
-        glBindFramebuffer(GL_FRAMEBUFFER, renderFramebuffer);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-
-        // Create a renderbuffer for depth/stencil operation and attach it to the framebuffer
-        GLuint rbo;
-        glGenRenderbuffers(1, &rbo);
-        glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, actualRenderWidth, actualRenderHeight);
-        glBindRenderbuffer(GL_RENDERBUFFER, 0);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
-
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-            error = true;
-            Qulkan::Logger::Error("FRAMEBUFFER:: Render Framebuffer is not complete!");
+        FramebufferPool::Instance().release(renderTarget);
+        renderTarget = FramebufferPool::Instance().acquire(actualRenderWidth, actualRenderHeight, attachmentSpec);
+    }
+
+    void RenderView::setAttachments(const AttachmentSpec &spec) {
+        if (spec == attachmentSpec)
+            return;
+        attachmentSpec = spec;
+        displayedAttachment = std::clamp(displayedAttachment, 0, std::max(int(spec.colorFormats.size()) - 1, 0));
+
+        if (viewType == ViewType::OPENGL) {
+            FramebufferPool::Instance().release(scaledTarget);
+            recreateFramebuffer(actualRenderWidth, actualRenderHeight);
         }
+    }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    const AttachmentSpec &RenderView::getAttachments() const { return attachmentSpec; }
+    const RenderTarget &RenderView::getRenderTarget() const { return renderTarget; }
 
-        renderViewTexture = (ImTextureID)(intptr_t)texture;
+    void RenderView::setDisplayedAttachment(int index) {
+        displayedAttachment = std::clamp(index, 0, std::max(int(renderTarget.colors.size()) - 1, 0));
     }
+    int RenderView::getDisplayedAttachment() const { return displayedAttachment; }
 
-    ImTextureID RenderView::renderToTexture() {
+    void RenderView::requestResize(int width, int height) {
+        if (width <= 0 || height <= 0)
+            return;
+
+        if (width == actualRenderWidth && height == actualRenderHeight) {
+            resizePending = false;
+            return;
+        }
+
+        if (!resizePending || width != pendingWidth || height != pendingHeight) {
+            resizePending = true;
+            pendingWidth = width;
+            pendingHeight = height;
+            pendingSince = std::chrono::steady_clock::now();
+        }
+    }
+
+    void RenderView::updateRenderScale() {
+        if (!dynamicResolution.enabled) {
+            renderScale = 1.0f;
+            frameScales.clear();
+            return;
+        }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, renderFramebuffer);
+        // Latest timing not used yet, with the scale it was rendered at
+        const std::deque<GPUTimer::Sample> &samples = gpuTimer.history();
+        if (samples.empty() || samples.back().frame == lastTimedFrame)
+            return;
+        const GPUTimer::Sample &sample = samples.back();
+        lastTimedFrame = sample.frame;
+
+        while (!frameScales.empty() && frameScales.front().first < sample.frame)
+            frameScales.pop_front();
+        if (frameScales.empty() || frameScales.front().first != sample.frame || sample.milliseconds <= 0.0f)
+            return;
+        float sampleScale = frameScales.front().second;
+
+        // GPU time is proportional to the pixel count, the square of the scale
+        float desired = sampleScale * std::sqrt(dynamicResolution.targetMs / sample.milliseconds);
+        desired = glm::clamp(desired, dynamicResolution.minScale, dynamicResolution.maxScale);
+
+        // Damped and quantized so the resolution doesn't oscillate around the budget
+        float scale = glm::mix(renderScale, desired, 0.5f);
+        scale = glm::clamp(std::round(scale * 32.0f) / 32.0f, dynamicResolution.minScale, dynamicResolution.maxScale);
+        if (std::abs(scale - renderScale) >= 1.0f / 32.0f)
+            renderScale = scale;
+    }
+
+    void RenderView::renderScaled(float scale) {
+        int width = actualRenderWidth;
+        int height = actualRenderHeight;
+        RenderTarget *target = &renderTarget;
+
+        if (scale < 1.0f) {
+            width = std::max(1, int(float(actualRenderWidth) * scale));
+            height = std::max(1, int(float(actualRenderHeight) * scale));
+            // The attachments are kept while the scaled size fits without wasting most of them
+            bool fits = width <= scaledTarget.allocatedWidth && height <= scaledTarget.allocatedHeight && 2 * width >= scaledTarget.allocatedWidth &&
+                        2 * height >= scaledTarget.allocatedHeight;
+            if (!scaledTarget.valid() || !fits) {
+                FramebufferPool::Instance().release(scaledTarget);
+                scaledTarget = FramebufferPool::Instance().acquire(width, height, attachmentSpec);
+            }
+            scaledTarget.width = width;
+            scaledTarget.height = height;
+            target = &scaledTarget;
+        } else if (scaledTarget.valid()) {
+            FramebufferPool::Instance().release(scaledTarget);
+        }
 
-        render(actualRenderWidth, actualRenderHeight);
+        glBindFramebuffer(GL_FRAMEBUFFER, target->drawFramebuffer());
+
+        {
+            QULKAN_PROFILE_ZONE_DETAIL("RenderView::render", m_viewName);
+            gpuTimer.begin();
+            render(width, height);
+            target->resolve();
+            gpuTimer.end();
+        }
+
+        if (dynamicResolution.enabled) {
+            frameScales.push_back(std::make_pair(getFrameNumber(), scale));
+            if (frameScales.size() > 16)
+                frameScales.pop_front();
+        }
+
+        // Upscale into the textures shown by the window
+        if (target != &renderTarget)
+            blitAttachments(scaledTarget.framebuffer, width, height, renderTarget.framebuffer, actualRenderWidth, actualRenderHeight, int(renderTarget.colors.size()),
+                            renderTarget.depthTexture() != 0, GL_LINEAR);
 
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        renderedScale = scale;
+    }
 
-        return renderViewTexture;
+    ImTextureID RenderView::renderToTexture() {
+
+        gpuTimer.collect();
+        updateRenderScale();
+
+        if (resizePending && std::chrono::steady_clock::now() - pendingSince >= std::chrono::milliseconds(RESIZE_SETTLE_MS) &&
+            !(ImGui::GetCurrentContext() != nullptr && ImGui::IsMouseDown(0)))
+            recreateFramebuffer(pendingWidth, pendingHeight);
+
+        if (!continuousRendering && !dirty) {
+            // Idle views keep showing their last rendered texture, refined to full resolution once they stop changing
+            if (renderedScale < 1.0f)
+                renderScaled(1.0f);
+            return getRenderViewTexture();
+        }
+
+        // Cleared before rendering so that a view can request another redraw from render()
+        dirty = false;
+
+        renderScaled(renderScale);
+
+        return getRenderViewTexture();
     };
 
+    void RenderView::requestRedraw() { dirty = true; }
+    bool RenderView::isDirty() const { return dirty; }
+
+    void RenderView::setContinuousRendering(bool continuous) { continuousRendering = continuous; }
+    bool RenderView::isContinuousRendering() const { return continuousRendering; }
+
     bool RenderView::isInitialized() const { return initialized; }
 
+    void RenderView::submitPrograms() {
+        if (programsSubmitted)
+            return;
+        createPrograms();
+        programsSubmitted = true;
+    }
+
+    void RenderView::initPrograms() {
+        submitPrograms();
+        programsSubmitted = false;
+        if (!checkPrograms())
+            error = true;
+    }
+
     void RenderView::recompileShaders() {
+        QULKAN_PROFILE_ZONE_DETAIL("RenderView::recompileShaders", m_viewName);
         Qulkan::Logger::Info("%s: Recompiling Shader \n", m_viewName);
-        initialized = false;
-        clean();
-        init();
-        recreateFramebuffer(actualRenderWidth, actualRenderHeight);
+        if (!initialized || !reloadShaders(std::set<std::string>())) {
+            initialized = false;
+            error = false;
+            clean();
+            init();
+        }
+        requestRedraw();
+    }
+
+    void RenderView::shaderFilesChanged(const std::set<std::string> &files) {
+        if (!initialized) {
+            // The view failed to initialize, probably because of its shaders
+            if (usesShaderFiles(files))
+                recompileShaders();
+            return;
+        }
+
+        QULKAN_PROFILE_ZONE_DETAIL("RenderView::reloadShaders", m_viewName);
+        if (reloadShaders(files))
+            requestRedraw();
     }
 
     HandleManager &RenderView::getHandleManager() { return handleManager; }
     PreferenceManager &RenderView::getPreferenceManager() { return preferenceManager; };
+    GPUTimer &RenderView::getGPUTimer() { return gpuTimer; };
+
+    DynamicResolution &RenderView::getDynamicResolution() { return dynamicResolution; }
+    float RenderView::getRenderScale() const { return renderScale; }
 
     int RenderView::width() const { return actualRenderWidth; }
     int RenderView::height() const { return actualRenderHeight; }
 
-    unsigned int RenderView::getRenderFramebuffer() const { return renderFramebuffer; }
-    ImTextureID RenderView::getRenderViewTexture() const { return renderViewTexture; }
+    unsigned int RenderView::getRenderFramebuffer() const { return renderTarget.framebuffer; }
+    ImTextureID RenderView::getRenderViewTexture() const { return (ImTextureID)(intptr_t)renderTarget.color(displayedAttachment); }
+    glm::vec2 RenderView::getRenderViewTextureExtent() const {
+        return glm::vec2(float(renderTarget.width) / float(renderTarget.allocatedWidth), float(renderTarget.height) / float(renderTarget.allocatedHeight));
+    }
 
     glm::vec2 RenderView::getInRectPos() const { return inRectPos; }
     void RenderView::setInRectPos(glm::vec2 pos) { inRectPos = pos; }
@@ -103,11 +255,23 @@ namespace Qulkan {
     glm::vec2 RenderView::getRectPosMax() const { return rectPosMax; }
     void RenderView::setRectPosMax(glm::vec2 size) { rectPosMax = size; }
 
-    void RenderView::setMousePos(glm::vec2 mousePos) { screenMousePos = mousePos; }
+    void RenderView::setMousePos(glm::vec2 mousePos) {
+        if (mousePos != screenMousePos)
+            dirty = true;
+        screenMousePos = mousePos;
+    }
     glm::vec2 RenderView::getMousePos() const { return screenMousePos; }
 
-    void RenderView::setMouseDelta(glm::vec2 _mouseDelta) { mouseDelta = _mouseDelta; }
-    void RenderView::setMouseWheel(float value) { mouseWheel = value; }
+    void RenderView::setMouseDelta(glm::vec2 _mouseDelta) {
+        if (_mouseDelta != mouseDelta)
+            dirty = true;
+        mouseDelta = _mouseDelta;
+    }
+    void RenderView::setMouseWheel(float value) {
+        if (value != mouseWheel)
+            dirty = true;
+        mouseWheel = value;
+    }
 
     void RenderView::setActive(bool active) { m_isActive = active; }
     bool RenderView::isActive() const { return m_isActive; }
@@ -0,0 +1,126 @@
+#include "qulkan/shaderwatcher.h"
+
+#include <system_error>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "qulkan/logger.h"
+
+namespace Qulkan {
+
+    namespace {
+        std::string normalizePath(const std::string &filename) { return std::filesystem::path(filename).lexically_normal().generic_string(); }
+    } // namespace
+
+    ShaderWatcher::ShaderWatcher() : enabled(true), inotifyFd(-1), lastPoll(clock::now()) {
+#if defined(__linux__)
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd == -1)
+            Logger::Warning("ShaderWatcher: inotify unavailable, polling the shader files instead\n");
+#endif
+    }
+
+    ShaderWatcher::~ShaderWatcher() {
+#if defined(__linux__)
+        if (inotifyFd != -1)
+            close(inotifyFd);
+#endif
+    }
+
+    void ShaderWatcher::watch(const std::string &filename) {
+        std::string path = normalizePath(filename);
+        if (files.find(path) != files.end())
+            return;
+
+        std::error_code error;
+        files[path] = std::filesystem::last_write_time(path, error);
+
+#if defined(__linux__)
+        if (inotifyFd == -1)
+            return;
+
+        std::string directory = std::filesystem::path(path).parent_path().generic_string();
+        if (directory.empty())
+            directory = ".";
+        for (auto &entry : directories)
+            if (entry.second == directory)
+                return;
+
+        int descriptor = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (descriptor == -1) {
+            Logger::Warning("ShaderWatcher: Could not watch %s\n", directory.c_str());
+            return;
+        }
+        directories[descriptor] = directory;
+#endif
+    }
+
+    void ShaderWatcher::readEvents() {
+#if defined(__linux__)
+        alignas(struct inotify_event) char buffer[4096];
+        for (;;) {
+            ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0)
+                return;
+
+            for (char *cursor = buffer; cursor < buffer + length;) {
+                const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(cursor);
+                cursor += sizeof(struct inotify_event) + event->len;
+
+                auto directory = directories.find(event->wd);
+                if (directory == directories.end() || event->len == 0)
+                    continue;
+
+                std::string path = normalizePath(directory->second + "/" + event->name);
+                if (files.find(path) != files.end())
+                    modified[path] = clock::now();
+            }
+        }
+#endif
+    }
+
+    void ShaderWatcher::pollTimes() {
+        clock::time_point now = clock::now();
+        if (now - lastPoll < std::chrono::milliseconds(POLL_INTERVAL_MS))
+            return;
+        lastPoll = now;
+
+        for (auto &file : files) {
+            std::error_code error;
+            std::filesystem::file_time_type time = std::filesystem::last_write_time(file.first, error);
+            if (!error && time != file.second) {
+                file.second = time;
+                modified[file.first] = now;
+            }
+        }
+    }
+
+    std::set<std::string> ShaderWatcher::poll() {
+        std::set<std::string> changed;
+        if (!enabled)
+            return changed;
+
+        if (inotifyFd != -1)
+            readEvents();
+        else
+            pollTimes();
+
+        clock::time_point now = clock::now();
+        for (auto it = modified.begin(); it != modified.end();) {
+            if (now - it->second < std::chrono::milliseconds(DEBOUNCE_MS)) {
+                ++it;
+                continue;
+            }
+            changed.insert(it->first);
+            it = modified.erase(it);
+        }
+
+        if (!changed.empty())
+            Logger::Info("ShaderWatcher: %d shader file(s) modified\n", int(changed.size()));
+        return changed;
+    }
+
+} // namespace Qulkan
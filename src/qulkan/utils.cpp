@@ -6,14 +6,20 @@ namespace Qulkan {
     uint64_t frameNumber = 0;
     float lastFrameTime = 0.0f;
     float deltaTime = 0.0f;
+    float simulatedTime = 0.0f;
+    float fixedDeltaTime = 0.0f;
 
     int getNextUniqueID() { return ++uniqueID; }
     void updateFrameNumber() { ++frameNumber; }
     void updateDeltaTime(float currentFrameTime) {
-        deltaTime = currentFrameTime - lastFrameTime;
+        deltaTime = fixedDeltaTime > 0.0f ? fixedDeltaTime : currentFrameTime - lastFrameTime;
         lastFrameTime = currentFrameTime;
+        simulatedTime += deltaTime;
     }
     uint64_t getFrameNumber() { return frameNumber; }
     float getDeltaTime() { return deltaTime; }
+    float getTime() { return simulatedTime; }
+    void setFixedDeltaTime(float dt) { fixedDeltaTime = dt; }
+    float getFixedDeltaTime() { return fixedDeltaTime; }
 
 } // namespace Qulkan
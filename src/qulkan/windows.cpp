@@ -4,9 +4,13 @@
 #include "imgui.h"
 #include "qulkan/handlemanager.h"
 #include "qulkan/logger.h"
+#include "qulkan/profiler.h"
 #include "qulkan/utils.h"
 
-#include "utils/pngwriter.h"
+#include "qulkan/framebufferpool.h"
+#include "qulkan/framecapture.h"
+#include "qulkan/recorder.h"
+#include "qulkan/shaderwatcher.h"
 
 #include <GL/gl3w.h>
 #include <GLFW/glfw3.h>
@@ -87,23 +91,26 @@ namespace Qulkan {
 
     /*! \brief Helper for creating the handles in the configuration view
      *
-     *
+     *  Returns true if any of the destination handles changed.
      */
-    void mirrorHandles(const HandleManager &srcHandler, const HandleManager &destHandler) {
+    bool mirrorHandles(const HandleManager &srcHandler, const HandleManager &destHandler) {
+        bool changed = false;
         for (auto const &srcHandle : srcHandler.getHandles()) {
             for (auto const &destHandle : destHandler.getHandles()) {
-                if (srcHandle->name == destHandle->name) {
-                    destHandle->value = srcHandle->value;
+                if (srcHandle->name == destHandle->name && srcHandle->type == destHandle->type) {
+                    changed = destHandle->copyValue(*srcHandle) || changed;
                 }
             }
         }
+        return changed;
     }
 
     /*! \brief Helper for creating the handles in the configuration view
      *
-     *
+     *  Returns true if any of the handles was edited.
      */
-    void handleParser(const HandleManager &handleManager) {
+    bool handleParser(const HandleManager &handleManager) {
+        bool edited = false;
         for (auto const &handle : handleManager.getHandles()) {
             if (handle->isActive()) {
                 bool hasActivator = handle->active != nullptr;
@@ -112,37 +119,38 @@ namespace Qulkan {
 
                 switch (handle->type) {
                 case Type::BOOL_HANDLE: {
-                    ImGui::Checkbox(handle->name.c_str(), std::any_cast<bool>(&handle->value));
-                    handle->invValue = !std::any_cast<bool>(handle->value);
+                    edited = ImGui::Checkbox(handle->name.c_str(), handle->valuePtr<bool>()) || edited;
+                    handle->invValue = !handle->getValue<bool>();
                     break;
                 }
                 case Type::INT_HANDLE: {
-                    ImGui::SliderInt(handle->name.c_str(), std::any_cast<int>(&handle->value), -10, 10, "%d");
+                    edited = ImGui::SliderInt(handle->name.c_str(), handle->valuePtr<int>(), -10, 10, "%d") || edited;
                     break;
                 }
                 case Type::FLOAT_HANDLE: {
 
-                    ImGui::SliderFloat(handle->name.c_str(), std::any_cast<float>(&handle->value), handle->getMinValues<float>(), handle->getMaxValues<float>(),
-                                       "%.4f");
+                    edited = ImGui::SliderFloat(handle->name.c_str(), handle->valuePtr<float>(), handle->getMinValues<float>(),
+                                                handle->getMaxValues<float>(), "%.4f") ||
+                             edited;
                     break;
                 }
                 case Type::VEC2_HANDLE: {
-                    auto val = std::any_cast<glm::vec2>(&handle->value);
+                    auto val = handle->valuePtr<glm::vec2>();
                     auto min = handle->getMinValues<glm::vec2>().x;
                     auto max = handle->getMaxValues<glm::vec2>().x;
-                    ImGui::SliderFloat2(handle->name.c_str(), (float *)val, min, max, "%.4f");
+                    edited = ImGui::SliderFloat2(handle->name.c_str(), (float *)val, min, max, "%.4f") || edited;
                     break;
                 }
                 case Type::VEC3_HANDLE: {
-                    auto val = std::any_cast<glm::vec3>(&handle->value);
+                    auto val = handle->valuePtr<glm::vec3>();
                     auto min = handle->getMinValues<glm::vec3>().x;
                     auto max = handle->getMaxValues<glm::vec3>().x;
-                    ImGui::SliderFloat3(handle->name.c_str(), (float *)val, min, max, "%.4f");
+                    edited = ImGui::SliderFloat3(handle->name.c_str(), (float *)val, min, max, "%.4f") || edited;
                     break;
                 }
                 case Type::COLOR3_HANDLE: {
-                    auto val = std::any_cast<glm::vec3>(&handle->value);
-                    ImGui::ColorEdit3(handle->name.c_str(), (float *)val);
+                    auto val = handle->valuePtr<glm::vec3>();
+                    edited = ImGui::ColorEdit3(handle->name.c_str(), (float *)val) || edited;
                     break;
                 }
                 case Type::TEXT_HANDLE: {
@@ -172,12 +180,40 @@ namespace Qulkan {
 
             ImGui::Unindent();
         }
+        return edited;
+    }
+
+    /*! \brief Writes the GPU time history of every view as CSV
+     *
+     *  One row per measurement : view, frame, gpu_ms
+     */
+    bool exportGPUTimings(std::vector<std::reference_wrapper<RenderView>> &renderViews, const char *filename) {
+        FILE *fp = fopen(filename, "w");
+        if (!fp) {
+            Logger::Error("File %s could not be opened for writing\n", filename);
+            return false;
+        }
+        fprintf(fp, "view,frame,gpu_ms\n");
+        for (RenderView &renderView : renderViews)
+            for (const GPUTimer::Sample &sample : renderView.getGPUTimer().history())
+                fprintf(fp, "\"%s\",%llu,%.4f\n", renderView.name(), (unsigned long long)sample.frame, sample.milliseconds);
+        fclose(fp);
+        Logger::Info("Wrote GPU timings to %s\n", filename);
+        return true;
     }
 
     /* Inits all render views */
     void initViews(std::vector<std::reference_wrapper<RenderView>> &renderViews) {
-        for (RenderView &renderView : renderViews)
+        // Every compile and link is issued before the first status query, drivers compiling in the background work on all of them at once
+        for (RenderView &renderView : renderViews) {
+            QULKAN_PROFILE_ZONE_DETAIL("RenderView::submitPrograms", renderView.name());
+            renderView.submitPrograms();
+        }
+
+        for (RenderView &renderView : renderViews) {
+            QULKAN_PROFILE_ZONE_DETAIL("RenderView::init", renderView.name());
             renderView.init();
+        }
     }
 
     /*! \brief Render the windows for the main view
@@ -213,12 +249,15 @@ namespace Qulkan {
             glm::vec2 endPosNoRatio = endPos;
 
             ImTextureID tex = renderView.renderToTexture();
+            glm::vec2 texExtent = renderView.getRenderViewTextureExtent();
+            ImVec2 uvMin(0.0f, texExtent.y);
+            ImVec2 uvMax(texExtent.x, 0.0f);
 
             float space = 0.0f;
 
             // Render texture to window
             if (!keepTextureRatio)
-                ImGui::GetWindowDrawList()->AddImage(tex, screenPos, endPos);
+                ImGui::GetWindowDrawList()->AddImage(tex, screenPos, endPos, uvMin, uvMax);
             else {
                 float hRatio = h * ratio;
                 float minSize;
@@ -243,13 +282,15 @@ namespace Qulkan {
                     endPos.y -= space;
                 }
 
-                ImGui::GetWindowDrawList()->AddImage(tex, screenPos, endPos, ImVec2(0, 1), ImVec2(1, 0));
+                ImGui::GetWindowDrawList()->AddImage(tex, screenPos, endPos, uvMin, uvMax);
             }
 
             // Setting button overlay position
             glm::vec2 currentViewportSize = (renderView.getRectPosMax() - renderView.getRectPosMin());
             bool fbResizeActive = currentViewportSize != glm::vec2(renderView.width(), renderView.height());
-            if (fbResizeActive) {
+            if (fbResizeActive && renderView.getPreferenceManager().followWindowSize) {
+                renderView.requestResize(int(currentViewportSize.x), int(currentViewportSize.y));
+            } else if (fbResizeActive) {
 
                 if (ImGui::Button("Reset Resolution")) {
                     renderView.recreateFramebuffer(currentViewportSize.x, currentViewportSize.y);
@@ -298,6 +339,14 @@ namespace Qulkan {
 
         ImGui::Begin("View Configurations");
 
+        static char timingsFilename[512] = "gpu_timings.csv";
+        ImGui::PushItemWidth(-140);
+        ImGui::InputText("Timings Path", timingsFilename, IM_ARRAYSIZE(timingsFilename));
+        ImGui::PopItemWidth();
+        if (ImGui::Button("Export GPU Timings"))
+            exportGPUTimings(renderViews, timingsFilename);
+        ImGui::Separator();
+
         //       src, dest
         std::map<int, int> newMousePos;
         std::map<int, int> copyHandles;
@@ -337,6 +386,9 @@ namespace Qulkan {
                     if (ImGui::Button("Recompile Shader")) {
                         renderView.recompileShaders();
                     }
+                    bool watchShaders = ShaderWatcher::Instance().isEnabled();
+                    if (ImGui::Checkbox("Reload on change", &watchShaders))
+                        ShaderWatcher::Instance().setEnabled(watchShaders);
                     ImGui::TreePop();
                 }
 
@@ -346,12 +398,7 @@ namespace Qulkan {
                     ImGui::PushItemWidth(-140);
                     ImGui::InputText("Filename Path", filename, IM_ARRAYSIZE(filename));
                     if (ImGui::Button("Save Framebuffer")) {
-                        float *pixels = new float[renderView.width() * renderView.height() * 4];
-                        glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)renderView.getRenderViewTexture());
-                        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, pixels);
-                        glBindTexture(GL_TEXTURE_2D, 0);
-                        PNGWriter pngWriter(renderView.width(), renderView.height(), 4, pixels);
-                        pngWriter.writePNG(filename, const_cast<char *>("framebufferImage"));
+                        FrameCapture::Instance().savePNG(renderView, filename);
                     }
                     ImGui::PopItemWidth();
                     ImGui::Indent();
@@ -359,6 +406,53 @@ namespace Qulkan {
                     ImGui::Unindent();
 
                     ImGui::Checkbox("Mouse position overlay", &renderView.getPreferenceManager().mouseOverlay);
+                    ImGui::Checkbox("Resize with the window", &renderView.getPreferenceManager().followWindowSize);
+                    ImGui::Text("Framebuffer pool: %d targets (%d idle), %.1f MB", FramebufferPool::Instance().allocatedTargets(),
+                                FramebufferPool::Instance().pooledTargets(), double(FramebufferPool::Instance().allocatedBytes()) / (1024.0 * 1024.0));
+
+                    // Format of the displayed attachment and multisampling, views needing a G-buffer set their attachments in code
+                    AttachmentSpec attachments = renderView.getAttachments();
+                    int displayed = renderView.getDisplayedAttachment();
+                    if (displayed < int(attachments.colorFormats.size())) {
+                        static const GLenum colorFormats[] = {GL_RGBA8, GL_RGBA16F, GL_R11F_G11F_B10F};
+                        static const char *colorFormatNames[] = {"RGBA8", "RGBA16F", "R11G11B10F"};
+                        static const int sampleCounts[] = {1, 2, 4, 8};
+                        static const char *sampleNames[] = {"Off", "2x", "4x", "8x"};
+
+                        int format = int(std::find(std::begin(colorFormats), std::end(colorFormats), attachments.colorFormats[displayed]) - std::begin(colorFormats));
+                        int samples = int(std::find(std::begin(sampleCounts), std::end(sampleCounts), attachments.samples) - std::begin(sampleCounts));
+                        ImGui::PushItemWidth(-140);
+                        if (attachments.colorFormats.size() > 1) {
+                            if (ImGui::SliderInt("Displayed attachment", &displayed, 0, int(attachments.colorFormats.size()) - 1))
+                                renderView.setDisplayedAttachment(displayed);
+                        }
+                        if (format < IM_ARRAYSIZE(colorFormats) && ImGui::Combo("Color format", &format, colorFormatNames, IM_ARRAYSIZE(colorFormatNames))) {
+                            attachments.colorFormats[displayed] = colorFormats[format];
+                            renderView.setAttachments(attachments);
+                        }
+                        if (samples < IM_ARRAYSIZE(sampleCounts) && ImGui::Combo("Multisampling", &samples, sampleNames, IM_ARRAYSIZE(sampleNames))) {
+                            attachments.samples = sampleCounts[samples];
+                            renderView.setAttachments(attachments);
+                        }
+                        ImGui::PopItemWidth();
+                    }
+
+                    bool continuousRendering = renderView.isContinuousRendering();
+                    if (ImGui::Checkbox("Continuous rendering", &continuousRendering))
+                        renderView.setContinuousRendering(continuousRendering);
+
+                    DynamicResolution &dynamicResolution = renderView.getDynamicResolution();
+                    ImGui::Checkbox("Dynamic resolution", &dynamicResolution.enabled);
+                    if (dynamicResolution.enabled) {
+                        ImGui::Indent();
+                        ImGui::PushItemWidth(-140);
+                        ImGui::SliderFloat("GPU budget (ms)", &dynamicResolution.targetMs, 1.0f, 100.0f, "%.1f");
+                        ImGui::SliderFloat("Minimum scale", &dynamicResolution.minScale, 0.1f, dynamicResolution.maxScale, "%.2f");
+                        ImGui::PopItemWidth();
+                        ImGui::Text("Render scale: %.2f (%d x %d)", renderView.getRenderScale(), int(renderView.width() * renderView.getRenderScale()),
+                                    int(renderView.height() * renderView.getRenderScale()));
+                        ImGui::Unindent();
+                    }
 
                     ImGui::PushItemWidth(-140);
 
@@ -376,15 +470,57 @@ namespace Qulkan {
                     ImGui::PopItemWidth();
                     ImGui::TreePop();
                 }
+                if (ImGui::TreeNode("GPU Timings")) {
+                    GPUTimer &gpuTimer = renderView.getGPUTimer();
+                    ImGui::Text("min %.3f ms  avg %.3f ms  max %.3f ms", gpuTimer.minimum(), gpuTimer.average(), gpuTimer.maximum());
+                    const std::vector<float> &window = gpuTimer.window();
+                    if (!window.empty())
+                        ImGui::PlotLines("##gputime", window.data(), int(window.size()), 0, nullptr, 0.0f, gpuTimer.maximum() * 1.2f, ImVec2(-1, 60));
+                    if (ImGui::Button("Reset"))
+                        gpuTimer.reset();
+                    ImGui::TreePop();
+                }
+                if (ImGui::TreeNode("Recording")) {
+                    static char output[512] = "recording";
+                    static int format = Recorder::PNG_SEQUENCE;
+                    static int frameCount = 240;
+                    static int framesPerSecond = 60;
+                    static int workerCount = 4;
+                    const char *formats[] = {"PNG sequence", "Y4M stream"};
+
+                    Recorder &recorder = Recorder::Instance();
+                    ImGui::PushItemWidth(-140);
+                    ImGui::InputText("Output Path", output, IM_ARRAYSIZE(output));
+                    ImGui::Combo("Format", &format, formats, IM_ARRAYSIZE(formats));
+                    ImGui::InputInt("Frames", &frameCount);
+                    ImGui::InputInt("Frames per second", &framesPerSecond);
+                    ImGui::SliderInt("Encoding threads", &workerCount, 1, 16);
+                    if (recorder.isRecording(renderView)) {
+                        ImGui::ProgressBar(float(recorder.writtenFrames()) / float(recorder.totalFrames()));
+                        if (ImGui::Button("Stop Recording"))
+                            recorder.stop();
+                    } else if (ImGui::Button("Start Recording")) {
+                        Recorder::Settings settings;
+                        settings.format = Recorder::Format(format);
+                        settings.output = output;
+                        settings.frameCount = frameCount;
+                        settings.framesPerSecond = framesPerSecond;
+                        settings.workerCount = workerCount;
+                        recorder.start(renderView, settings);
+                    }
+                    ImGui::PopItemWidth();
+                    ImGui::TreePop();
+                }
                 if (ImGui::TreeNode("Handles")) {
 
                     if (copyHandles.find(currIdx) != copyHandles.end()) {
                         // ImGui::Text("%s to %s , vec(%.1f,%.1f)", renderViews[currIdx]->name(), renderViews[copyHandles[currIdx]]->name(), temp.x, temp.y);
 
-                        mirrorHandles(renderView.getHandleManager(), renderViews[copyHandles[currIdx]].get().getHandleManager());
+                        if (mirrorHandles(renderView.getHandleManager(), renderViews[copyHandles[currIdx]].get().getHandleManager()))
+                            renderViews[copyHandles[currIdx]].get().requestRedraw();
                     }
-                    auto handleManager = renderView.getHandleManager();
-                    handleParser(handleManager);
+                    if (handleParser(renderView.getHandleManager()))
+                        renderView.requestRedraw();
                     ImGui::TreePop();
                 }
             }
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <string>
 
@@ -5,74 +6,133 @@
 #include "utils/pngwriter.h"
 #include <iostream>
 
-PNGWriter::PNGWriter(int width, int height, int channels, float *imageBuffer) : width(width), height(height), imageBuffer(imageBuffer), channels(channels) {
-
-    // this->imageBuffer = createMandelbrotImage(width, height, -0.802f, -0.177f, 0.011f, 110);
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PNGWRITER_SSE2
+#endif
+
+PNGWriter::PNGWriter(int width, int height, int channels, const float *imageBuffer, const Options &options)
+    : width(width), height(height), channels(channels), floatBuffer(imageBuffer), byteBuffer(nullptr), options(options) {}
+
+PNGWriter::PNGWriter(int width, int height, int channels, const unsigned char *imageBuffer, const Options &options)
+    : width(width), height(height), channels(channels), floatBuffer(nullptr), byteBuffer(imageBuffer), options(options) {}
+
+void PNGWriter::convertRow(const float *src, png_byte *dst, int count) {
+    int i = 0;
+#if defined(PNGWRITER_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+    // 16 values per iteration, cvtps rounds to nearest and the packs saturate to [0,255]
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), zero), one), scale));
+        __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), zero), one), scale));
+        __m128i c = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 8), zero), one), scale));
+        __m128i d = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 12), zero), one), scale));
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = png_byte(std::lrint(std::min(std::max(src[i], 0.0f), 1.0f) * 255.0f));
 }
 
 int PNGWriter::writePNG(const char *filename, char *imageTitle) {
-    png_byte color_type = channels == 4 ? PNG_COLOR_TYPE_RGBA : PNG_COLOR_TYPE_RGB;
+    png_byte color_type;
+    switch (channels) {
+    case 1:
+        color_type = PNG_COLOR_TYPE_GRAY;
+        break;
+    case 2:
+        color_type = PNG_COLOR_TYPE_GRAY_ALPHA;
+        break;
+    case 3:
+        color_type = PNG_COLOR_TYPE_RGB;
+        break;
+    case 4:
+        color_type = PNG_COLOR_TYPE_RGBA;
+        break;
+    default:
+        Qulkan::Logger::Error("[write_png_file] Unsupported number of channels %d\n", channels);
+        return -1;
+    }
     png_byte bit_depth = 8;
+    const std::size_t rowSize = std::size_t(width) * channels;
+
+    /* convert float images to one contiguous 8-bit buffer, byte images are written in place */
+    const png_byte *pixels = byteBuffer;
+    if (floatBuffer != nullptr) {
+        converted.resize(rowSize * height);
+#pragma omp parallel for schedule(static)
+        for (int y = 0; y < height; y++)
+            convertRow(floatBuffer + y * rowSize, converted.data() + y * rowSize, int(rowSize));
+        pixels = converted.data();
+    }
 
-    png_structp png_ptr;
-    png_infop info_ptr;
+    std::vector<png_bytep> rows(height);
+    for (int y = 0; y < height; y++) {
+        int srcRow = options.flipY ? (height - 1) - y : y;
+        rows[y] = const_cast<png_bytep>(pixels + srcRow * rowSize);
+    }
 
     /* create file */
     FILE *fp = fopen(filename, "wb");
-    if (!fp)
-        Qulkan::Logger::Error("[write_png_file] File %s could not be opened for writing", filename);
+    if (!fp) {
+        Qulkan::Logger::Error("[write_png_file] File %s could not be opened for writing\n", filename);
+        return -1;
+    }
 
     /* initialize stuff */
-    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-
-    if (!png_ptr)
-        Qulkan::Logger::Error("[write_png_file] png_create_write_struct failed");
+    png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (!png_ptr) {
+        Qulkan::Logger::Error("[write_png_file] png_create_write_struct failed\n");
+        fclose(fp);
+        return -1;
+    }
 
-    info_ptr = png_create_info_struct(png_ptr);
-    if (!info_ptr)
-        Qulkan::Logger::Error("[write_png_file] png_create_info_struct failed");
+    png_infop info_ptr = png_create_info_struct(png_ptr);
+    if (!info_ptr) {
+        Qulkan::Logger::Error("[write_png_file] png_create_info_struct failed\n");
+        png_destroy_write_struct(&png_ptr, NULL);
+        fclose(fp);
+        return -1;
+    }
 
-    if (setjmp(png_jmpbuf(png_ptr)))
-        Qulkan::Logger::Error("[write_png_file] Error during init_io");
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        Qulkan::Logger::Error("[write_png_file] Error while writing %s\n", filename);
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        fclose(fp);
+        return -1;
+    }
 
     png_init_io(png_ptr, fp);
 
-    /* write header */
-    if (setjmp(png_jmpbuf(png_ptr)))
-        Qulkan::Logger::Error("[write_png_file] Error during writing header");
+    png_set_compression_level(png_ptr, options.compressionLevel);
+    png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, options.filters);
 
+    /* write header */
     png_set_IHDR(png_ptr, info_ptr, width, height, bit_depth, color_type, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
 
+    if (imageTitle != nullptr) {
+        png_text title = {};
+        title.compression = PNG_TEXT_COMPRESSION_NONE;
+        title.key = const_cast<png_charp>("Title");
+        title.text = imageTitle;
+        png_set_text(png_ptr, info_ptr, &title, 1);
+    }
+
     png_write_info(png_ptr, info_ptr);
 
     /* write bytes */
-    if (setjmp(png_jmpbuf(png_ptr)))
-        Qulkan::Logger::Error("[write_png_file] Error during writing bytes");
-
-    // png_write_image(png_ptr, rows);
-    png_byte **rows = new png_byte *[height];
-    for (int i = 0; i < height; i++)
-        rows[i] = new png_byte[width * channels];
-
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            for (int c = 0; c < channels; c++) {
-                rows[y][x * channels + c] = imageBuffer[(((height-1)-y) * width + x) * channels + c] * 255.0f;   
-            }
-        }
-    }
-
-    png_write_image(png_ptr, rows);
+    png_write_image(png_ptr, rows.data());
 
     /* end write */
-    if (setjmp(png_jmpbuf(png_ptr)))
-        Qulkan::Logger::Error("[write_png_file] Error during end of write");
-
     png_write_end(png_ptr, NULL);
+    png_destroy_write_struct(&png_ptr, &info_ptr);
 
     Qulkan::Logger::Info("PNGWriter: Wrote png file to %s \n", filename);
 
     fclose(fp);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -22,8 +22,8 @@ namespace Qulkan::Vulkan {
         renderPass = VKHelper::RenderPassFactory::createRenderPass<SimpleRenderPass>(aDevice, SimpleRenderPass{aDevice, aFormat});
         VK_CHECK_NOT_NULL(renderPass);
         VKHelper::PipelineInfo info =
-            VKHelper::PipelineFactory::createGraphicPipeline<ColoredVertex, SimplePipeline>(aDevice, ColoredVertex{}, SimplePipeline{anExtent},
-                                                                                            renderPass); // @TODO: ugly...
+            VKHelper::PipelineFactory::createGraphicPipeline<VKHelper::ReflectedVertexFormat<ColoredVertex>, SimplePipeline>(
+                aDevice, VKHelper::ReflectedVertexFormat<ColoredVertex>{}, SimplePipeline{anExtent}, renderPass);
         pipeline = info.pipeline;
         pipelineLayout = info.layout;
         VK_CHECK_NOT_NULL(pipeline);